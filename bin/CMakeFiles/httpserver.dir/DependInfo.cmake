@@ -0,0 +1,40 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/asyncdb.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/asyncdb.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/asyncdb.cpp.o.d"
+  "/root/repo/src/backend.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/backend.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/backend.cpp.o.d"
+  "/root/repo/src/body.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/body.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/body.cpp.o.d"
+  "/root/repo/src/buffer.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/buffer.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/buffer.cpp.o.d"
+  "/root/repo/src/common.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/common.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/common.cpp.o.d"
+  "/root/repo/src/connslab.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/connslab.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/connslab.cpp.o.d"
+  "/root/repo/src/credential.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/credential.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/credential.cpp.o.d"
+  "/root/repo/src/filecache.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/filecache.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/filecache.cpp.o.d"
+  "/root/repo/src/governor.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/governor.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/governor.cpp.o.d"
+  "/root/repo/src/http.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/http.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/http.cpp.o.d"
+  "/root/repo/src/log.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/log.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/log.cpp.o.d"
+  "/root/repo/src/main.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/main.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/main.cpp.o.d"
+  "/root/repo/src/mysqlpool.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/mysqlpool.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/mysqlpool.cpp.o.d"
+  "/root/repo/src/outqueue.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/outqueue.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/outqueue.cpp.o.d"
+  "/root/repo/src/range.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/range.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/range.cpp.o.d"
+  "/root/repo/src/reactor.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/reactor.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/reactor.cpp.o.d"
+  "/root/repo/src/response.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/response.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/response.cpp.o.d"
+  "/root/repo/src/router.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/router.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/router.cpp.o.d"
+  "/root/repo/src/stmtcache.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/stmtcache.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/stmtcache.cpp.o.d"
+  "/root/repo/src/timerwheel.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/timerwheel.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/timerwheel.cpp.o.d"
+  "/root/repo/src/tokenizer.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/tokenizer.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/tokenizer.cpp.o.d"
+  "/root/repo/src/uring.cpp" "/root/repo/bin/CMakeFiles/httpserver.dir/uring.cpp.o" "gcc" "/root/repo/bin/CMakeFiles/httpserver.dir/uring.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
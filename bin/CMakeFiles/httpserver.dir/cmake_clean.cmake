@@ -0,0 +1,53 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/httpserver.dir/asyncdb.cpp.o"
+  "CMakeFiles/httpserver.dir/asyncdb.cpp.o.d"
+  "CMakeFiles/httpserver.dir/backend.cpp.o"
+  "CMakeFiles/httpserver.dir/backend.cpp.o.d"
+  "CMakeFiles/httpserver.dir/body.cpp.o"
+  "CMakeFiles/httpserver.dir/body.cpp.o.d"
+  "CMakeFiles/httpserver.dir/buffer.cpp.o"
+  "CMakeFiles/httpserver.dir/buffer.cpp.o.d"
+  "CMakeFiles/httpserver.dir/common.cpp.o"
+  "CMakeFiles/httpserver.dir/common.cpp.o.d"
+  "CMakeFiles/httpserver.dir/connslab.cpp.o"
+  "CMakeFiles/httpserver.dir/connslab.cpp.o.d"
+  "CMakeFiles/httpserver.dir/credential.cpp.o"
+  "CMakeFiles/httpserver.dir/credential.cpp.o.d"
+  "CMakeFiles/httpserver.dir/filecache.cpp.o"
+  "CMakeFiles/httpserver.dir/filecache.cpp.o.d"
+  "CMakeFiles/httpserver.dir/governor.cpp.o"
+  "CMakeFiles/httpserver.dir/governor.cpp.o.d"
+  "CMakeFiles/httpserver.dir/http.cpp.o"
+  "CMakeFiles/httpserver.dir/http.cpp.o.d"
+  "CMakeFiles/httpserver.dir/log.cpp.o"
+  "CMakeFiles/httpserver.dir/log.cpp.o.d"
+  "CMakeFiles/httpserver.dir/main.cpp.o"
+  "CMakeFiles/httpserver.dir/main.cpp.o.d"
+  "CMakeFiles/httpserver.dir/mysqlpool.cpp.o"
+  "CMakeFiles/httpserver.dir/mysqlpool.cpp.o.d"
+  "CMakeFiles/httpserver.dir/outqueue.cpp.o"
+  "CMakeFiles/httpserver.dir/outqueue.cpp.o.d"
+  "CMakeFiles/httpserver.dir/range.cpp.o"
+  "CMakeFiles/httpserver.dir/range.cpp.o.d"
+  "CMakeFiles/httpserver.dir/reactor.cpp.o"
+  "CMakeFiles/httpserver.dir/reactor.cpp.o.d"
+  "CMakeFiles/httpserver.dir/response.cpp.o"
+  "CMakeFiles/httpserver.dir/response.cpp.o.d"
+  "CMakeFiles/httpserver.dir/router.cpp.o"
+  "CMakeFiles/httpserver.dir/router.cpp.o.d"
+  "CMakeFiles/httpserver.dir/stmtcache.cpp.o"
+  "CMakeFiles/httpserver.dir/stmtcache.cpp.o.d"
+  "CMakeFiles/httpserver.dir/timerwheel.cpp.o"
+  "CMakeFiles/httpserver.dir/timerwheel.cpp.o.d"
+  "CMakeFiles/httpserver.dir/tokenizer.cpp.o"
+  "CMakeFiles/httpserver.dir/tokenizer.cpp.o.d"
+  "CMakeFiles/httpserver.dir/uring.cpp.o"
+  "CMakeFiles/httpserver.dir/uring.cpp.o.d"
+  "httpserver"
+  "httpserver.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/httpserver.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/precompress.dir/precompress.cpp.o"
+  "CMakeFiles/precompress.dir/precompress.cpp.o.d"
+  "precompress"
+  "precompress.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/precompress.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
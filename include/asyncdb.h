@@ -0,0 +1,176 @@
+#ifndef __ASYNCDB_H__
+#define __ASYNCDB_H__
+
+/**
+ * 作用: 每个 reactor 一组非阻塞的 mysql 连接，查询不占用线程
+ *      使用 MariaDB 客户端的非阻塞接口(mysql_real_connect_start、mysql_real_query_start、
+ *      mysql_store_result_start 和对应的 _cont)，库需要等待时返回等待的事件，连接的套接字通过
+ *      EventBackend::watch 注册到 reactor 的事件后端，就绪后在事件循环中继续执行
+ *      查询先排队，空闲的连接依次取出执行，一个连接同时只执行一个查询，结果集完整读入后调用回调
+ *      库要求的超时、查询的超时和重新连接由本对象自己的时间轮管理，reactor 按它的 nextTimeout 等待
+ *      连接断开或查询超时时关闭连接，ASYNC_DB_RECONNECT_MS 后重新连接
+ *      只在所属 reactor 线程中使用，不加锁；客户端库没有非阻塞接口(编译时没有 HAVE_MYSQL_NONBLOCK)时 init 返回 false
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mysql/mysql.h>
+
+#include "macro.h"
+#include "backend.h"
+#include "timerwheel.h"
+
+/* 一次异步查询，由 AsyncDb 分配和回收，回调返回后不能再使用 */
+struct AsyncQuery {
+    // 查询结束的回调，成功和失败都会调用一次，取消的查询不调用
+    typedef void (*Callback)(AsyncQuery *query, void *arg);
+
+    std::string m_sql;
+    Callback    m_callback;         // 为 nullptr 表示已经取消
+    void        *m_arg;
+    uint64_t    m_deadline;         // 超过这个时间(毫秒)还没有结果时失败
+
+    /* 结果，只在回调中有效 */
+    int         m_errno;            // 0 表示成功，否则为 mysql 的错误码或 AsyncDb::ERROR
+    std::string m_error;
+    MYSQL_RES   *m_result;          // 有结果集的语句的结果，回调返回后释放
+    uint64_t    m_affected_rows;    // 没有结果集的语句影响的行数
+
+    AsyncQuery  *m_next;            // 排队或空闲链表
+};
+
+class AsyncDb {
+public:
+    /* 不是来自 mysql 的错误码 */
+    enum ERROR {
+        ERROR_TIMEOUT=-1,           // 在 ASYNC_DB_QUERY_TIMEOUT 内没有结果
+        ERROR_DISCONNECTED=-2       // 执行中连接断开
+    };
+
+private:
+    enum STATE {
+        STATE_DOWN=0,               // 没有连接，等待重新连接
+        STATE_CONNECTING,
+        STATE_IDLE,
+        STATE_QUERY,                // mysql_real_query
+        STATE_STORE                 // mysql_store_result
+    };
+
+    /* 一个非阻塞连接 */
+    struct Conn {
+        MYSQL       *m_sql;
+        STATE       m_state;
+        int         m_fd;           // 已经 watch 的套接字，-1 表示没有
+        bool        m_waiting;      // 在等待套接字就绪
+        uint64_t    m_lib_expire;   // 库要求的超时时间，0 表示没有
+        uint64_t    m_connect_expire;   // 连接的超时时间
+        AsyncQuery  *m_query;       // 正在执行的查询
+        TimerNode   m_timer;        // 库的超时、查询的超时或者重新连接，m_data 指向自己
+
+        /* 非阻塞接口各阶段的返回值 */
+        MYSQL       *m_connect_ret;
+        int         m_query_ret;
+        MYSQL_RES   *m_store_ret;
+    };
+
+    EventBackend        *m_backend;
+    TimerWheel          m_timer;
+    TimerNode           m_queue_timer;  // 队首查询的超时，m_data 为 nullptr
+    std::vector<Conn>   m_conns;
+
+    std::string         m_host;
+    int                 m_port;
+    std::string         m_user;
+    std::string         m_passwd;
+    std::string         m_db;
+    int                 m_timeout;      // 查询的超时时间(毫秒)
+    int                 m_close_log;
+
+    AsyncQuery          *m_head;        // 排队的查询，按超时时间的先后
+    AsyncQuery          *m_tail;
+    AsyncQuery          *m_free;        // 回收的查询对象
+    int                 m_pending;      // 排队的查询数，包括已经取消还没有出队的
+    int                 m_running;      // 正在执行的查询数
+    int                 m_up;           // 已经连上的连接数
+    uint64_t            m_now;
+
+private:
+    // 开始连接，失败时安排重新连接
+    void connect(Conn *c);
+    // 关闭连接，正在执行的查询以 error 失败，delay 毫秒后重新连接
+    void disconnect(Conn *c, int error, const char *reason, int delay);
+    void execute(Conn *c, AsyncQuery *query);
+    // 库返回了 status，为 0 时当前阶段完成，否则等待套接字或超时
+    void step(Conn *c, int status);
+    // 当前阶段完成
+    void finishPhase(Conn *c);
+    // 连接空闲，等待下一个查询
+    void idle(Conn *c);
+    // 连接上的查询结束，error 不为 0 时 message 为错误信息
+    void endQuery(Conn *c, int error, const char *message);
+    // 查询出错，客户端错误(连接不可用)时断开连接
+    void queryError(Conn *c);
+    // 调用回调后回收
+    void complete(AsyncQuery *query);
+    // 按库的超时和查询的超时设置连接的定时器
+    void armTimer(Conn *c);
+    void armQueueTimer();
+    void handleTimer(TimerNode *node);
+
+    AsyncQuery *allocQuery();
+    void freeQuery(AsyncQuery *query);
+
+    /* 非阻塞接口，按连接的状态调用对应的函数 */
+    int startPhase(Conn *c);
+    int continuePhase(Conn *c, int status);
+    // 连接的套接字和库要求的超时(毫秒)
+    int socketOf(Conn *c);
+    unsigned int libTimeout(Conn *c);
+
+    static void timerCallback(TimerNode *node, void *arg) {
+        ((AsyncDb *)arg)->handleTimer(node);
+    }
+
+public:
+    AsyncDb();
+    ~AsyncDb();
+
+    AsyncDb(const AsyncDb &) = delete;
+    AsyncDb &operator=(const AsyncDb &) = delete;
+
+    // 在 reactor 线程中初始化并开始连接，conn_num 为连接数，timeout_ms 为查询的超时时间
+    bool init(EventBackend *backend, const std::string &host, int port, const std::string &user, \
+              const std::string &passwd, const std::string &db, int conn_num=ASYNC_DB_CONNS, \
+              int timeout_ms=ASYNC_DB_QUERY_TIMEOUT, int close_log=0);
+
+    // 提交一个查询，结果到达、出错或超时时在本线程调用 callback
+    // 查询只排队，在 reactor 处理完本轮事件后调用的 advance 中开始执行，callback 不会在 query 返回之前调用
+    // 没有连上的连接或者排队的查询已满时返回 nullptr，不调用 callback
+    AsyncQuery *query(const char *sql, int len, AsyncQuery::Callback callback, void *arg);
+    // 取消查询，之后不会调用它的回调；已经发给 mysql 的查询继续执行，结果被丢弃
+    void cancel(AsyncQuery *query);
+
+    // reactor 收到 EVENT_POLL 时调用，不是本对象的描述符时返回 false
+    bool handleEvent(int fd, int events);
+    // 距离下一个定时器到期的毫秒数，没有时返回 -1
+    int nextTimeout(uint64_t now_ms) { return m_timer.nextTimeout(now_ms); }
+    // 推进时间，处理到期的定时器，然后在空闲的连接上执行排队的查询，reactor 每轮事件循环调用一次
+    void advance(uint64_t now_ms);
+    // 在空闲的连接上执行排队的查询
+    void dispatch();
+
+    // 排队的、正在执行的查询数和已经连上的连接数
+    int pending() const { return m_pending; }
+    int running() const { return m_running; }
+    int connected() const { return m_up; }
+
+    // 当前 reactor 线程的 AsyncDb，其它线程(例如工作线程)为 nullptr
+    static AsyncDb *local() { return s_local; }
+    static void setLocal(AsyncDb *db) { s_local = db; }
+
+private:
+    static thread_local AsyncDb *s_local;
+};
+
+#endif // __ASYNCDB_H__
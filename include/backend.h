@@ -0,0 +1,122 @@
+#ifndef __BACKEND_H__
+#define __BACKEND_H__
+
+/**
+ * 作用: reactor 的事件后端
+ *      reactor 和 HttpConn 只通过 EventBackend 注册连接、重新等待读、发送输出队列和关闭连接，
+ *      不再直接调用 epoll_ctl，启动时选择 epoll 或 io_uring 实现
+ *      epoll 后端通知可读可写，由连接自己 recv 和 sendmsg/sendfile；
+ *      io_uring 后端直接交给连接已经收到的数据，发送也由内核异步完成，完成后才通知 reactor
+ *      读事件沿用 EPOLLONESHOT 的语义：一个读事件交给连接以后，连接调用 armRead 之前不会再有读事件
+ *      不属于连接的描述符(例如 mysql 的套接字)用 watch 等待一次可读或可写，同样是一次性的
+ */
+
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <atomic>
+#include <vector>
+
+#include "outqueue.h"
+#include "macro.h"
+
+/* 后端交给 reactor 的事件 */
+struct BackendEvent {
+    enum TYPE {
+        EVENT_ACCEPT,           // 新连接，m_fd 为 -1 时需要 reactor 自己 accept
+        EVENT_READ,             // 连接有数据，m_data 为 nullptr 时需要连接自己 recv
+        EVENT_WRITE,            // 输出队列可以继续发送，或者已经异步发送完
+        EVENT_PROGRESS,         // 异步发送有进展但还没有发完，只用来刷新连接的活动时间
+        EVENT_CLOSE,            // 对端关闭或出错
+        EVENT_WAKEUP,           // 其它线程通过 eventfd 唤醒
+        EVENT_POLL              // watch 的描述符就绪，m_len 为就绪的 POLLIN/POLLOUT/POLLERR/POLLHUP
+    };
+
+    TYPE        m_type;
+    int         m_fd;
+    const char  *m_data;        // 后端已经收到的数据，连接用完后调用 release
+    int         m_len;
+    int         m_buf;          // 数据所在的后端缓冲区，由后端使用
+};
+
+class EventBackend {
+public:
+    enum TYPE {
+        BACKEND_AUTO=0,         // 内核支持时使用 io_uring，否则使用 epoll
+        BACKEND_EPOLL,
+        BACKEND_URING
+    };
+
+public:
+    EventBackend() : m_uploads(0) {}
+    virtual ~EventBackend() {}
+
+    // 占用一个上传名额，这个 reactor 已经有 UPLOAD_MAX_PER_LOOP 个上传时返回 false，
+    // 可能在工作线程中调用，上传结束或中止时调用 endUpload 归还
+    bool beginUpload() {
+        if (m_uploads.fetch_add(1, std::memory_order_relaxed) < UPLOAD_MAX_PER_LOOP)
+            return true;
+        m_uploads.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    void endUpload() { m_uploads.fetch_sub(1, std::memory_order_relaxed); }
+
+    // 后端的名字，用于日志
+    virtual const char *name() const = 0;
+    // 在运行事件循环的线程中初始化，listenfd 和 wakeupfd 由 reactor 创建
+    virtual bool init(int listenfd, int wakeupfd) = 0;
+    // 提交积累的操作并等待事件，timeout 为毫秒，-1 表示一直等待，返回事件数，出错时返回 -1
+    virtual int wait(BackendEvent *events, int max, int timeout) = 0;
+
+    // 开始接收新连接的数据
+    virtual void addConn(int fd) = 0;
+    // 连接处理完已有的数据，等待下一个读事件
+    virtual void armRead(int fd) = 0;
+    // 读事件的数据被连接使用了 used 字节，剩余的数据在连接下一次 armRead 后重新产生读事件
+    virtual void release(const BackendEvent &event, int used) = 0;
+    // 发送输出队列，返回 -1 出错，0 没有发完，之后会产生 EVENT_WRITE，1 已经全部发送
+    virtual int send(int fd, OutputQueue *queue) = 0;
+    // 停止接收并关闭描述符，之后不会再有这个连接的事件
+    virtual void removeConn(int fd) = 0;
+    // 暂停或恢复 accept，暂停期间新连接留在监听套接字的 backlog 中
+    // 已经在后端中 accept 的连接仍然会产生 EVENT_ACCEPT
+    virtual void pauseAccept(bool pause) = 0;
+
+    // 等待一个不属于连接的描述符就绪，events 为 POLLIN/POLLOUT 的组合，产生一次 EVENT_POLL 后需要重新 watch，
+    // 再次 watch 时替换之前的等待
+    virtual void watch(int fd, int events) = 0;
+    // 停止等待，之后不会再有这个描述符的 EVENT_POLL，描述符由调用者在此之后关闭
+    virtual void unwatch(int fd) = 0;
+
+private:
+    std::atomic<int>    m_uploads;      // 正在接收的上传数，上传的请求体在 reactor 线程中阻塞写盘
+};
+
+/* epoll 实现，连接使用 EPOLLONESHOT，TRIGMode 为 1 时使用 ET 模式 */
+class EpollBackend : public EventBackend {
+public:
+    EpollBackend(int TRIGMode=1);
+    ~EpollBackend();
+
+    const char *name() const { return "epoll"; }
+    bool init(int listenfd, int wakeupfd);
+    int wait(BackendEvent *events, int max, int timeout);
+
+    void addConn(int fd);
+    void armRead(int fd);
+    void release(const BackendEvent &, int) {}
+    int send(int fd, OutputQueue *queue);
+    void removeConn(int fd);
+    void pauseAccept(bool pause);
+    void watch(int fd, int events);
+    void unwatch(int fd);
+
+private:
+    int             m_epollfd;
+    int             m_listenfd;
+    int             m_wakeupfd;
+    int             m_TRIGMode;
+    std::vector<char>   m_watched;  // 按 fd 下标，描述符是否由 watch 加入 epoll
+    epoll_event     m_events[MAX_EVENT_NUMBER];
+};
+
+#endif // __BACKEND_H__
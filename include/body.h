@@ -0,0 +1,76 @@
+#ifndef __BODY_H__
+#define __BODY_H__
+
+/**
+ * 作用: 流式接收请求体
+ *      请求体不再整个缓存在读缓冲区中，到达一块就交给 BodyHandler 处理一块，
+ *      读缓冲区只需要一个段反复使用，内存占用与请求体大小无关
+ *      FileBodySink 把请求体写入目标目录下的临时文件，接收完后改名为目标文件，
+ *      读缓冲区中没有剩余数据时用 splice 经过管道把 socket 中的数据直接移到文件，不经过用户态
+ *      写文件是阻塞的，在 reactor 线程中执行，每个 reactor 同时接收的上传数由 UPLOAD_MAX_PER_LOOP 限制
+ */
+
+#include <sys/types.h>
+#include <stdint.h>
+
+class BodyHandler {
+public:
+    virtual ~BodyHandler() {}
+
+    // 开始接收长度为 length 的请求体，返回 false 表示拒绝
+    virtual bool onBegin(uint64_t length) { return true; }
+    // 收到一块请求体，返回 false 表示出错
+    virtual bool onData(const char *data, size_t len) = 0;
+    // 请求体接收完毕，返回 false 表示出错
+    virtual bool onEnd() { return true; }
+    // 请求体没有接收完连接就关闭或者出错
+    virtual void onAbort() {}
+
+    // 直接从 socket 接收最多 len 字节，返回接收的字节数，0 表示对方已关闭，-1 出错(errno 为 EAGAIN 表示暂无数据)，
+    // 返回 -2 表示不支持，由调用者读到缓冲区后调用 onData
+    virtual ssize_t receive(int sockfd, size_t len) { return -2; }
+};
+
+/* 丢弃请求体，用于不需要请求体但请求体过大的请求 */
+class DiscardBody : public BodyHandler {
+public:
+    bool onData(const char *data, size_t len) override { return true; }
+};
+
+/* 把请求体写入文件 */
+class FileBodySink : public BodyHandler {
+public:
+    static const int PATH_LEN = 256;
+
+private:
+    int         m_fd;               // 临时文件
+    int         m_pipe[2];          // splice 使用的管道，第一次 splice 时创建
+    uint64_t    m_written;          // 已写入的字节数
+    const char  *m_path;            // 目标文件，由调用者保存，接收完之前必须有效
+    char        m_tmp[PATH_LEN];    // 临时文件，与目标文件在同一目录，改名是原子的
+    int         m_close_log;        // 是否关闭日志
+
+public:
+    FileBodySink();
+    ~FileBodySink();
+
+    // 设置是否关闭日志
+    void init(int close_log) { m_close_log = close_log; }
+
+    // 在 path 所在的目录创建临时文件，失败时返回 false，errno 为失败原因，path 在 onEnd 之前必须有效
+    bool open(const char *path);
+
+    bool onData(const char *data, size_t len) override;
+    bool onEnd() override;
+    void onAbort() override;
+    ssize_t receive(int sockfd, size_t len) override;
+
+    // 已写入的字节数
+    uint64_t written() const { return m_written; }
+
+private:
+    // 关闭文件和管道
+    void close();
+};
+
+#endif // __BODY_H__
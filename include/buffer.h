@@ -0,0 +1,56 @@
+#ifndef __BUFFER_H__
+#define __BUFFER_H__
+
+/**
+ * 作用: 固定大小的缓冲区段以及进程共享的段内存池
+ *      HttpConn 的读缓冲区由若干段串成链表，按需增长，连接空闲时把段还给内存池，
+ *      空闲的连接不占用缓冲区内存
+ *      每个线程另外缓存 SEGMENT_LOCAL_CACHE 个空闲段，在同一个线程中周转的段不需要加锁
+ */
+
+#include <stddef.h>
+
+#include "locker.h"
+#include "macro.h"
+
+/* 一个缓冲区段 */
+struct BufferSegment {
+    BufferSegment   *m_next;                        // 链表中的下一段
+    char            m_data[BUFFER_SEGMENT_SIZE];    // 数据
+};
+
+class SegmentPool {
+private:
+    locker          m_mutex;        // 保护空闲链表
+    BufferSegment   *m_free;        // 空闲链表
+    size_t          m_free_count;   // 空闲段的个数
+    size_t          m_max_free;     // 最多保留的空闲段，超过的直接释放
+
+private:
+    SegmentPool();
+    ~SegmentPool();
+
+public:
+    // 单例模式
+    static SegmentPool *get() {
+        static SegmentPool pool;
+        return &pool;
+    }
+
+    // 设置最多保留的空闲段个数
+    void init(size_t max_free=SEGMENT_POOL_MAX_FREE);
+
+    // 取出一个段，空闲链表为空时新分配，返回的段 m_next 为 nullptr
+    BufferSegment *alloc();
+    // 归还一个段
+    void free(BufferSegment *seg);
+    // 不经过线程的缓存，直接还给共享的空闲链表
+    void freeShared(BufferSegment *seg);
+    // 归还从 head 开始到 end(不含)为止的整条链表
+    void freeChain(BufferSegment *head, BufferSegment *end=nullptr);
+
+    // 空闲段的个数，包括当前线程缓存的
+    size_t freeCount();
+};
+
+#endif // __BUFFER_H__
@@ -0,0 +1,46 @@
+#ifndef __CONNSLAB_H__
+#define __CONNSLAB_H__
+
+/**
+ * 作用: 按 fd 下标的连接对象槽
+ *      启动时一次性用 mmap 预留 capacity 个 HttpConn 的地址空间，之后不再 new/delete 连接对象
+ *      槽位在对应的 fd 第一次被 accept 时才原地构造，此后同一个 fd 的连接一直复用这个对象，
+ *      没有用过的 fd 不会触碰对应的内存页，常驻内存只和实际出现过的最大并发连接数有关
+ *      对象按缓存行对齐，HttpConn 的热字段集中在对象开头的缓存行中
+ *      fd 在进程内唯一，同一时刻一个槽位只属于一个 reactor，构造标记用 release/acquire 发布给之后复用该 fd 的线程
+ */
+
+#include <atomic>
+
+#include "http.h"
+
+class ConnSlab {
+public:
+    ConnSlab();
+    ~ConnSlab();
+
+    ConnSlab(const ConnSlab &) = delete;
+    ConnSlab &operator=(const ConnSlab &) = delete;
+
+public:
+    // 预留 capacity 个连接对象的地址空间，失败时返回 false
+    bool init(int capacity=MAX_FD);
+    // fd 对应的连接对象，第一次使用时在槽位上构造，fd 超出范围时返回 nullptr
+    HttpConn *acquire(int fd);
+    // fd 对应的连接对象，超出范围或者还没有构造过时返回 nullptr
+    HttpConn *get(int fd) {
+        if (fd < 0 || fd >= m_capacity || !m_built[fd].load(std::memory_order_acquire))
+            return nullptr;
+        return m_conns + fd;
+    }
+    // 槽位数
+    int capacity() const { return m_capacity; }
+
+private:
+    HttpConn            *m_conns;       // mmap 得到的槽位数组，按页对齐
+    size_t              m_size;         // 映射的字节数
+    std::atomic<bool>   *m_built;       // 槽位上的对象是否已经构造
+    int                 m_capacity;
+};
+
+#endif // __CONNSLAB_H__
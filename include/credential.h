@@ -0,0 +1,125 @@
+#ifndef __CREDENTIAL_H__
+#define __CREDENTIAL_H__
+
+/**
+ * 作用: 进程共享的用户名和密码表，读多写少
+ *      所有用户放在一个不可变的快照中：开放寻址(线性探测)的哈希表，用户名和密码连续存放在一块内存里，
+ *      更新时复制出新的快照，用一次原子交换发布，旧快照等所有可能读到它的线程离开后再释放(RCU)
+ *      读者只在自己的分片上加减一个计数，不加锁，不同线程的计数在不同的缓存行上
+ *      写者之间用互斥锁串行，发布后翻转纪元，等旧纪元的读者计数归零后释放旧快照
+ *      从 mysql 刷新时读出整个用户表，与当前快照比较，没有变化时不发布
+ */
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "locker.h"
+#include "macro.h"
+
+class MysqlPool;
+
+class CredentialStore {
+public:
+    typedef std::vector<std::pair<std::string, std::string> > UserList;
+
+private:
+    /* 哈希表的一个槽，m_hash 为 0 表示空槽 */
+    struct Slot {
+        uint32_t    m_hash;
+        uint32_t    m_offset;       // 用户名在 m_arena 中的偏移，密码紧跟在用户名后面
+        uint16_t    m_user_len;
+        uint16_t    m_passwd_len;
+    };
+
+    /* 不可变的快照 */
+    struct Snapshot {
+        uint32_t    m_mask;         // 槽数减一，槽数是 2 的幂
+        uint32_t    m_count;        // 用户数
+        uint64_t    m_version;      // 每发布一次加一
+        Slot        *m_slots;
+        char        *m_arena;
+
+        Snapshot() : m_mask(0), m_count(0), m_version(0), m_slots(nullptr), m_arena(nullptr) {}
+        ~Snapshot() {
+            delete [] m_slots;
+            delete [] m_arena;
+        }
+
+        // 查找用户名，没有时返回 nullptr
+        const Slot *find(const char *user, int len, uint32_t hash) const;
+    };
+
+    /* 每个分片上正在读的线程数，按纪元的奇偶分成两个计数 */
+    struct alignas(CACHE_LINE_SIZE) ReaderShard {
+        std::atomic<long>   m_active[2];
+    };
+
+    std::atomic<Snapshot *> m_current;
+    std::atomic<uint64_t>   m_epoch;
+    mutable ReaderShard     m_readers[CREDENTIAL_READER_SHARDS];
+    locker                  m_write_mutex;      // 发布新快照的写者串行
+
+    /* 后台刷新 */
+    MysqlPool   *m_pool;
+    int         m_refresh_ms;
+    pthread_t   m_tid;
+    int         m_close_log;
+
+private:
+    CredentialStore();
+    ~CredentialStore();
+
+    static uint32_t hash(const char *data, int len);
+    // 由用户列表生成快照，重复的用户名保留最后一个，超长的用户名或密码被跳过
+    static Snapshot *build(const UserList &users);
+    // 把快照中的所有用户导出到列表
+    static void dump(const Snapshot *snapshot, UserList *users);
+
+    // 读者进入，返回当前快照，shard 和 parity 交给 leave
+    const Snapshot *enter(int *shard, int *parity) const;
+    void leave(int shard, int parity) const;
+    // 发布新快照，等待旧快照的读者离开后释放旧快照，调用者持有 m_write_mutex
+    void publish(Snapshot *next);
+    // 翻转纪元并等待旧纪元的读者都离开
+    void synchronize();
+
+    // 后台刷新线程
+    void refreshLoop();
+    static void *refreshThreadRun(void *) {
+        CredentialStore::get()->refreshLoop();
+        return (void *)nullptr;
+    }
+
+public:
+    // 单例模式
+    static CredentialStore *get() {
+        static CredentialStore store;
+        return &store;
+    }
+
+    // 用户名和密码是否匹配，密码按固定时间比较，不加锁
+    bool verify(const char *user, int user_len, const char *passwd, int passwd_len) const;
+    // 用户名是否存在，不加锁
+    bool contains(const char *user, int len) const;
+    // 用户数和当前快照的版本
+    size_t size() const;
+    uint64_t version() const;
+
+    // 用整个列表替换所有用户
+    void load(const UserList &users);
+    // 增加或修改一个用户，复制出新的快照后发布，例如注册成功后立即生效，不需要等下一次刷新
+    bool upsert(const std::string &user, const std::string &passwd);
+    // 删除一个用户
+    bool remove(const std::string &user);
+
+    // 从 mysql 的 user 表读取所有用户，与当前快照不同时发布，返回变化的用户数，失败时返回 -1
+    int refresh(MysqlPool *pool);
+    // 启动后台线程，每 interval_ms 毫秒刷新一次
+    bool startRefresh(MysqlPool *pool, int interval_ms=CREDENTIAL_REFRESH_MS, int close_log=0);
+};
+
+#endif // __CREDENTIAL_H__
@@ -0,0 +1,136 @@
+#ifndef __FILECACHE_H__
+#define __FILECACHE_H__
+
+/**
+ * 作用: 进程共享的静态文件缓存
+ *      以解析后的完整路径为键，缓存文件描述符、stat 信息以及小文件的 mmap 映射，
+ *      避免热点文件每个请求都重复 stat/open/mmap/munmap
+ *      按字节预算做 LRU 淘汰，文件被修改、删除或替换时由 inotify 线程使其失效
+ *      HttpConn 通过 acquire 得到带引用计数的 FileEntry，用完后 release，
+ *      缓存淘汰时只会放弃自己持有的引用，正在发送中的文件不受影响
+ *      打开文件时按 inode、大小和修改时间生成 ETag 并格式化 Last-Modified，条件请求直接比较，
+ *      同时记录同目录下不比它旧的 .br/.gz 预压缩版本，HttpConn 按 Accept-Encoding 选择，
+ *      并按扩展名确定 Content-Type
+ */
+
+#include <sys/stat.h>
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "locker.h"
+#include "macro.h"
+
+/* 预压缩的版本，可以按位组合 */
+enum FILE_VARIANT {
+    VARIANT_NONE=0,             // 原文件
+    VARIANT_BR=1,               // 路径加 .br 的 brotli 压缩版本
+    VARIANT_GZIP=2              // 路径加 .gz 的 gzip 压缩版本
+};
+
+/* 缓存中的一个文件 */
+struct FileEntry {
+    static const int VALIDATORS_LEN = 128;  // 预先格式化的验证器响应头的最大长度
+
+    std::string         m_path;         // 完整路径，也是缓存的键
+    int                 m_fd;           // 文件描述符，sendfile 使用显式偏移，可以多个连接共享
+    struct stat         m_stat;         // 文件信息
+    char                *m_address;     // 小文件的 mmap 地址，大文件为 nullptr
+    char                m_validators[VALIDATORS_LEN];  // "Last-Modified: ...\r\nETag: \"...\"\r\n"
+    int                 m_validators_len;
+    const char          *m_last_modified;  // 指向 m_validators 中的日期，长度为 HttpDate::DATE_LEN
+    const char          *m_etag;        // 指向 m_validators 中带引号的 ETag
+    int                 m_etag_len;
+    int                 m_variants;     // 存在的预压缩版本，FILE_VARIANT 的组合
+    const char          *m_mime;        // 按扩展名得到的 Content-Type，不认识的扩展名为 application/octet-stream
+    int                 m_wd;           // inotify 监视描述符，未被缓存时为 -1
+    size_t              m_charge;       // 计入字节预算的大小
+    std::atomic<int>    m_refs;         // 引用计数，缓存本身持有一个
+    FileEntry           *m_prev;        // LRU 链表
+    FileEntry           *m_next;
+};
+
+class FileCache {
+private:
+    static const int SHARD_NUM = 16;    // 分片数量，降低多个 reactor 同时查找时的锁竞争
+
+    /* 一个分片，拥有独立的锁、哈希表和 LRU 链表 */
+    struct Shard {
+        locker                                          m_mutex;
+        std::unordered_map<std::string_view, FileEntry *> m_map;      // 键指向 entry 中的 m_path
+        FileEntry                                       *m_head;      // 最近使用
+        FileEntry                                       *m_tail;      // 最久未使用
+        size_t                                          m_bytes;      // 已使用的字节数
+        size_t                                          m_count;      // 缓存的文件个数
+    };
+
+    Shard                                   m_shards[SHARD_NUM];
+    size_t                                  m_shard_bytes;      // 每个分片的字节预算
+    size_t                                  m_shard_count;      // 每个分片的最大文件数
+    int                                     m_inotifyfd;        // inotify 描述符，-1 表示未启用缓存
+    pthread_t                               m_tid;              // inotify 处理线程
+
+    locker                                  m_watch_mutex;      // 保护 m_watches
+    std::unordered_multimap<int, std::string> m_watches;        // 监视描述符到缓存路径
+
+    int                                     m_close_log;        // 是否关闭日志
+
+private:
+    FileCache();
+    ~FileCache();
+
+    // 打开文件并创建一个未缓存的 entry，失败时返回 nullptr 并设置 error
+    FileEntry *openEntry(const char *path, int *error);
+    // 释放 entry 占用的资源
+    static void destroyEntry(FileEntry *entry);
+    // 计算路径所在的分片
+    Shard *shardOf(std::string_view path);
+
+    /* LRU 链表操作，调用者持有分片锁 */
+    void lruUnlink(Shard *shard, FileEntry *entry);
+    void lruPushFront(Shard *shard, FileEntry *entry);
+
+    // 从分片中移除 entry，调用者持有分片锁，返回后需要调用 unwatch 和 release
+    void detach(Shard *shard, FileEntry *entry);
+    // 取消 entry 的 inotify 监视
+    void unwatch(FileEntry *entry);
+    // 处理 inotify 事件，移除对应的缓存
+    void invalidate(int wd);
+    // 清空所有缓存，inotify 队列溢出时使用
+    void invalidateAll();
+
+    // inotify 线程处理函数
+    void *watchLoop();
+    static void *watchThreadRun(void *) {
+        FileCache::get()->watchLoop();
+        return (void *)nullptr;
+    }
+
+public:
+    // 单例模式
+    static FileCache *get() {
+        static FileCache cache;
+        return &cache;
+    }
+
+    // 初始化缓存，max_bytes 为 mmap 映射和条目开销的总字节预算，max_files 为最多缓存的文件数
+    // 未初始化时 acquire 仍然可用，只是每次都打开新的文件
+    bool init(size_t max_bytes=FILE_CACHE_MAX_BYTES, size_t max_files=FILE_CACHE_MAX_FILES, int close_log=0);
+
+    // 获取文件，返回的 entry 引用计数已加一，失败时返回 nullptr，
+    // error 为 ENOENT(不存在)、EACCES(没有读权限)、EISDIR(是目录) 或其它 errno
+    FileEntry *acquire(const char *path, int *error);
+
+    // 释放一次引用，最后一个引用释放时关闭文件并解除映射
+    static void release(FileEntry *entry);
+    // 已经持有引用时再增加一次引用，返回 entry
+    static FileEntry *retain(FileEntry *entry);
+
+    // 当前缓存的文件个数和字节数
+    size_t count();
+    size_t bytes();
+};
+
+#endif // __FILECACHE_H__
@@ -0,0 +1,93 @@
+#ifndef __GOVERNOR_H__
+#define __GOVERNOR_H__
+
+/**
+ * 作用: 连接数的准入控制
+ *      所有 reactor 共享一个全局连接上限，accept 之后、初始化连接之前由 admit 原子地占一个名额，
+ *      连接关闭时 release 归还，超过上限的连接不再初始化
+ *      超过上限时有两种策略：REJECT 回复一个 503 后立即关闭，PAUSE 暂停本 reactor 的 accept，
+ *      让新连接留在内核的 backlog 中，连接数降到恢复水位以下再继续 accept
+ *      每个 reactor 有自己的计数(独占一个缓存行)，记录当前连接数、接受、拒绝和暂停的次数，
+ *      全局只有一个原子的总连接数，判断上限时只访问它
+ */
+
+#include <stdint.h>
+#include <atomic>
+
+#include "macro.h"
+
+class ConnGovernor {
+public:
+    enum POLICY {
+        POLICY_REJECT=0,        // 回复 503 后关闭
+        POLICY_PAUSE            // 暂停 accept
+    };
+
+    /* 一个 reactor 或所有 reactor 的计数 */
+    struct Metrics {
+        int         m_active;           // 当前连接数
+        int         m_peak;             // 连接数的最大值
+        uint64_t    m_accepted;         // 接受的连接数
+        uint64_t    m_rejected;         // 超过上限被拒绝的连接数
+        uint64_t    m_pauses;           // 暂停 accept 的次数
+        int         m_paused;           // 正在暂停 accept 的 reactor 数
+    };
+
+private:
+    /* 每个 reactor 的计数，只由所属 reactor 线程修改，其它线程读取 */
+    struct alignas(CACHE_LINE_SIZE) Counter {
+        std::atomic<int>        m_active;
+        std::atomic<int>        m_peak;
+        std::atomic<uint64_t>   m_accepted;
+        std::atomic<uint64_t>   m_rejected;
+        std::atomic<uint64_t>   m_pauses;
+        std::atomic<bool>       m_paused;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int> m_total;     // 所有 reactor 的连接数
+    std::atomic<int> m_peak;            // 所有 reactor 的连接数的最大值
+    int             m_limit;            // 连接数上限
+    int             m_resume;           // 暂停后恢复 accept 的连接数
+    int             m_policy;
+    int             m_counter_num;
+    Counter         *m_counters;        // 按 reactor 编号
+
+private:
+    ConnGovernor();
+    ~ConnGovernor();
+
+public:
+    // 单例模式
+    static ConnGovernor *get() {
+        static ConnGovernor governor;
+        return &governor;
+    }
+
+    // 初始化，reactor_num 为 reactor 个数，limit 为连接数上限，不大于 0 时使用描述符上限减去 CONN_FD_RESERVE
+    void init(int reactor_num, int limit=0, int policy=POLICY_REJECT);
+
+    // 新连接占一个名额，超过上限时返回 false，由 reactor 按策略拒绝
+    bool admit(int reactor);
+    // 连接关闭，归还名额
+    void release(int reactor);
+    // 记录一个超过上限被拒绝的连接
+    void reject(int reactor);
+    // 记录 reactor 暂停或恢复 accept
+    void pause(int reactor, bool paused);
+
+    // 是否已经达到上限
+    bool full() const { return m_total.load(std::memory_order_relaxed) >= m_limit; }
+    // 暂停的 reactor 是否可以恢复 accept
+    bool canResume() const { return m_total.load(std::memory_order_relaxed) <= m_resume; }
+
+    int policy() const { return m_policy; }
+    int limit() const { return m_limit; }
+    int active() const { return m_total.load(std::memory_order_relaxed); }
+
+    // reactor 的计数，reactor 为 -1 时返回所有 reactor 的合计
+    Metrics metrics(int reactor=-1) const;
+    // 把合计写成一行文本，返回长度
+    int report(char *buf, int size) const;
+};
+
+#endif // __GOVERNOR_H__
@@ -11,15 +11,26 @@
 /* c++ 头文件 */
 #include <string>
 #include <map>
+#include <atomic>
 
 /* 自定义头文件 */
 #include "mysqlpool.h"
+#include "filecache.h"
+#include "timerwheel.h"
+#include "buffer.h"
+#include "outqueue.h"
+#include "body.h"
+#include "range.h"
+#include "tokenizer.h"
+#include "httpheader.h"
+#include "backend.h"
+#include "router.h"
+#include "asyncdb.h"
 
-class HttpConn{ 
+class alignas(CACHE_LINE_SIZE) HttpConn {
 public:
     static const int FILENAME_LEN=200;          // 
-    static const int READ_BUFFER_SIZE=2048;     // 读取数据缓冲区
-    static const int WRITE_BUFFER_SIZE=1024;    // 写数据缓冲区
+    static const int READ_BUFFER_SIZE=BUFFER_SEGMENT_SIZE;  // 读缓冲区每一段的大小
 
     enum METHOD {   // http 请求方式
         GET=0,      // 向特定的资源发出请求
@@ -46,7 +57,15 @@ public:
         FORBIDDEN_REQUEST,
         FILE_REQUEST,
         INTERNAL_ERROR,
-        CLOSED_CONNECTION
+        CLOSED_CONNECTION,
+        CREATED_REQUEST,    // 上传的文件已保存
+        TOO_LARGE_REQUEST,  // 请求体超过限制
+        RANGE_NOT_SATISFIABLE,  // 请求的范围都不在文件内
+        NOT_MODIFIED,       // 条件请求的文件没有变化
+        HANDLER_REQUEST,    // 路由到处理函数
+        METHOD_NOT_ALLOWED, // 路径有路由但不支持这个方法
+        NOT_IMPLEMENTED,    // 请求使用了不支持的 Transfer-Encoding
+        SERVICE_UNAVAILABLE // 同时进行的上传过多
     };
 
     enum LINE_STATUS {
@@ -55,6 +74,50 @@ public:
         LINE_OPEN       // 已经被读取过了
     };
 
+    static const int MAX_HEADERS=32;            // 每个请求最多保存的请求头个数
+
+    // 异步查询结束后生成响应，reply 与路由的处理函数相同，query 只在回调中有效
+    typedef void (*QueryReply)(HttpConn *conn, const AsyncQuery *query, RouteReply *reply, void *arg);
+
+    /* 一个请求头，名字和值都是视图 */
+    struct Header {
+        HEADER_ID   m_id;               // 常用请求头的编号，其他为 HEADER_UNKNOWN
+        TokenSpan   m_name;
+        TokenSpan   m_value;
+    };
+
+    /* 一个请求的解析结果
+     * 字符串都是指向读缓冲区的视图(指针和长度)，不复制也不分配内存，
+     * 已经解析过的行在请求处理完之前不会在读缓冲区中移动，视图一直有效 */
+    struct Request {
+        METHOD      m_method;           // 请求方法
+        TokenSpan   m_target;           // 请求行中的原始目标
+        TokenSpan   m_path;             // 去掉协议和主机后的路径
+        TokenSpan   m_version;          // 版本号
+        TokenSpan   m_body;             // 请求体，处理函数的请求体跨段时指向复制出的连续内存，其他请求只有第一个段中的部分
+        int         m_header_count;
+        uint32_t    m_known_mask;               // m_known 中有效的项
+        TokenSpan   m_known[HEADER_COUNT];      // 按编号保存的常用请求头，重复出现时保留第一个
+        Header      m_headers[MAX_HEADERS];     // 按出现顺序保存的请求头，超出的不保存，数组放在最后，只访问用到的项
+
+        // 只重置计数和长度，不清空数组
+        void reset() {
+            m_method = GET;
+            m_target.m_len = m_path.m_len = m_version.m_len = m_body.m_len = 0;
+            m_target.m_data = m_path.m_data = m_version.m_data = m_body.m_data = nullptr;
+            m_header_count = 0;
+            m_known_mask = 0;
+        }
+
+        // 按编号查找常用请求头，没有时返回 nullptr
+        const TokenSpan *header(HEADER_ID id) const {
+            return (m_known_mask >> id) & 1 ? &m_known[id] : nullptr;
+        }
+
+        // 按名字查找请求头，不区分大小写，没有时返回 nullptr
+        const TokenSpan *header(const char *name) const;
+    };
+
 public:
     /* 构造和析构 */
     HttpConn();
@@ -62,42 +125,73 @@ public:
 
 public:
     /* 共有成员函数 */
-    // 初始化函数
-    void init(int sockfd, const sockaddr_in &addr, char *root, int TRIGMode, \
-              int close_log, const std::string &user, const std::string &passwd, const std::string &sqlname);
-    // 关闭连接
+    // 初始化函数，backend 为该连接所属 reactor 的事件后端
+    void init(int sockfd, const sockaddr_in &addr, EventBackend *backend, char *root, int TRIGMode, int close_log);
+    // 关闭连接，只能在所属 reactor 线程调用
     void closeConn(bool real_close=true);
-    // 主进程
+    // 关闭 socket 的读写但不释放 fd，用于工作线程中出错时，
+    // reactor 随后收到关闭事件再调用 closeConn，保证定时器只在 reactor 线程中操作
+    void shutdownConn();
+    // 主进程，结束时把 m_busy 减一
     void process();
     //循环读取客户数据，直到无数据可读或对方关闭连接
     //非阻塞ET工作模式下，需要一次性将数据读完
     bool readOnce();
+    // 后端已经收到的数据复制到读缓冲区，返回使用的字节数，读缓冲区放不下时只复制一部分，
+    // 返回 -1 表示请求过大
+    int receive(const char *data, int len);
     // 写数据
     bool write();
     // 返回 sockaddr_in
     sockaddr_in *getAddress() { return &m_address; }
-    // 初始化 mysql 中存储的用户名和密码到程序
-    void initMysqlResult(MysqlPool *conn_pool);
-
-private:
-    /* 私有变量 */
-    int m_timer_falg;     // 定时器标志
-    int m_improv;
+    // 连接的描述符，已经关闭时为 -1
+    int getSockfd() const { return m_sockfd; }
+    // 当前请求的解析结果
+    const Request &request() const { return m_request; }
+    // 连接是否处于两个请求之间，没有读到下一个请求的任何数据
+    bool isIdle() { return m_check_state == CHECK_STATE_REQUESTLINE && m_start_line == m_read_idx; }
+    // 根据连接当前所处的阶段计算超时的绝对时间(毫秒)
+    uint64_t expireTime();
+    // 在路由的处理函数或者 QueryReply 中调用，把查询交给本 reactor 的 AsyncDb，结果到达后由 callback 生成响应，
+    // 在此之前当前请求不结束，也不处理这个连接后面的请求；处理函数调用成功后不再写 reply
+    // 当前线程没有 AsyncDb(例如工作线程)、没有可用的连接或者排队已满时返回 false，处理函数自己生成响应
+    bool deferQuery(const char *sql, int len, QueryReply callback, void *arg=nullptr);
 
 public: // 临时使用public用来测试
 // private:
     /* 内部私有方法 */
+    // 连接级的重置，新连接和关闭连接时调用
     void init();
+    // 请求级的重置，只重置下标、计数和标志
+    void resetRequest();
+    // 循环解析缓冲区中的请求，按顺序合并响应后写出，返回 false 表示需要关闭连接
+    bool doProcess();
+    // 通过事件后端发送输出队列，返回 -1 出错，0 没有发完，发完后会收到写事件，1 全部发送完毕
+    int flush();
+    // 一个请求处理完后重置请求相关的状态，缓冲区中剩余的字节属于下一个请求
+    void nextRequest();
+    // 把未解析完的字节移动到当前段开头
+    void compactReadBuf();
+    // 保证当前段还有空闲空间，需要时从内存池取新的段接在链表后面，返回 false 表示请求过大
+    bool prepareReadBuf();
+    // 把读缓冲区的所有段还给内存池
+    void freeReadBuf();
     // 读取数据进程
     HTTP_CODE processRead();
     // 写入数据进程
     bool processWrite(HTTP_CODE ret);   
-    // 解析http请求行，获得请求方法，目标url及http版本号
-    HTTP_CODE parseRequestLine(char *text); 
+    // 解析http请求行，获得请求方法，目标url及http版本号，len 为行的长度，-1 表示以 '\0' 结尾
+    HTTP_CODE parseRequestLine(char *text, int len=-1); 
     // 解析http请求的一个头部信息
-    HTTP_CODE parseHeaders(char *text);
+    HTTP_CODE parseHeaders(char *text, int len=-1);
+    // 请求头解析完后决定如何接收请求体，上传和过大的请求体交给 BodyHandler 流式处理
+    HTTP_CODE beginBody();
     // 判断http请求是否被完整读入
     HTTP_CODE parseContent(char *text);
+    // 读缓冲区中没有剩余数据时由 BodyHandler 直接从 socket 接收请求体，返回 false 表示需要关闭连接
+    bool receiveBody(bool *done);
+    // 请求体没有接收完时通知 BodyHandler
+    void abortBody();
     // 读取请求
     HTTP_CODE doRequest();
     // 获取一行
@@ -105,66 +199,101 @@ public: // 临时使用public用来测试
     // 从状态机，用于分析出一行内容
     // 返回值为行的读取状态，有LINE_OK,LINE_BAD,LINE_OPEN
     LINE_STATUS parseLine();
-    // 内存共享
+    // 归还从文件缓存获取的所有文件
     void unmap();
-    // 添加响应
-    bool addResponse(const char *format, ...);
-    // 添加响应内容
-    bool addContent(const char *content);
-    // 添加头部信息
-    bool addHeaders(int content_length);
-    // 添加状态
-    bool addStatusLine(int status, const char *title);
-    // 添加内容的类型
-    bool addContentType();
-    // 添加内容的长度
-    bool addContentLength(int content_length);
-    // 添加？
-    bool addLinger();
-    // 添加?
-    bool addBlankLine();
-
-public:
-    static int  m_epollfd;           // epoll 描述符
-    static int  m_user_count;        // 用户计数
-    int         m_state;                    // 是否为读或写，读为0，写为1
-    MYSQL       *m_sql;
+    // 把当前文件的一段加入输出队列，file 不为空时发送完后归还引用
+    bool pushFileData(uint64_t offset, uint64_t len, FileEntry *file);
+    // 生成范围请求的 206 响应
+    bool processRanges();
+    // If-Range 是否与文件匹配，没有 If-Range 时返回 true
+    bool ifRangeMatch();
+    // If-None-Match 或 If-Modified-Since 表明客户端缓存的文件仍然有效
+    bool notModified();
+    // 按 Accept-Encoding 把 m_file 换成预压缩版本，没有可用的版本时保持原文件
+    void selectVariant();
+    // 调用路由的处理函数生成响应
+    bool processHandler();
+    // 把处理函数写在 buf + ROUTE_HEADER_RESERVE 的响应加上响应头提交到输出队列
+    bool commitReply(char *buf, const RouteReply &reply);
+    // 异步查询结束，生成响应后继续处理后面的请求
+    void resumeQuery(AsyncQuery *query);
+    static void queryDone(AsyncQuery *query, void *arg) {
+        ((HttpConn *)arg)->resumeQuery(query);
+    }
 
+    /* 成员按访问频率排列，对象按缓存行对齐
+     * 第一个缓存行是每个事件都会访问的状态：描述符、读缓冲区下标、解析状态、标志和时间，
+     * 第二个缓存行是定时器节点和读缓冲区链表，第三个缓存行是请求处理中用到的标量，
+     * 之后是输出队列，请求头数组、文件路径、上传文件等较大且很少访问的成员放在最后 */
 private:
+    /* 第一个缓存行 */
     int             m_sockfd;
-    sockaddr_in     m_address;
-    char            m_read_buf[READ_BUFFER_SIZE];
-    int             m_read_idx;         // 当前 read_buffer 的长度索引,也就是现在的长度
-    int             m_checked_idx;      // ?
-    int             m_start_line;       // ?
-    char            m_write_buf[WRITE_BUFFER_SIZE];
-    int             m_write_idx;
     CHECK_STATE     m_check_state;
-    METHOD          m_method;        //请求类型
+    int             m_read_idx;         // 当前 read_buffer 的长度索引,也就是现在的长度
+    int             m_checked_idx;      // 当前段中已经解析到的位置
+    int             m_start_line;       // 当前行(请求)在当前段中的起始位置
+public:
+    /* 以下由所属 reactor 线程维护 */
+    std::atomic<int>    m_busy;             // 交给 process 尚未返回的次数，大于 0 时定时器不能关闭连接
+private:
+    bool            m_linger;           // 响应后是否保持连接，HTTP/1.1 默认保持，Connection: close 时关闭
+    bool            m_close_after;      // 发送完后关闭连接
+    char            *m_read_buf;        // 当前段的数据，空闲连接为 nullptr
+public:
+    uint64_t            m_last_active;      // 最后一次读写的时间
+    uint64_t            m_request_start;    // 当前请求第一个字节到达的时间
+    EventBackend        *m_backend;         // 所属 reactor 的事件后端
+
+    /* 第二个缓存行 */
+    TimerNode           m_timer;            // 超时定时器，m_data 指向自己
+private:
+    BufferSegment   *m_read_seg;        // 当前段，即链表的最后一段
+    BufferSegment   *m_read_head;       // 当前请求占用的第一个段
+    BodyHandler     *m_body_handler;    // 流式接收请求体，为 nullptr 时请求体留在读缓冲区中
+    int             m_read_segs;        // 链表中的段数
+    int             m_TRIGMode;         // epoll使用的模式，io_uring 后端不使用
+
+    /* 第三个缓存行 */
+    int64_t         m_content_length;
+    int64_t         m_content_read;     // 已经读到的请求体字节数，请求体可以跨多个段
+    FileEntry       *m_file;            // 当前请求从文件缓存获取的文件，持有一个引用
+    char            *m_file_address;    // 小文件 mmap 的地址，与响应头一起 writev
+    char            *m_doc_root;        // http路径根目录
+    int             m_file_fd;          // 大文件的描述符，用 sendfile 发送
+    int             m_range_count;      // 范围的个数，0 表示发送整个文件
+    int             m_variant;          // 发送的预压缩版本，FILE_VARIANT
+    int             m_close_log;        // 是否开启日志
+    bool            m_vary;             // 文件有预压缩版本，响应需要带 Vary: Accept-Encoding
+    int             m_cgi;              // 是否启用 POST
+
+    /* 输出队列，计数在前，数据块数组在后 */
+    OutputQueue     m_output;           // 流水线上各个响应的响应头和内容，按顺序发送
+
+    /* 以下只在解析请求、打开文件或者接收上传时访问，文件的 stat 直接使用文件缓存中的 */
     char            m_real_file[FILENAME_LEN];     // 读取文件
-    char            *m_url;
-    char            *m_version;
-    char            *m_host;
-    int             m_content_length;
-    bool            m_linger;           // 连接类型是否为 keep-alive
-    char            *m_file_address;   // ?
-    struct stat     m_file_stat;        // 文件类型
-    struct iovec    m_iv[2];           // ? #include <sys/uio.h> 建议百度 iovec
-    int             m_iv_count;
-    int             m_cgi;    // 是否启用 POST
-    char            *m_string;  // 存储请求头数据
-    int             m_bytes_to_send;  // 发送的数据字节数 
-    int             m_bytes_have_send;    // 已发送的字节数
-    int             m_bytes_read;           // 已接受字节数
-    char            *m_doc_root;         // http路径根目录
-
-    std::map<string, string>    m_users;   // 用来存储用户名和密码
-    int                         m_TRIGMode;     // epoll使用的模式
-    int                         m_close_log;    // 是否开启日志
-
-    char m_sql_user[100];
-    char m_sql_passwd[100];
-    char m_sql_name[100];
+    Request         m_request;          // 当前请求
+    ByteRange       m_ranges[RANGE_MAX_COUNT];  // Range 请求头解析出的范围
+    const char      *m_mime;            // 文件响应的 Content-Type，取自请求的原文件
+    const Route     *m_route;           // 请求头解析完后查到的路由，没有时按根目录下的文件处理
+    int             m_allow;            // 405 响应的 Allow 头，按位的方法
+    RouteParams     m_params;           // 路由匹配的参数，指向读缓冲区
+    AsyncQuery      *m_query;           // 等待结果的异步查询，不为空时请求的处理暂停
+    QueryReply      m_query_reply;
+    void            *m_query_arg;
+    FileBodySink    m_file_sink;        // 上传文件
+    DiscardBody     m_discard_body;     // 丢弃不需要的大请求体
+    std::string     m_body_copy;        // 处理函数跨段的请求体，请求结束时释放
+    sockaddr_in     m_address;
 };
 
+/* epoll 相关的辅助函数，reactor 和 HttpConn 共用 */
+// 对文件描述符设置非阻塞
+int setnonblocking(int fd);
+// 将内核事件表注册读事件，选择开启EPOLLONESHOT
+void addfd(int epollfd, int fd, bool one_shot, int TRIGMode);
+// 从内核事件中删除监听的 fd
+void removefd(int epollfd, int fd);
+// 将事件重置为EPOLLONESHOT
+void modfd(int epollfd, int fd, int events, int TRIGMode);
+
 #endif // __HTTP_H__
\ No newline at end of file
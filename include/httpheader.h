@@ -0,0 +1,133 @@
+#ifndef __HTTPHEADER_H__
+#define __HTTPHEADER_H__
+
+/**
+ * 作用: 常用请求头名字到编号的完美哈希
+ *      哈希只取名字的长度和首尾两个字符(忽略大小写)，哈希表在编译期生成，
+ *      并在编译期检查所有名字没有冲突，查找时只需一次哈希和一次不区分大小写的比较
+ */
+
+#include <strings.h>
+
+/* 常用请求头的编号，增加时需要同时修改 _header_names */
+enum HEADER_ID {
+    HEADER_UNKNOWN=-1,          // 不认识的请求头
+    HEADER_ACCEPT=0,
+    HEADER_ACCEPT_CHARSET,
+    HEADER_ACCEPT_ENCODING,
+    HEADER_ACCEPT_LANGUAGE,
+    HEADER_AUTHORIZATION,
+    HEADER_CACHE_CONTROL,
+    HEADER_CONNECTION,
+    HEADER_CONTENT_LENGTH,
+    HEADER_CONTENT_TYPE,
+    HEADER_COOKIE,
+    HEADER_EXPECT,
+    HEADER_HOST,
+    HEADER_IF_MATCH,
+    HEADER_IF_MODIFIED_SINCE,
+    HEADER_IF_NONE_MATCH,
+    HEADER_IF_RANGE,
+    HEADER_IF_UNMODIFIED_SINCE,
+    HEADER_KEEP_ALIVE,
+    HEADER_ORIGIN,
+    HEADER_PRAGMA,
+    HEADER_RANGE,
+    HEADER_REFERER,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_UPGRADE,
+    HEADER_USER_AGENT,
+    HEADER_X_FORWARDED_FOR,
+    HEADER_COUNT                // 常用请求头的个数
+};
+
+/* 请求头名字，下标为 HEADER_ID */
+struct HeaderName {
+    const char  *m_name;
+    int         m_len;
+};
+
+#define HEADER_NAME(str) { str, sizeof(str) - 1 }
+
+static constexpr HeaderName _header_names[HEADER_COUNT] = {
+    HEADER_NAME("Accept"),
+    HEADER_NAME("Accept-Charset"),
+    HEADER_NAME("Accept-Encoding"),
+    HEADER_NAME("Accept-Language"),
+    HEADER_NAME("Authorization"),
+    HEADER_NAME("Cache-Control"),
+    HEADER_NAME("Connection"),
+    HEADER_NAME("Content-Length"),
+    HEADER_NAME("Content-Type"),
+    HEADER_NAME("Cookie"),
+    HEADER_NAME("Expect"),
+    HEADER_NAME("Host"),
+    HEADER_NAME("If-Match"),
+    HEADER_NAME("If-Modified-Since"),
+    HEADER_NAME("If-None-Match"),
+    HEADER_NAME("If-Range"),
+    HEADER_NAME("If-Unmodified-Since"),
+    HEADER_NAME("Keep-Alive"),
+    HEADER_NAME("Origin"),
+    HEADER_NAME("Pragma"),
+    HEADER_NAME("Range"),
+    HEADER_NAME("Referer"),
+    HEADER_NAME("Transfer-Encoding"),
+    HEADER_NAME("Upgrade"),
+    HEADER_NAME("User-Agent"),
+    HEADER_NAME("X-Forwarded-For"),
+};
+
+#undef HEADER_NAME
+
+static const int HEADER_HASH_SIZE = 64;     // 哈希表大小，必须是 2 的幂
+
+// 哈希函数，| 0x20 把字母转成小写，名字的首尾都是字母
+static constexpr int headerHash(const char *name, int len) {
+    return (len + 4 * (name[0] | 0x20) + (name[len - 1] | 0x20)) & (HEADER_HASH_SIZE - 1);
+}
+
+/* 哈希值到编号的表，空位为 HEADER_UNKNOWN */
+struct HeaderSlots {
+    signed char m_id[HEADER_HASH_SIZE];
+    bool        m_perfect;      // 没有冲突
+};
+
+static constexpr HeaderSlots buildHeaderSlots() {
+    HeaderSlots slots = {};
+    slots.m_perfect = true;
+    for (int i = 0; i < HEADER_HASH_SIZE; ++i)
+        slots.m_id[i] = HEADER_UNKNOWN;
+    for (int id = 0; id < HEADER_COUNT; ++id) {
+        int hash = headerHash(_header_names[id].m_name, _header_names[id].m_len);
+        if (slots.m_id[hash] != HEADER_UNKNOWN)
+            slots.m_perfect = false;
+        slots.m_id[hash] = id;
+    }
+    return slots;
+}
+
+static constexpr HeaderSlots _header_slots = buildHeaderSlots();
+static_assert(_header_slots.m_perfect, "header hash collision, change headerHash or HEADER_HASH_SIZE");
+static_assert(HEADER_COUNT <= 32, "Request::m_known_mask holds at most 32 headers");
+
+class HttpHeader {
+public:
+    // 按名字查找编号，不区分大小写，不认识时返回 HEADER_UNKNOWN
+    static HEADER_ID lookup(const char *name, int len) {
+        if (len <= 0)
+            return HEADER_UNKNOWN;
+        int id = _header_slots.m_id[headerHash(name, len)];
+        if (id == HEADER_UNKNOWN || _header_names[id].m_len != len || \
+            strncasecmp(_header_names[id].m_name, name, len) != 0)
+            return HEADER_UNKNOWN;
+        return (HEADER_ID)id;
+    }
+
+    // 编号对应的名字
+    static const char *name(HEADER_ID id) {
+        return id >= 0 && id < HEADER_COUNT ? _header_names[id].m_name : "";
+    }
+};
+
+#endif // __HTTPHEADER_H__
@@ -40,4 +40,156 @@
 /* url、version、host 的长度 */
 #define URL_SER_HOST_MAX        512
 
+/* 最大文件描述符，HttpConn 按 fd 下标预先分配 */
+#define MAX_FD                  65536
+
+/* 缓存行大小，连接对象按缓存行对齐，热字段放在第一个缓存行 */
+#define CACHE_LINE_SIZE         64
+
+/* 每次 epoll_wait 返回的最大事件数 */
+#define MAX_EVENT_NUMBER        10000
+
+/* 不超过该大小的文件使用 mmap + writev 发送，更大的文件使用 sendfile */
+#define MMAP_FILE_MAX           16384
+
+/* 静态文件缓存的默认字节预算和最大文件数 */
+#define FILE_CACHE_MAX_BYTES    (256UL * 1024 * 1024)
+#define FILE_CACHE_MAX_FILES    4096
+
+/* 缓冲区段的大小，请求行和每个请求头必须能放进一个段 */
+#define BUFFER_SEGMENT_SIZE     8192
+
+/* 段内存池最多保留的空闲段数 */
+#define SEGMENT_POOL_MAX_FREE   4096
+
+/* 每个线程缓存的空闲段个数，不计入 SEGMENT_POOL_MAX_FREE */
+#define SEGMENT_LOCAL_CACHE     8
+
+/* 一个请求最多占用的读缓冲区段数，超过时关闭连接 */
+#define READ_SEGMENT_MAX        128
+
+/* 每个连接输出队列的高水位(字节)，待发送的数据超过后不再解析新的请求，直到队列发完 */
+#define OUTPUT_HIGH_WATER       (64 * 1024)
+
+/* 每个连接输出队列最多的数据块数 */
+#define OUTPUT_QUEUE_CHUNKS     48
+
+/* 生成一个响应头前段中至少保留的空间，不够时从内存池取新的段 */
+#define OUTPUT_HEADER_RESERVE   1024
+
+/* 不超过该大小的请求体留在读缓冲区中，更大的请求体流式接收，不需要时直接丢弃 */
+#define BODY_BUFFER_MAX         (64 * 1024)
+
+/* 配置了 upload-root 时该前缀下的路径接受 PUT/POST 上传，请求体流式写入 upload-root 下的文件 */
+#define UPLOAD_PATH_PREFIX      "/upload/"
+
+/* 上传文件的最大字节数 */
+#define UPLOAD_MAX_SIZE         (1024LL * 1024 * 1024)
+
+/* 每个 reactor 同时接收的上传数，超过时回复 503
+ * 请求体在 reactor 线程中用阻塞的 write/splice 写入磁盘，磁盘慢时会拖慢同一 reactor 上的其他连接 */
+#define UPLOAD_MAX_PER_LOOP     4
+
+/* 剩余的请求体不少于该字节数时用 splice 直接从 socket 移到文件 */
+#define BODY_SPLICE_MIN         (64 * 1024)
+
+/* 用户表的读者计数分片数，每个线程固定使用其中一个 */
+#define CREDENTIAL_READER_SHARDS    16
+
+/* 从 mysql 刷新用户表的间隔(毫秒) */
+#define CREDENTIAL_REFRESH_MS       60000
+
+/* 每个 reactor 的非阻塞 mysql 连接数，0 表示不使用异步查询 */
+#define ASYNC_DB_CONNS              4
+
+/* 每个 reactor 排队等待连接的异步查询上限，超过时 query 失败 */
+#define ASYNC_DB_QUEUE_MAX          1024
+
+/* 异步查询从排队开始的超时时间(毫秒)，到时还没有结果的查询失败 */
+#define ASYNC_DB_QUERY_TIMEOUT      5000
+
+/* 异步连接断开或连接失败后重新连接的间隔(毫秒) */
+#define ASYNC_DB_RECONNECT_MS       1000
+
+/* mysql 连接池空闲时保留的最少连接数，-s 为最多连接数 */
+#define MYSQL_POOL_MIN_CONN         2
+
+/* 从连接池获取连接的默认等待时间(毫秒)，到时没有可用的连接时失败 */
+#define MYSQL_POOL_ACQUIRE_TIMEOUT  3000
+
+/* 连接池维护线程的检查间隔(毫秒)，每次 ping 空闲超过这个时间的连接，并补足最少连接数 */
+#define MYSQL_POOL_CHECK_MS         5000
+
+/* 多于最少连接数时，空闲超过这个时间(毫秒)的连接被关闭 */
+#define MYSQL_POOL_IDLE_MS          60000
+
+/* 连接建立超过这个时间(毫秒)后，归还或空闲时关闭并按需重新建立，0 表示不限制 */
+#define MYSQL_POOL_MAX_AGE_MS       1800000
+
+/* 连接失败后，这段时间(毫秒)内获取连接不再尝试新建连接 */
+#define MYSQL_POOL_RETRY_MS         1000
+
+/* 连接池中 mysql 连接的连接超时和读写超时(秒)，数据库不可达时不会无限阻塞 */
+#define MYSQL_POOL_CONNECT_TIMEOUT  3
+#define MYSQL_POOL_IO_TIMEOUT       30
+
+/* 每个 mysql 连接最多缓存的预处理语句数，超过时全部关闭 */
+#define STMT_CACHE_MAX              64
+
+/* 预处理语句字符串列的初始缓冲区大小(字节)，放不下的列按实际长度扩大 */
+#define STMT_RESULT_BUFFER          256
+
+/* 一个 Range 请求头最多的范围个数，超过时发送整个文件 */
+#define RANGE_MAX_COUNT         8
+
+/* 一条路由最多的 ":name" 参数个数 */
+#define ROUTE_MAX_PARAMS        8
+
+/* 处理函数的响应在段中为响应头预留的字节数，响应体写在预留空间之后 */
+#define ROUTE_HEADER_RESERVE    256
+
+/* io_uring 后端提交队列和完成队列的大小，多次触发的 recv 和 accept 会产生大量完成事件，完成队列要大一些 */
+#define URING_SQ_ENTRIES        1024
+#define URING_CQ_ENTRIES        8192
+
+/* io_uring 后端每个 reactor 注册的接收缓冲区个数(必须是 2 的幂)和每个缓冲区的大小 */
+#define URING_RECV_BUF_COUNT    1024
+#define URING_RECV_BUF_SIZE     4096
+
+/* io_uring 后端每个连接最多持有的接收缓冲区个数，达到时取消这个连接的 recv，
+ * 连接不读(输出队列超过高水位或者在等待查询)时不会占满整个缓冲区环 */
+#define URING_HELD_MAX          8
+
+/* io_uring 后端 splice 发送文件使用的管道大小，一条发送链最多发送这么多文件内容 */
+#define URING_PIPE_SIZE         (1024 * 1024)
+
+/* 监听套接字的 backlog */
+#define LISTEN_BACKLOG          1024
+
+/* 没有指定连接数上限时，按打开文件数的限制(最多 MAX_FD)减去这么多个描述符，留给文件缓存、管道和日志 */
+#define CONN_FD_RESERVE         128
+
+/* 暂停 accept 以后，连接数降到上限的这个百分比以下才恢复 */
+#define ACCEPT_RESUME_PERCENT   90
+
+/* 暂停 accept 时事件循环最长的等待时间(毫秒)，到时检查是否可以恢复 */
+#define ACCEPT_PAUSE_POLL_MS    100
+
+/* 有连接被拒绝或暂停 accept 时，输出准入统计的最短间隔(毫秒) */
+#define GOVERNOR_REPORT_MS      10000
+
+/* 定时器时间轮的精度(毫秒) */
+#define TIMER_TICK_MS           100
+
+/* 连接超时时间(毫秒)
+ * 空闲的 keep-alive 连接从最后一次读写开始计时；
+ * 请求头从请求的第一个字节开始计时，慢速发送请求头的连接到时一律关闭；
+ * 请求体按两次读之间的间隔计时
+ * 测试时可以在编译选项中缩短 */
+#ifndef KEEPALIVE_TIMEOUT
+#define KEEPALIVE_TIMEOUT       60000
+#define REQUEST_HEADER_TIMEOUT  15000
+#define REQUEST_BODY_TIMEOUT    30000
+#endif
+
 #endif // __MACRO_H__
\ No newline at end of file
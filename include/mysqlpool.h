@@ -4,24 +4,44 @@
 /**
  * @file mysqlpool.h
  * @author garteryang (aloneisbestes@gmail.com)
- * @brief 
- * 作用: mysql 连接池 
+ * @brief
+ * 作用: mysql 连接池
+ *      连接数在最少和最多之间伸缩：没有空闲连接时由获取连接的线程新建，空闲过久的多余连接由维护线程关闭
+ *      获取连接最多等待到超时时间，数据库不可用时返回 nullptr，不会一直阻塞
+ *      维护线程定时 ping 空闲的连接，失败的连接关闭后重新建立；归还时已经断开或者建立过久的连接直接关闭
+ *      每个连接带一个预处理语句缓存(stmtcache.h)，随连接创建，关闭连接时一起释放
  * @version 0.1
  * @date 2022-06-11
- * 
+ *
  * @copyright Copyright (c) 2022
- * 
+ *
  */
 
+#include <stdint.h>
 #include <string>
 #include <list>
+#include <unordered_map>
 #include <mysql/mysql.h>
+#include "macro.h"
 #include "locker.h"
+#include "stmtcache.h"
 
 using std::string;
 
 class MysqlPool {
 private:
+    /* 空闲的连接 */
+    struct IdleConn {
+        MYSQL       *m_sql;
+        uint64_t    m_idle_since;   // 归还的时间(毫秒)
+    };
+
+    /* 连接池中的每个连接，包括正在使用的 */
+    struct ConnInfo {
+        uint64_t    m_created;      // 建立的时间(毫秒)
+        StmtCache   *m_stmts;
+    };
+
     // mysql 必须字段
     int         m_prot;
     std::string m_ip;
@@ -30,26 +50,47 @@ private:
     std::string m_db;
 
     // 连接池相关变量
-    int m_size;     // 连接池的大小
-    int m_free;     // 连接池空闲的链接
-    int m_use;      // 连接池已使用的链接
-    std::list<MYSQL *> m_sql_pool;
+    int m_min;      // 最少连接数
+    int m_max;      // 最多连接数
+    int m_size;     // 当前的连接数，包括正在建立和正在 ping 的
+    int m_use;      // 连接池已使用的链接，空闲的链接为 m_sql_pool.size()
+    std::list<IdleConn> m_sql_pool;                     // 空闲的连接，最近归还的在前
+    std::unordered_map<MYSQL *, ConnInfo> m_conns;
+    uint64_t m_retry_at;    // 连接失败后，到这个时间(毫秒)之前不再新建连接
+
+    // 维护线程
+    int         m_check_ms;
+    int         m_idle_ms;
+    int         m_max_age_ms;
+    bool        m_stop;
+    bool        m_started;
+    pthread_t   m_tid;
 
     // 其他相关变量
     bool    m_close_log;    // 是否开启日志
     locker  m_mutex;        // 互斥锁
-    sem     m_sem;          // 信号量
+    cond    m_cond;         // 有连接归还或关闭时通知等待的线程
+    cond    m_stop_cond;    // 通知维护线程退出
 
 public:
-    // 初始化msyql
-    void    init(const string &ip, const string &user, const string passwd, const string &db, \
-                 int port=3306, int max_conn=10, int close_log=false);
-    MYSQL   *getMysqlConnect(); // 获取一个连接
+    // 初始化msyql，建立 min_conn 个连接并启动维护线程，一个连接都没有建立时返回 false，之后由维护线程继续尝试
+    bool    init(const string &ip, const string &user, const string passwd, const string &db, \
+                 int port=3306, int max_conn=10, int close_log=false, int min_conn=MYSQL_POOL_MIN_CONN);
+    // 设置维护线程的检查间隔、空闲连接的关闭时间和连接的最长使用时间(毫秒)，在 init 之前调用
+    void    setMaintain(int check_ms, int idle_ms, int max_age_ms);
+
+    // 获取一个连接，没有空闲连接时新建，达到最多连接数时最多等待 timeout_ms 毫秒，失败时返回 nullptr
+    MYSQL   *getMysqlConnect(int timeout_ms=MYSQL_POOL_ACQUIRE_TIMEOUT);
     bool    freeMysqlConnect(MYSQL *sql); // 释放一个连接到连接池
-    void    destroyMysqlConnect();  // 释放所有连接
+    void    destroyMysqlConnect();  // 停止维护线程，释放所有连接
+
+    // 获取空闲的、已使用的和全部的连接个数
+    int     getFreeConnect();
+    int     getUsedConnect();
+    int     getSize();
 
-    // 获取空闲的连接个数
-    int     getFreeConnect() { return m_free; } 
+    // 连接的预处理语句缓存，只能由持有这个连接的线程使用，不是连接池的连接时返回 nullptr
+    StmtCache *getStmtCache(MYSQL *sql);
 
     // 单例模式
     static MysqlPool *get() {
@@ -60,17 +101,36 @@ public:
 private:
     MysqlPool();
     ~MysqlPool();
+
+    // 建立一个连接，不加锁
+    MYSQL   *connect();
+    // 在锁外新建一个连接，调用前已经为它占了 m_size 的名额，失败时归还名额
+    MYSQL   *grow(uint64_t now);
+    // 释放语句缓存并关闭连接，调用前已经从 m_conns 中删除
+    static void closeConn(MYSQL *sql, StmtCache *stmts);
+    // 维护一次：关闭空闲过久和建立过久的连接，ping 空闲的连接，补足最少连接数
+    void    maintain();
+
+    static void *maintainThreadRun(void *arg) {
+        ((MysqlPool *)arg)->maintainLoop();
+        return nullptr;
+    }
+    void    maintainLoop();
 };
 
 
 class MysqlConnRAII {
 public:
-    MysqlConnRAII(MYSQL **sql, MysqlPool *sql_pool);
+    MysqlConnRAII(MYSQL **sql, MysqlPool *sql_pool, int timeout_ms=MYSQL_POOL_ACQUIRE_TIMEOUT);
     ~MysqlConnRAII();
 
+    // 这个连接的预处理语句缓存，没有取到连接时为 nullptr
+    StmtCache *stmts();
+
 private:
     MYSQL *sqlRAII;
     MysqlPool *poolRAII;
+    StmtCache *stmtsRAII;
 };
 
-#endif // __MYSQL_POOL_H__
\ No newline at end of file
+#endif // __MYSQL_POOL_H__
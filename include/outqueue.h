@@ -0,0 +1,84 @@
+#ifndef __OUTQUEUE_H__
+#define __OUTQUEUE_H__
+
+/**
+ * 作用: 每个连接的输出队列
+ *      队列由数据块组成，数据块可以是写在内存池段中的响应头、静态数据、
+ *      文件缓存中 mmap 的小文件，或者用 sendfile 发送的文件区域
+ *      连续的内存块合并成一次 sendmsg，遇到文件区域时 sendfile，直到发完或 EAGAIN
+ *      数据块发送完后立即归还段和文件引用，队列为空时不占用任何段
+ *      io_uring 后端不调用 flush，而是按 chunk 读出队首的数据块提交异步发送，完成后 consume
+ */
+
+#include <sys/types.h>
+#include <stddef.h>
+
+#include "buffer.h"
+#include "filecache.h"
+#include "macro.h"
+
+/* 输出队列中的一个数据块 */
+struct OutputChunk {
+    const char      *m_data;        // 内存数据，文件区域为 nullptr
+    int             m_fd;           // 文件区域的描述符
+    off_t           m_offset;       // 文件区域下一次发送的偏移
+    size_t          m_len;          // 剩余的字节数
+    BufferSegment   *m_seg;         // 数据所在的段，不在段中时为 nullptr
+    FileEntry       *m_file;        // 发送完后归还的文件引用，没有时为 nullptr
+};
+
+class OutputQueue {
+public:
+    static const int MAX_CHUNKS = OUTPUT_QUEUE_CHUNKS;
+    // 一个响应最多的数据块数：多个范围的响应每个范围有部分头和文件内容两块，另有响应头、结尾和 100 Continue
+    static const int RESPONSE_MAX_CHUNKS = 2 * RANGE_MAX_COUNT + 3;
+
+private:
+    // 计数放在数组前面，判断队列是否为空只访问对象开头的一个缓存行
+    int             m_head;                 // 第一个数据块的下标
+    int             m_count;                // 数据块个数
+    size_t          m_bytes;                // 待发送的字节数
+    BufferSegment   *m_seg_head;            // 最早的段
+    BufferSegment   *m_seg_tail;            // 正在写入的段
+    int             m_seg_used;             // 正在写入的段已使用的字节数
+    OutputChunk     m_chunks[MAX_CHUNKS];   // 环形数组
+
+public:
+    OutputQueue();
+    ~OutputQueue();
+
+    // 取得写响应头的空间，最后一段剩余不足 want 字节时从内存池取新的段，avail 返回可用字节数
+    char *reserve(int *avail, int want=OUTPUT_HEADER_RESERVE);
+    // 把 reserve 得到的空间中写入的 len 字节加入队列，与前一个块相邻时合并
+    bool commit(int len);
+    // 加入一块内存数据，数据在发送完之前必须有效，file 不为空时发送完后归还引用
+    bool pushMemory(const char *data, size_t len, FileEntry *file=nullptr);
+    // 加入一个文件区域，用 sendfile 发送，发送完后归还 file 的引用
+    bool pushFile(int fd, off_t offset, size_t len, FileEntry *file);
+
+    // 发送数据直到队列为空或者 EAGAIN，返回 -1 出错，0 发送缓冲区已满，1 全部发送完毕
+    int flush(int sockfd);
+    // 丢弃所有数据，归还段和文件引用
+    void clear();
+
+    // 从队首消费 len 个已发送的字节，发送完的数据块归还段和文件引用
+    void consume(size_t len);
+
+    // 待发送的字节数
+    size_t bytes() const { return m_bytes; }
+    bool empty() const { return m_count == 0; }
+    // 数据块个数和从队首开始的第 i 个数据块
+    int count() const { return m_count; }
+    const OutputChunk *chunk(int i) const { return m_chunks + (m_head + i) % MAX_CHUNKS; }
+    // 超过高水位或者不一定放得下下一个响应
+    bool full() const { return m_bytes >= OUTPUT_HIGH_WATER || m_count > MAX_CHUNKS - RESPONSE_MAX_CHUNKS; }
+
+private:
+    OutputChunk *at(int i) { return m_chunks + (m_head + i) % MAX_CHUNKS; }
+    // 加入一个数据块，没有空位时返回 nullptr
+    OutputChunk *push();
+    // 归还队列中已不再引用的段
+    void releaseSegments();
+};
+
+#endif // __OUTQUEUE_H__
@@ -0,0 +1,32 @@
+#ifndef __RANGE_H__
+#define __RANGE_H__
+
+/**
+ * 作用: 解析 Range 请求头
+ *      只支持 bytes 单位，"a-b"、"a-"、"-n" 三种形式，可以用逗号分隔多个范围，
+ *      解析结果为文件中的闭区间，由 HttpConn 用 sendfile 的偏移或 mmap 地址的偏移发送，不复制文件内容
+ */
+
+#include <stdint.h>
+
+#include "tokenizer.h"
+#include "macro.h"
+
+/* multipart/byteranges 响应各部分之间的分隔符 */
+#define RANGE_BOUNDARY  "00000000000000000001"
+
+/* 文件中的一个范围，闭区间 */
+struct ByteRange {
+    uint64_t    m_start;
+    uint64_t    m_end;
+};
+
+class HttpRange {
+public:
+    // 按文件大小 size 解析 Range 请求头的值，结果写入 ranges，最多 max 个
+    // 返回范围的个数；格式错误、单位不是 bytes 或者范围超过 max 个时返回 0，按没有 Range 处理；
+    // 格式正确但没有一个范围在文件内时返回 -1，应该返回 416
+    static int parse(const TokenSpan &value, uint64_t size, ByteRange *ranges, int max);
+};
+
+#endif // __RANGE_H__
@@ -0,0 +1,162 @@
+#ifndef __REACTOR_H__
+#define __REACTOR_H__
+
+/**
+ * 作用: one loop per thread 的多 reactor 服务器
+ *      每个 reactor 线程拥有独立的事件后端(epoll 或 io_uring)和 SO_REUSEPORT 监听套接字，
+ *      由内核把新连接分发到各个监听套接字，连接从 accept 到关闭都只由接收它的线程处理
+ *      每个 reactor 有一个时间轮管理本线程连接的超时，等待事件的超时时间由最近的定时器决定
+ *      io_uring 的提交队列只能由一个线程使用，后端在 reactor 线程开始事件循环时创建，
+ *      内核不支持或者使用工作线程池时退回 epoll
+ *      新连接先经过 ConnGovernor 的准入检查，超过全局上限时回复 503 或者暂停 accept
+ *      配置了异步查询时每个 reactor 有一个 AsyncDb，mysql 的套接字注册在同一个事件后端中，
+ *      事件循环的等待时间同时考虑它的定时器
+ */
+
+#include <pthread.h>
+#include <string>
+
+#include "macro.h"
+#include "backend.h"
+#include "http.h"
+#include "asyncdb.h"
+#include "connslab.h"
+#include "governor.h"
+#include "threadpool.h"
+#include "timerwheel.h"
+
+class EventLoop {
+public:
+    /* 构造和析构 */
+    EventLoop();
+    ~EventLoop();
+
+public:
+    // 初始化 reactor，创建监听套接字以及用于退出的 eventfd
+    // conns 为所有 reactor 共享的按 fd 下标的连接槽，fd 在进程内唯一，因此各线程互不冲突
+    // pool 为空时在 reactor 线程内处理请求，否则读完数据后交给工作线程池
+    // backend 为 EventBackend::TYPE，选择事件后端
+    // async_sql_num 为本 reactor 的非阻塞 mysql 连接数，0 表示不使用异步查询
+    bool init(int id, int port, ConnSlab *conns, ThreadPool<HttpConn> *pool, char *root, int TRIGMode, int backend, \
+              int close_log, const std::string &user, const std::string &passwd, const std::string &sqlname, \
+              const std::string &host="localhost", int async_sql_num=0);
+    // 事件循环，直到 stop 被调用
+    void loop();
+    // 通知事件循环退出，可在其它线程调用
+    void stop();
+    // 当前线程是否是 reactor 线程，处理函数在 reactor 线程中不能做阻塞的调用
+    static bool inLoop() { return s_in_loop; }
+
+    // 线程处理函数
+    static void *loopThreadRun(void *arg) {
+        ((EventLoop *)arg)->loop();
+        return (void *)nullptr;
+    }
+
+private:
+    // 创建 SO_REUSEPORT 监听套接字
+    bool createListen(int port);
+    // 在 reactor 线程中创建事件后端，io_uring 不可用时退回 epoll
+    bool createBackend();
+    // 在 reactor 线程中创建 AsyncDb，失败时处理函数退回连接池的同步查询
+    void createAsyncDb();
+    // 处理新连接，LT 模式下循环 accept 直到 EAGAIN
+    void dealConnection();
+    // 初始化一个新连接，超过连接数上限时拒绝
+    void newConnection(int connfd, const sockaddr_in &client_address);
+    // 回复 503 后关闭没有初始化的连接，PAUSE 策略下同时暂停 accept
+    void rejectConnection(int connfd);
+    // 暂停或恢复本 reactor 的 accept
+    void pauseAccept(bool pause);
+    // 有连接被拒绝或暂停 accept 时输出准入统计，最多每 GOVERNOR_REPORT_MS 一次
+    void reportGovernor();
+    // 处理读事件，事件可能带着后端已经收到的数据
+    void dealRead(const BackendEvent &event);
+    // 处理写事件
+    void dealWrite(int sockfd);
+    // 处理到期的连接定时器
+    void dealTimer(HttpConn *conn);
+    // 删除定时器并关闭连接，归还连接数的名额
+    void closeConn(HttpConn *conn);
+
+    // 时间轮回调
+    static void timerCallback(TimerNode *node, void *arg) {
+        ((EventLoop *)arg)->dealTimer((HttpConn *)node->m_data);
+    }
+
+private:
+    int             m_id;           // reactor 编号
+    EventBackend    *m_backend;     // 本线程的事件后端
+    int             m_backend_type; // 选择的后端类型
+    int             m_listenfd;     // 本线程的监听套接字
+    int             m_wakeupfd;     // eventfd，用于唤醒等待中的事件循环退出
+    volatile bool   m_stop;         // 是否退出事件循环
+
+    ConnSlab        *m_conns;       // 连接槽，按 fd 下标
+    ThreadPool<HttpConn> *m_pool;   // 工作线程池，可以为空
+    ConnGovernor    *m_governor;    // 所有 reactor 共享的连接数准入控制
+    bool            m_accept_paused;    // 本 reactor 是否暂停了 accept
+    uint64_t        m_last_report;      // 上一次输出准入统计的时间
+    char            *m_root;        // http 根目录
+    int             m_TRIGMode;     // 连接使用的触发模式
+    int             m_close_log;    // 是否关闭日志
+
+    std::string     m_sql_user;
+    std::string     m_sql_passwd;
+    std::string     m_sql_name;
+    std::string     m_sql_host;
+    int             m_async_sql_num;    // 非阻塞 mysql 连接数
+    AsyncDb         *m_db;          // 本线程的异步查询，没有配置或者不可用时为空
+
+    TimerWheel      m_timer;        // 本线程连接的超时定时器
+    uint64_t        m_now;          // 本轮事件循环开始的时间(毫秒)
+
+    BackendEvent    m_events[MAX_EVENT_NUMBER];
+
+    static thread_local bool s_in_loop;
+};
+
+class WebServer {
+public:
+    /* 构造和析构 */
+    WebServer();
+    ~WebServer();
+
+public:
+    // 初始化服务器参数，loop_num 为 reactor 线程数，thread_num 为工作线程数，0 表示不使用线程池
+    // backend 为 EventBackend::TYPE，默认内核支持时使用 io_uring
+    // conn_limit 为所有 reactor 的连接数上限，0 表示按打开文件数的限制计算，accept_policy 为超过上限时的 ConnGovernor::POLICY
+    // async_sql_num 为每个 reactor 的非阻塞 mysql 连接数，0 表示不使用异步查询
+    void init(int port, char *root, int loop_num, int thread_num, int TRIGMode, int close_log, \
+              const std::string &user, const std::string &passwd, const std::string &sqlname, \
+              int backend=EventBackend::BACKEND_AUTO, int conn_limit=0, int accept_policy=ConnGovernor::POLICY_REJECT, \
+              const std::string &host="localhost", int async_sql_num=0);
+    // 启动所有 reactor，第 0 个 reactor 运行在当前线程，阻塞直到 stop
+    bool start();
+    // 停止所有 reactor
+    void stop();
+
+private:
+    int             m_port;
+    char            *m_root;
+    int             m_loop_num;
+    int             m_thread_num;
+    int             m_TRIGMode;
+    int             m_backend;
+    int             m_close_log;
+    int             m_conn_limit;
+    int             m_accept_policy;
+
+    std::string     m_sql_user;
+    std::string     m_sql_passwd;
+    std::string     m_sql_name;
+    std::string     m_sql_host;
+    int             m_async_sql_num;
+
+    ConnSlab        m_conns;        // 所有连接，按 fd 下标
+    EventLoop       *m_loops;       // reactor 数组
+    ThreadPool<HttpConn> *m_pool;   // 工作线程池
+    pthread_t       *m_tids;        // reactor 线程 id
+};
+
+#endif // __REACTOR_H__
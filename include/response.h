@@ -0,0 +1,144 @@
+#ifndef __RESPONSE_H__
+#define __RESPONSE_H__
+
+/**
+ * 作用: 用预先生成的片段拼装 http 响应头
+ *      每个状态码的状态行和 Content-Type 以及错误页面在编译期写好，
+ *      Date 头每个线程每秒只格式化一次，Content-Length 用查表的整数转换，
+ *      拼装响应头时只有 memcpy，不再逐个调用 vsnprintf
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/* 一个状态码的预生成片段 */
+struct StatusTemplate {
+    int         m_code;
+    const char  *m_head;        // 状态行和 Content-Type
+    int         m_head_len;
+    const char  *m_body;        // 页面内容，200 为文件为空时发送的页面
+    int         m_body_len;
+};
+
+class HttpStatus {
+public:
+    // 状态码对应的片段，不支持的状态码返回 500 的片段
+    static const StatusTemplate *get(int code);
+    // 多个范围的 206 响应，Content-Type 为 multipart/byteranges
+    static const StatusTemplate *byteranges();
+    // 状态码的原因短语
+    static const char *reason(int code);
+};
+
+class HttpDate {
+public:
+    static const int DATE_LEN = 29;     // "Sun, 06 Nov 1994 08:49:37 GMT" 的长度
+
+    // 当前时间的 "Date: ...\r\n" 头，每个线程每秒格式化一次，len 返回长度
+    static const char *get(int *len);
+    // 把时间格式化为 http 日期，buf 至少 DATE_LEN + 1 字节，返回长度
+    static int format(time_t t, char *buf);
+    // 解析 "Sun, 06 Nov 1994 08:49:37 GMT" 格式的日期，格式错误时返回 false
+    static bool parse(const char *data, int len, time_t *t);
+};
+
+// 把无符号整数转换为十进制字符串，不写入 '\0'，返回长度，buf 至少 20 字节
+int formatUint(char *buf, uint64_t value);
+
+/* 在给定的缓冲区中追加响应头，空间不够时置 overflow，之后的追加都被忽略 */
+class ResponseWriter {
+public:
+    ResponseWriter(char *buf, int size) : m_buf(buf), m_size(size), m_len(0), m_overflow(false) {}
+
+    // 追加一段原始数据
+    void append(const char *data, int len) {
+        if (m_overflow || m_len + len > m_size) {
+            m_overflow = true;
+            return ;
+        }
+        memcpy(m_buf + m_len, data, len);
+        m_len += len;
+    }
+
+    // 状态行、Content-Type 和 Date
+    void statusLine(const StatusTemplate *status) {
+        append(status->m_head, status->m_head_len);
+        int len;
+        const char *date = HttpDate::get(&len);
+        append(date, len);
+    }
+
+    // 任意状态码的状态行、指定的 Content-Type 和 Date，用于处理函数生成的响应
+    void statusLine(int code, const char *content_type) {
+        append("HTTP/1.1 ", 9);
+        appendUint(code);
+        append(" ", 1);
+        const char *reason = HttpStatus::reason(code);
+        append(reason, strlen(reason));
+        append("\r\nContent-Type: ", 16);
+        append(content_type, strlen(content_type));
+        append("\r\n", 2);
+        int len;
+        const char *date = HttpDate::get(&len);
+        append(date, len);
+    }
+
+    // 十进制整数
+    void appendUint(uint64_t value) {
+        if (m_overflow || m_len + 20 > m_size) {
+            m_overflow = true;
+            return ;
+        }
+        m_len += formatUint(m_buf + m_len, value);
+    }
+
+    // Content-Length 头
+    void contentLength(uint64_t len) {
+        append("Content-Length: ", 16);
+        appendUint(len);
+        append("\r\n", 2);
+    }
+
+    // Content-Range 头 "bytes start-end/size"
+    void contentRange(uint64_t start, uint64_t end, uint64_t size) {
+        append("Content-Range: bytes ", 21);
+        appendUint(start);
+        append("-", 1);
+        appendUint(end);
+        append("/", 1);
+        appendUint(size);
+        append("\r\n", 2);
+    }
+
+    // 范围无法满足时的 Content-Range 头 "bytes */size"
+    void contentRangeUnsatisfied(uint64_t size) {
+        append("Content-Range: bytes */", 23);
+        appendUint(size);
+        append("\r\n", 2);
+    }
+
+    // Connection 头
+    void connection(bool keep_alive) {
+        if (keep_alive)
+            append("Connection: keep-alive\r\n", 24);
+        else
+            append("Connection: close\r\n", 19);
+    }
+
+    // 响应头结束的空行
+    void end() {
+        append("\r\n", 2);
+    }
+
+    int length() const { return m_len; }
+    bool overflow() const { return m_overflow; }
+
+private:
+    char    *m_buf;
+    int     m_size;
+    int     m_len;
+    bool    m_overflow;
+};
+
+#endif // __RESPONSE_H__
@@ -0,0 +1,158 @@
+#ifndef __ROUTER_H__
+#define __ROUTER_H__
+
+/**
+ * 作用: 按 url 路径把请求分派给注册的处理函数或静态目录
+ *      注册的路由编译成一棵压缩的基数树(radix tree)，公共前缀只保存一次，每个节点按首字符查找子节点
+ *      路由有三种片段：静态文本精确匹配，":name" 匹配一个非空的路径段，结尾的 "*" 匹配剩余的任意路径(前缀路由)
+ *      优先级为静态 > 参数 > 前缀，同一路径的每个请求方法可以有不同的处理函数
+ *      查找时沿着路径视图前进，参数和剩余路径都是指向读缓冲区的视图，不复制也不分配内存
+ *      路由在服务器启动前注册，之后只读，多个 reactor 和工作线程同时查找不加锁
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "tokenizer.h"
+#include "macro.h"
+
+class HttpConn;
+
+/* 匹配到的路径参数，都是视图 */
+struct RouteParams {
+    int         m_count;
+    TokenSpan   m_names[ROUTE_MAX_PARAMS];      // 参数名，指向路由中的字符串
+    TokenSpan   m_values[ROUTE_MAX_PARAMS];     // 参数值，指向请求的路径
+    TokenSpan   m_rest;                         // 前缀路由中 "*" 匹配的剩余路径，不包含开头的 /
+
+    // 按名字查找参数，没有时返回 nullptr
+    const TokenSpan *get(const char *name) const;
+};
+
+/* 处理函数生成的响应
+ * 响应体写在输出队列的段中，处理完后由 HttpConn 在前面加上响应头，放不下时置 overflow，回复 500
+ * 较大或者不变的响应体可以用 body 直接引用，数据在发送完之前必须有效 */
+class RouteReply {
+public:
+    RouteReply(char *buf, int size) : m_buf(buf), m_size(size), m_len(0), m_overflow(false), \
+        m_status(200), m_content_type("text/plain"), m_body(nullptr), m_body_len(0) {}
+
+    // 状态码，默认 200
+    void status(int code) { m_status = code; }
+    // Content-Type，必须是字符串常量，默认 text/plain
+    void contentType(const char *type) { m_content_type = type; }
+    // 追加一段响应体，复制到段中
+    void append(const char *data, int len);
+    void append(const char *str);
+    // 追加十进制整数
+    void appendUint(uint64_t value);
+    // 在复制的内容之后引用一段数据，不复制
+    void body(const char *data, size_t len) { m_body = data; m_body_len = len; }
+
+    int statusCode() const { return m_status; }
+    const char *contentType() const { return m_content_type; }
+    const char *data() const { return m_buf; }
+    int length() const { return m_len; }
+    const char *externalBody() const { return m_body; }
+    size_t externalLength() const { return m_body_len; }
+    bool overflow() const { return m_overflow; }
+    int capacity() const { return m_size; }
+
+private:
+    char        *m_buf;
+    int         m_size;
+    int         m_len;
+    bool        m_overflow;
+    int         m_status;
+    const char  *m_content_type;
+    const char  *m_body;
+    size_t      m_body_len;
+};
+
+// 处理函数，conn 为当前连接，用 conn->request() 读取请求，使用工作线程池时在工作线程中调用
+// 需要查询数据库时可以用 conn->deferQuery 发出异步查询，结果到达后再生成响应
+typedef void (*RouteHandler)(HttpConn *conn, const RouteParams &params, RouteReply *reply, void *arg);
+
+/* 一条路由的目标：处理函数、静态目录或者上传目录 */
+struct Route {
+    std::string     m_pattern;      // 注册时的路由
+    RouteHandler    m_handler;      // 为 nullptr 时是静态目录或上传目录
+    void            *m_arg;
+    std::string     m_dir;          // 静态目录或上传目录，文件路径为目录加上剩余路径
+    bool            m_upload;       // 上传目录，请求体写入 m_dir 下的文件
+};
+
+class Router {
+public:
+    static const int METHOD_COUNT = 8;          // 与 HttpConn::METHOD 的个数相同
+    static const int ALL_METHODS = (1 << METHOD_COUNT) - 1;
+
+    enum MATCH {
+        MATCH_NONE=0,       // 没有路由，按根目录下的文件处理
+        MATCH_OK,           // 找到路由
+        MATCH_METHOD        // 路径有路由但不支持这个方法
+    };
+
+private:
+    /* 基数树的节点 */
+    struct Node {
+        std::string         m_path;             // 压缩的静态片段，参数节点为参数名
+        std::string         m_indices;          // 静态子节点 m_path 的首字符，与 m_children 一一对应
+        std::vector<Node *> m_children;         // 静态子节点
+        Node                *m_param;           // ":name" 子节点
+        const Route         *m_exact[METHOD_COUNT];     // 路径在这个节点结束的路由
+        const Route         *m_prefix[METHOD_COUNT];    // 路径在这个节点之后还有任意剩余部分的路由
+        int                 m_exact_methods;    // m_exact 中有路由的方法，按位
+        int                 m_prefix_methods;
+
+        Node();
+        ~Node();
+    };
+
+    /* 查找过程中的结果 */
+    struct Lookup;
+
+    Node                    *m_root;
+    std::vector<Route *>    m_routes;
+    int                     m_count;
+
+private:
+    Router();
+    ~Router();
+
+    // 插入一段静态文本，返回文本结束处的节点
+    Node *insertStatic(Node *node, const char *text, int len);
+    // 插入一条路由
+    bool insert(const char *pattern, int methods, Route *route);
+    // 从 node 之后匹配 [pos, end)，找到完全匹配的路由时返回 true
+    bool match(const Node *node, const char *pos, const char *end, Lookup *lookup, int depth) const;
+    // 把 prefix 下的路径映射到目录 dir
+    bool addDir(int methods, const char *prefix, const char *dir, bool upload);
+
+public:
+    // 单例模式
+    static Router *get() {
+        static Router router;
+        return &router;
+    }
+
+    // 注册处理函数，methods 为 1 << HttpConn::METHOD 的组合，路由以 / 开头，
+    // 可以包含 ":name" 参数段，以 "/*" 结尾时匹配这个前缀下的所有路径，
+    // 与已有的路由冲突(同一参数位置不同的参数名，或者同一路径和方法已经注册)时返回 false
+    bool addHandler(int methods, const char *pattern, RouteHandler handler, void *arg=nullptr);
+    // 把 prefix 下的路径映射到静态目录 dir，只接受 GET，prefix 以 / 开头，例如 "/assets/"
+    bool addStatic(const char *prefix, const char *dir);
+    // 把 prefix 下的 PUT/POST 请求体保存到目录 dir 下的文件，dir 不应该在静态文件的根目录中
+    bool addUpload(const char *prefix, const char *dir);
+
+    // 查找路径对应的路由，MATCH_OK 时 route 和 params 有效，MATCH_METHOD 时 allow 返回支持的方法
+    MATCH find(int method, const char *path, int len, const Route **route, RouteParams *params, int *allow) const;
+
+    // 注册的路由数
+    int count() const { return m_count; }
+    // 删除所有路由，只在没有请求时调用，用于测试
+    void clear();
+};
+
+#endif // __ROUTER_H__
@@ -0,0 +1,119 @@
+#ifndef __STMTCACHE_H__
+#define __STMTCACHE_H__
+
+/**
+ * 作用: 每个 mysql 连接的预处理语句缓存
+ *      语句按文本缓存，第一次使用时 mysql_stmt_prepare，之后直接执行，服务器不再解析语句，参数也不再拼进 sql
+ *      参数和结果都使用二进制协议绑定：整数列按 long long 读取，其它列按字符串读入每列自己的缓冲区，
+ *      缓冲区在多次执行之间复用，放不下时按实际长度扩大后重新读取这一列
+ *      连接重新连接(mysql_thread_id 改变)后缓存的语句全部失效，下一次使用时重新准备
+ *      由 MysqlPool 与连接一起创建和释放，同一时间只有持有连接的线程使用，不加锁
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <mysql/mysql.h>
+
+#include "macro.h"
+
+class StmtCache;
+
+/* 一条预处理语句，参数按下标绑定，execute 之后用 fetch 逐行读取结果 */
+class MysqlStmt {
+private:
+    // MYSQL_BIND 中 is_null 和 error 指向的类型，MySQL 8 为 bool，MariaDB 和更早的版本为 my_bool
+    typedef std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type BindFlag;
+
+    /* 一列结果，m_results 中对应的 MYSQL_BIND 指向这里 */
+    struct Column {
+        std::vector<char>   m_buffer;   // 字符串列的缓冲区，多留一个字节放结尾的 '\0'
+        long long           m_int;      // 整数列的值
+        unsigned long       m_length;   // 这一列实际的长度
+        BindFlag            m_is_null;
+        BindFlag            m_error;    // 缓冲区放不下时被置位
+        bool                m_integer;
+    };
+
+    StmtCache                   *m_cache;
+    MYSQL_STMT                  *m_stmt;
+    std::vector<MYSQL_BIND>     m_params;
+    std::vector<long long>      m_param_ints;
+    std::vector<unsigned long>  m_param_lengths;
+    std::vector<MYSQL_BIND>     m_results;
+    std::vector<Column>         m_columns;
+    bool                        m_stored;   // 有还没有释放的结果集
+
+private:
+    friend class StmtCache;
+    MysqlStmt(StmtCache *cache, MYSQL_STMT *stmt);
+    ~MysqlStmt();
+
+    MysqlStmt(const MysqlStmt &) = delete;
+    MysqlStmt &operator=(const MysqlStmt &) = delete;
+
+    // 准备语句，按结果集的元数据为每一列分配缓冲区并绑定
+    bool prepare(const char *sql, unsigned long len);
+    // 记录失败，客户端错误时连接不能继续使用
+    bool fail();
+
+public:
+    // 绑定第 index 个参数，字符串参数只保存指针，在 execute 返回前必须有效
+    bool bindString(int index, const char *data, unsigned long len);
+    bool bindInt(int index, long long value);
+    bool bindNull(int index);
+
+    // 执行语句，有结果集时完整读到客户端，之前没有释放的结果集先释放
+    bool execute();
+    // 读取下一行，没有更多的行或者出错时返回 false
+    bool fetch();
+    // 释放结果集，缓冲区保留给下一次执行
+    void freeResult();
+
+    /* 当前行第 col 列的值，字符串以 '\0' 结尾，直到下一次 fetch 之前有效；NULL 时 getString 返回 nullptr，getInt 返回 0 */
+    bool isNull(int col) const { return m_columns[col].m_is_null; }
+    const char *getString(int col, unsigned long *len=nullptr);
+    long long getInt(int col);
+
+    int paramCount() const { return m_params.size(); }
+    int fieldCount() const { return m_columns.size(); }
+    uint64_t affectedRows() { return mysql_stmt_affected_rows(m_stmt); }
+    unsigned int errorno() { return mysql_stmt_errno(m_stmt); }
+    const char *error() { return mysql_stmt_error(m_stmt); }
+};
+
+class StmtCache {
+private:
+    MYSQL           *m_sql;
+    unsigned long   m_thread_id;    // 准备语句时连接的 id，改变说明连接重新连接过
+    bool            m_broken;       // 语句出现过客户端错误，连接归还时关闭
+    uint64_t        m_prepares;     // 在服务器上准备语句的次数
+    std::string     m_error;        // 最后一次准备失败的原因
+    std::unordered_map<std::string, MysqlStmt *> m_stmts;
+
+private:
+    friend class MysqlStmt;
+
+    StmtCache(const StmtCache &) = delete;
+    StmtCache &operator=(const StmtCache &) = delete;
+
+public:
+    explicit StmtCache(MYSQL *sql);
+    ~StmtCache();
+
+    // 取出 sql 对应的语句，没有时准备一条并缓存，失败时返回 nullptr，原因见 error()
+    // 缓存的语句超过 STMT_CACHE_MAX 条时先全部关闭
+    MysqlStmt *prepare(const char *sql, unsigned long len);
+    MysqlStmt *prepare(const std::string &sql) { return prepare(sql.data(), sql.size()); }
+    // 关闭所有缓存的语句
+    void clear();
+
+    size_t size() const { return m_stmts.size(); }
+    uint64_t prepares() const { return m_prepares; }
+    bool broken() const { return m_broken; }
+    const char *error() const { return m_error.c_str(); }
+};
+
+#endif // __STMTCACHE_H__
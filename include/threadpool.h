@@ -0,0 +1,300 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+/**
+ * 作用: 工作窃取线程池
+ *      每个工作线程拥有一个 Chase-Lev 双端队列，自己的队列为空时从其它线程窃取任务
+ *      reactor 线程通过无锁的有界收件箱把任务投递给某个工作线程，整个投递和调度过程没有全局锁
+ *      任务类型 T 需要提供 process() 方法，例如 HttpConn
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include <exception>
+#include <stdint.h>
+
+#include "locker.h"
+#include "wsdeque.h"
+
+/* 有界多生产者多消费者环形队列，用作工作线程的收件箱 */
+template<typename T>
+class InboxQueue {
+private:
+    struct Cell {
+        std::atomic<uint64_t>   m_seq;
+        T                       m_data;
+    };
+
+    Cell                            *m_cells;
+    uint64_t                        m_mask;
+    alignas(64) std::atomic<uint64_t>   m_enqueue_pos;
+    alignas(64) std::atomic<uint64_t>   m_dequeue_pos;
+
+public:
+    /* 构造和析构 */
+    InboxQueue(uint64_t size=1024) {
+        uint64_t real_size = 2;
+        while (real_size < size)
+            real_size <<= 1;
+
+        m_mask = real_size - 1;
+        m_cells = new Cell[real_size];
+        for (uint64_t i = 0; i < real_size; ++i)
+            m_cells[i].m_seq.store(i, std::memory_order_relaxed);
+
+        m_enqueue_pos.store(0, std::memory_order_relaxed);
+        m_dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    ~InboxQueue() {
+        delete [] m_cells;
+    }
+
+    InboxQueue(const InboxQueue &) = delete;
+    InboxQueue &operator=(const InboxQueue &) = delete;
+
+public:
+    // 入队，队列满时返回 false
+    bool push(const T &value) {
+        uint64_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            uint64_t seq = cell->m_seq.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)pos;
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->m_data = value;
+        cell->m_seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 出队，队列为空时返回 false
+    bool pop(T &value) {
+        uint64_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            uint64_t seq = cell->m_seq.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->m_data;
+        cell->m_seq.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列是否为空，只是一个近似值
+    bool isempty() {
+        uint64_t pos = m_dequeue_pos.load(std::memory_order_acquire);
+        return m_cells[pos & m_mask].m_seq.load(std::memory_order_acquire) != pos + 1;
+    }
+};
+
+
+template<typename T>
+class ThreadPool {
+private:
+    /* 每个工作线程的私有数据，按 cache line 对齐避免伪共享 */
+    struct alignas(64) Worker {
+        ThreadPool              *m_pool;
+        int                     m_id;
+        pthread_t               m_tid;
+        WorkStealDeque<T *>     m_deque;        // 本线程的工作队列
+        InboxQueue<T *>         *m_inbox;       // 其它线程投递过来的任务
+        sem                     m_wake;         // 空闲时在该信号量上睡眠
+        std::atomic<bool>       m_sleeping;     // 是否正在睡眠
+    };
+
+    int                     m_thread_number;    // 工作线程数量
+    Worker                  *m_workers;         // 工作线程数组
+    std::atomic<bool>       m_stop;             // 是否停止线程池
+
+    static const int        SPIN_ROUNDS = 64;   // 睡眠前的自旋轮数
+    static const int        DRAIN_BATCH = 32;   // 每次从收件箱搬运到本地队列的任务数
+
+public:
+    /* 构造和析构 */
+    // thread_number 为工作线程数量，max_requests 为所有收件箱容量之和
+    ThreadPool(int thread_number=8, int max_requests=10000) {
+        if (thread_number <= 0 || max_requests <= 0)
+            throw std::exception();
+
+        m_thread_number = thread_number;
+        m_stop.store(false, std::memory_order_relaxed);
+
+        m_workers = new Worker[m_thread_number];
+        int inbox_size = max_requests / m_thread_number + 1;
+        for (int i = 0; i < m_thread_number; ++i) {
+            m_workers[i].m_pool = this;
+            m_workers[i].m_id = i;
+            m_workers[i].m_inbox = new InboxQueue<T *>(inbox_size);
+            m_workers[i].m_sleeping.store(false, std::memory_order_relaxed);
+        }
+
+        for (int i = 0; i < m_thread_number; ++i) {
+            if (pthread_create(&m_workers[i].m_tid, nullptr, worker, m_workers + i) != 0) {
+                stopAll(i);
+                throw std::exception();
+            }
+        }
+    }
+
+    ~ThreadPool() {
+        stopAll(m_thread_number);
+    }
+
+public:
+    // 投递一个任务，可在任意线程调用，所有收件箱都满时返回 false
+    bool append(T *request) {
+        // 每个投递线程各自轮询工作线程，避免共享计数器
+        static thread_local unsigned int next = 0;
+
+        for (int i = 0; i < m_thread_number; ++i) {
+            Worker *w = m_workers + (next++ % m_thread_number);
+            if (w->m_inbox->push(request)) {
+                wakeup(w);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // 工作线程数量
+    int size() { return m_thread_number; }
+
+private:
+    // 线程处理函数
+    static void *worker(void *arg) {
+        Worker *w = (Worker *)arg;
+        w->m_pool->run(w);
+        return (void *)nullptr;
+    }
+
+    // 唤醒睡眠中的工作线程
+    void wakeup(Worker *w) {
+        if (w->m_sleeping.exchange(false, std::memory_order_seq_cst))
+            w->m_wake.post();
+    }
+
+    // 唤醒一个空闲的其它工作线程，让它来窃取任务
+    void wakeupIdle(Worker *self) {
+        for (int i = 1; i < m_thread_number; ++i) {
+            Worker *w = m_workers + (self->m_id + i) % m_thread_number;
+            if (w->m_sleeping.load(std::memory_order_relaxed)) {
+                wakeup(w);
+                return ;
+            }
+        }
+    }
+
+    // 把收件箱里的任务搬到本地队列，返回其中一个任务
+    bool drainInbox(Worker *w, T *&request) {
+        if (!w->m_inbox->pop(request))
+            return false;
+
+        T *extra = nullptr;
+        int moved = 0;
+        while (moved < DRAIN_BATCH && w->m_inbox->pop(extra)) {
+            w->m_deque.push(extra);
+            ++moved;
+        }
+
+        // 本地队列积压了任务，叫醒一个空闲线程来分担
+        if (moved > 0)
+            wakeupIdle(w);
+        return true;
+    }
+
+    // 从其它工作线程的本地队列或收件箱中窃取任务
+    bool stealOthers(Worker *self, T *&request) {
+        for (int i = 1; i < m_thread_number; ++i) {
+            Worker *victim = m_workers + (self->m_id + i) % m_thread_number;
+            if (victim->m_deque.steal(request))
+                return true;
+        }
+
+        // 收件箱是多消费者队列，拥有者忙时其它线程也可以直接取走
+        for (int i = 1; i < m_thread_number; ++i) {
+            Worker *victim = m_workers + (self->m_id + i) % m_thread_number;
+            if (victim->m_inbox->pop(request))
+                return true;
+        }
+
+        return false;
+    }
+
+    // 获取一个任务
+    bool getTask(Worker *w, T *&request) {
+        return w->m_deque.pop(request) || drainInbox(w, request) || stealOthers(w, request);
+    }
+
+    // 工作线程主循环
+    void run(Worker *w) {
+        T *request = nullptr;
+        int idle = 0;
+
+        while (!m_stop.load(std::memory_order_relaxed)) {
+            if (getTask(w, request)) {
+                idle = 0;
+                request->process();
+                continue;
+            }
+
+            // 短暂让出 cpu 再重试，线程数多于 cpu 时不至于空转抢占 reactor
+            if (++idle < SPIN_ROUNDS) {
+                sched_yield();
+                continue;
+            }
+
+            // 先声明要睡眠，再检查一次收件箱，防止投递者看到未睡眠而漏掉唤醒
+            w->m_sleeping.store(true, std::memory_order_seq_cst);
+            if (!w->m_inbox->isempty() || m_stop.load(std::memory_order_relaxed)) {
+                w->m_sleeping.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            w->m_wake.wait();
+            idle = 0;
+        }
+    }
+
+    // 停止前 n 个已创建的工作线程并释放资源
+    void stopAll(int n) {
+        if (m_workers == nullptr)
+            return ;
+
+        m_stop.store(true, std::memory_order_seq_cst);
+        for (int i = 0; i < n; ++i)
+            m_workers[i].m_wake.post();
+
+        for (int i = 0; i < n; ++i)
+            pthread_join(m_workers[i].m_tid, nullptr);
+
+        for (int i = 0; i < m_thread_number; ++i)
+            delete m_workers[i].m_inbox;
+
+        delete [] m_workers;
+        m_workers = nullptr;
+    }
+};
+
+#endif // __THREADPOOL_H__
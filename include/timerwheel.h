@@ -0,0 +1,92 @@
+#ifndef __TIMERWHEEL_H__
+#define __TIMERWHEEL_H__
+
+/**
+ * 作用: 分层时间轮定时器，每个 reactor 一个，只在所属 reactor 线程中使用，不加锁
+ *      定时器节点侵入式地放在被管理的对象中(例如 HttpConn)，添加、删除、重置都是 O(1) 且不分配内存
+ *      第一层 256 个槽，每个槽一个 tick；后面三层各 64 个槽，到期时逐层向下迁移(cascade)
+ *      由 epoll_wait 的超时时间驱动，nextTimeout 给出下一次需要唤醒的时间
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include "macro.h"
+
+/* 定时器节点，双向链表 */
+struct TimerNode {
+    TimerNode   *m_prev;
+    TimerNode   *m_next;
+    uint64_t    m_expire;       // 到期的 tick
+    void        *m_data;        // 用户数据，例如 HttpConn
+
+    TimerNode() : m_prev(nullptr), m_next(nullptr), m_expire(0), m_data(nullptr) {}
+
+    // 是否在时间轮中
+    bool linked() const { return m_next != nullptr; }
+};
+
+class TimerWheel {
+public:
+    // 定时器到期的回调，node 已经从时间轮中摘下，可以在回调中重新 add
+    typedef void (*TimerCallback)(TimerNode *node, void *arg);
+
+private:
+    static const int TVR_BITS = 8;
+    static const int TVN_BITS = 6;
+    static const int TVR_SIZE = 1 << TVR_BITS;
+    static const int TVN_SIZE = 1 << TVN_BITS;
+    static const int TVR_MASK = TVR_SIZE - 1;
+    static const int TVN_MASK = TVN_SIZE - 1;
+    static const int TVN_NUM = 3;       // 第一层之后的层数
+
+    TimerNode   m_tv1[TVR_SIZE];            // 第一层，每个元素是一个循环链表的哨兵
+    TimerNode   m_tvn[TVN_NUM][TVN_SIZE];   // 其余层
+
+    uint64_t    m_tick_ms;      // 每个 tick 的毫秒数
+    uint64_t    m_jiffies;      // 下一个要处理的 tick
+    uint64_t    m_count;        // 定时器个数
+
+private:
+    // 按到期时间放入对应层的槽中
+    void internalAdd(TimerNode *node);
+    // 把第 n 层 index 槽中的定时器重新分配到下层
+    int cascade(int n, int index);
+
+    static void listInit(TimerNode *head);
+    static void listAppend(TimerNode *head, TimerNode *node);
+    static void listUnlink(TimerNode *node);
+
+public:
+    /* 构造 */
+    // now_ms 为当前时间，tick_ms 为时间精度
+    TimerWheel(uint64_t now_ms=0, uint64_t tick_ms=TIMER_TICK_MS);
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+public:
+    // 添加定时器，expire_ms 为到期的绝对时间(毫秒)，节点不能已经在时间轮中
+    void add(TimerNode *node, uint64_t expire_ms);
+    // 删除定时器，节点不在时间轮中时什么也不做
+    void remove(TimerNode *node);
+    // 修改到期时间，相当于 remove 后 add
+    void modify(TimerNode *node, uint64_t expire_ms);
+
+    // 推进时间到 now_ms，依次调用已到期定时器的回调
+    void advance(uint64_t now_ms, TimerCallback callback, void *arg);
+
+    // 距离下一个定时器到期的毫秒数，没有定时器时返回 -1，可直接作为 epoll_wait 的超时时间
+    int nextTimeout(uint64_t now_ms);
+
+    // 定时器个数
+    uint64_t size() { return m_count; }
+
+    // 当前单调时钟的毫秒数，精度为内核 tick，不需要进入内核
+    static uint64_t nowMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+};
+
+#endif // __TIMERWHEEL_H__
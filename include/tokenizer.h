@@ -0,0 +1,59 @@
+#ifndef __TOKENIZER_H__
+#define __TOKENIZER_H__
+
+/**
+ * 作用: 向量化的 http 请求行和请求头分词
+ *      一次比较 16(SSE4.2) 或 32(AVX2) 个字节查找行尾、空白和冒号，
+ *      启动时按 cpu 支持的指令集选择实现，不支持时使用逐字节的实现
+ *      只给出各部分在行中的位置和长度，不复制数据
+ */
+
+#include <stddef.h>
+
+/* 行中的一段，指向原始数据 */
+struct TokenSpan {
+    const char  *m_data;
+    int         m_len;
+};
+
+class HttpTokenizer {
+public:
+    enum IMPL {
+        IMPL_SCALAR=0,  // 逐字节
+        IMPL_SSE42,     // 每次 16 字节
+        IMPL_AVX2,      // 每次 32 字节
+    };
+
+    // 返回 [begin, end) 中第一个等于 a 或 b 的字节，没有时返回 end
+    typedef const char *(*FindFunc)(const char *begin, const char *end, char a, char b);
+
+private:
+    static FindFunc     m_find;     // 当前使用的实现
+    static IMPL         m_impl;
+
+public:
+    // 选择实现，cpu 不支持时返回 false 且不改变当前实现
+    static bool select(IMPL impl);
+    // 按 cpu 支持的指令集选择最快的实现，程序启动时自动调用
+    static IMPL selectBest();
+    // 当前实现的名称
+    static const char *implName();
+
+    // 返回 [begin, end) 中第一个等于 a 或 b 的字节，没有时返回 end
+    static const char *find(const char *begin, const char *end, char a, char b) {
+        return m_find(begin, end, a, b);
+    }
+
+    // 查找行尾，返回第一个 '\r' 或 '\n' 的位置，没有时返回 end
+    static const char *findLineEnd(const char *begin, const char *end) {
+        return m_find(begin, end, '\r', '\n');
+    }
+
+    // 解析请求行 "METHOD SP URL SP VERSION"，分隔符可以是多个空格或制表符，格式错误时返回 false
+    static bool parseRequestLine(const char *line, int len, TokenSpan *method, TokenSpan *url, TokenSpan *version);
+
+    // 解析请求头 "Name: value"，去掉值两端的空白，没有冒号或名字为空时返回 false
+    static bool parseHeader(const char *line, int len, TokenSpan *name, TokenSpan *value);
+};
+
+#endif // __TOKENIZER_H__
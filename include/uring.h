@@ -0,0 +1,170 @@
+#ifndef __URING_H__
+#define __URING_H__
+
+/**
+ * 作用: io_uring 事件后端，直接使用系统调用，不依赖 liburing
+ *      监听套接字提交一次多次触发的 accept，每个连接提交一次多次触发的 recv，
+ *      数据由内核直接写入注册的缓冲区环(provided buffer ring)，完成事件带着数据交给连接，
+ *      连接持有的缓冲区达到 URING_HELD_MAX 时取消 recv，连接不读时不会占满整个缓冲区环
+ *      输出队列中连续的内存块合并成一个 sendmsg，文件区域用 splice 经过管道送到 socket，
+ *      这些操作用 IOSQE_IO_LINK 串成一条链一次提交，队列全部发完后才通知 reactor
+ *      连接的套接字保持阻塞模式，splice 在内核的工作线程中等待发送缓冲区，不需要额外的 poll
+ *      关闭连接时先 shutdown，内核中的操作都结束后才 close，描述符在此之前不会被复用
+ *      一轮事件循环中积累的所有提交和收割只需要一次 io_uring_enter
+ *      watch 提交一次性的 poll，unwatch 用 POLL_REMOVE 取消，代数不同的完成事件被忽略
+ *      提交队列只能由创建它的线程使用，工作线程池处理请求时仍然使用 epoll
+ */
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <vector>
+
+#include "backend.h"
+#include "macro.h"
+
+class UringBackend : public EventBackend {
+public:
+    UringBackend(int close_log=0);
+    ~UringBackend();
+
+    // 内核是否支持需要的特性：多次触发的 recv、缓冲区环、带超时的等待，启动时检查一次
+    static bool supported();
+
+    const char *name() const { return "io_uring"; }
+    bool init(int listenfd, int wakeupfd);
+    int wait(BackendEvent *events, int max, int timeout);
+
+    void addConn(int fd);
+    void armRead(int fd);
+    void release(const BackendEvent &event, int used);
+    int send(int fd, OutputQueue *queue);
+    void removeConn(int fd);
+    void pauseAccept(bool pause);
+    void watch(int fd, int events);
+    void unwatch(int fd);
+
+private:
+    /* user_data 中的操作类型 */
+    enum OP {
+        OP_ACCEPT=1,
+        OP_WAKEUP,
+        OP_RECV,
+        OP_SEND,
+        OP_SPLICE_IN,
+        OP_SPLICE_OUT,
+        OP_CANCEL,
+        OP_POLL
+    };
+
+    /* 每个连接的状态，按 fd 下标，第一次使用时分配，之后复用 */
+    struct ConnState {
+        uint16_t    m_gen;              // 描述符每关闭一次加一，旧连接的完成事件被忽略
+        bool        m_open;             // 连接已经 addConn 还没有 removeConn
+        bool        m_closing;          // 已经 removeConn，等内核中的操作都结束后再关闭描述符
+        bool        m_close_sent;       // 已经产生过 EVENT_CLOSE
+        bool        m_recv_active;      // 多次触发的 recv 还在内核中
+        bool        m_starved;          // 缓冲区环用完导致 recv 停止，等有空闲缓冲区后重新提交
+        bool        m_recv_paused;      // 持有的缓冲区达到 URING_HELD_MAX，recv 已经取消，armRead 时重新提交
+        bool        m_want_read;        // 连接在等待读事件
+        bool        m_eof;              // 对端已经关闭写方向，缓冲区都交给连接之后再产生 EVENT_CLOSE
+        bool        m_ready;            // 在就绪列表中
+        int         m_held_head;        // 已经收到但还没有交给连接的缓冲区，-1 表示没有
+        int         m_held_tail;
+        int         m_held_count;
+
+        OutputQueue *m_queue;           // 正在发送的输出队列
+        int         m_inflight;         // 内核中还没有完成的发送操作数
+        bool        m_send_error;
+        size_t      m_sent;             // 本条链已经写到 socket 的字节数
+        size_t      m_pipe_fill;        // 管道中还没有写到 socket 的字节数
+        int         m_pipe[2];          // splice 使用的管道，第一次发送文件时创建，连接关闭时关闭
+        size_t      m_pipe_size;        // 管道的容量
+        FileEntry   *m_file;            // 链中文件区域的引用，链完成前文件描述符必须有效
+        struct msghdr m_msg;
+        struct iovec  m_iov[OutputQueue::MAX_CHUNKS];
+    };
+
+    /* 提交队列和完成队列在用户态的映射 */
+    int                 m_ringfd;
+    unsigned            *m_sq_khead;
+    unsigned            *m_sq_ktail;
+    unsigned            m_sq_mask;
+    unsigned            m_sq_entries;
+    unsigned            m_sq_tail;          // 本地的尾部，提交前写回内核
+    io_uring_sqe        *m_sqes;
+    unsigned            *m_cq_khead;
+    unsigned            *m_cq_ktail;
+    unsigned            m_cq_mask;
+    io_uring_cqe        *m_cqes;
+    void                *m_sq_ptr;
+    size_t              m_sq_size;
+    size_t              m_sqes_size;
+
+    /* 接收数据的缓冲区环 */
+    io_uring_buf_ring   *m_buf_ring;
+    size_t              m_buf_ring_size;
+    char                *m_bufs;
+    uint16_t            m_buf_tail;
+    bool                m_buf_returned;     // 有缓冲区归还，可以重新提交被饿死的 recv
+    int                 m_held_next[URING_RECV_BUF_COUNT];
+    int                 m_held_off[URING_RECV_BUF_COUNT];
+    int                 m_held_len[URING_RECV_BUF_COUNT];
+
+    int                 m_listenfd;
+    int                 m_wakeupfd;
+    int                 m_close_log;
+    bool                m_accept_active;    // 多次触发的 accept 还在内核中
+    bool                m_accept_paused;    // 暂停 accept，accept 结束后不再重新提交
+
+    ConnState           **m_conns;          // 按 fd 下标
+    std::vector<int>    m_ready;            // 有数据并且在等待读事件的连接
+    std::vector<int>    m_starved;          // 因为缓冲区用完停止接收的连接
+    std::vector<BackendEvent> m_pending;    // 还没有交给 reactor 的事件
+    std::vector<uint16_t> m_watch_gen;      // 按 fd 下标，每次 unwatch 加一，取消的 poll 的完成事件被忽略
+    std::vector<char>   m_watch_active;     // 按 fd 下标，poll 还在内核中
+    std::vector<io_uring_cqe> m_deferred;   // 提交队列满时移出完成队列、还没有处理的完成事件
+    io_uring_sqe        m_spare_sqe;        // 环不可用时交出的提交项，不会被提交
+    bool                m_broken;           // io_uring_enter 出错，下一次 wait 返回错误
+
+private:
+    ConnState *state(int fd);
+
+    // 取得一个提交项，提交队列剩余不足 reserve 个时先提交已有的
+    io_uring_sqe *getSqe(unsigned reserve=1);
+    // 提交并等待至少 wait_nr 个完成事件，timeout 为毫秒，-1 表示一直等待
+    int enter(unsigned wait_nr, int timeout);
+    // 把完成队列中的事件移到 m_deferred，让内核可以继续接收提交项
+    void drainCq();
+    // 处理完成队列中的所有事件
+    void reap();
+    void handleCqe(const io_uring_cqe *cqe);
+    void handleRecv(int fd, ConnState *st, const io_uring_cqe *cqe);
+    void handleSend(int fd, ConnState *st, int op, int res);
+
+    void submitAccept();
+    void submitWakeup();
+    void submitRecv(int fd, ConnState *st);
+    // 持有的缓冲区达到上限时取消多次触发的 recv
+    void pauseRecv(int fd, ConnState *st);
+    // 持有的缓冲区降到上限以下并且 recv 已经结束时重新提交
+    void resumeRecv(int fd, ConnState *st);
+    // 把输出队列队首的数据组成一条链提交，返回 -1 出错，0 没有可以发送的数据，1 已经提交
+    int submitSend(int fd, ConnState *st);
+
+    // 把缓冲区还给缓冲区环
+    void recycle(int bid);
+    // 产生一个事件
+    void pushEvent(BackendEvent::TYPE type, int fd);
+    void pushReady(int fd, ConnState *st);
+    void closeEvent(int fd, ConnState *st);
+    // 内核中没有这个连接的操作以后关闭描述符
+    void finishClose(int fd, ConnState *st);
+
+    static uint64_t userData(int op, uint16_t gen, int fd) {
+        return ((uint64_t)op << 56) | ((uint64_t)gen << 32) | (uint32_t)fd;
+    }
+};
+
+#endif // __URING_H__
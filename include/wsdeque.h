@@ -0,0 +1,150 @@
+#ifndef __WSDEQUE_H__
+#define __WSDEQUE_H__
+
+/**
+ * 作用: Chase-Lev 无锁工作窃取双端队列
+ *      只有拥有者线程可以在底部 push/pop，其它线程只能从顶部 steal
+ *      内存序参考 Lê et al. "Correct and Efficient Work-Stealing for Weak Memory Models"
+ *      元素类型 T 需要是可平凡拷贝的类型，一般为指针
+ */
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+template<typename T>
+class WorkStealDeque {
+private:
+    /* 环形数组，容量为 2 的幂 */
+    struct Array {
+        int64_t             m_cap;      // 容量
+        int64_t             m_mask;     // 下标掩码
+        std::atomic<T>      *m_buf;     // 元素
+
+        Array(int64_t cap) : m_cap(cap), m_mask(cap - 1) {
+            m_buf = new std::atomic<T>[m_cap];
+        }
+
+        ~Array() {
+            delete [] m_buf;
+        }
+
+        T get(int64_t i) {
+            return m_buf[i & m_mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t i, T x) {
+            m_buf[i & m_mask].store(x, std::memory_order_relaxed);
+        }
+
+        // 扩容为原来的两倍，拷贝 [t, b) 之间的元素
+        Array *grow(int64_t b, int64_t t) {
+            Array *a = new Array(m_cap * 2);
+            for (int64_t i = t; i < b; ++i)
+                a->put(i, get(i));
+            return a;
+        }
+    };
+
+    alignas(64) std::atomic<int64_t>    m_top;      // 窃取端
+    alignas(64) std::atomic<int64_t>    m_bottom;   // 拥有者端
+    alignas(64) std::atomic<Array *>    m_array;    // 当前数组
+    std::vector<Array *>                m_garbage;  // 扩容后的旧数组，窃取者可能仍在读取，析构时统一释放
+
+public:
+    /* 构造和析构 */
+    WorkStealDeque(int64_t cap=1024) {
+        // 容量向上取整为 2 的幂
+        int64_t real_cap = 1;
+        while (real_cap < cap)
+            real_cap <<= 1;
+
+        m_top.store(0, std::memory_order_relaxed);
+        m_bottom.store(0, std::memory_order_relaxed);
+        m_array.store(new Array(real_cap), std::memory_order_relaxed);
+    }
+
+    ~WorkStealDeque() {
+        for (size_t i = 0; i < m_garbage.size(); ++i)
+            delete m_garbage[i];
+
+        delete m_array.load(std::memory_order_relaxed);
+    }
+
+    WorkStealDeque(const WorkStealDeque &) = delete;
+    WorkStealDeque &operator=(const WorkStealDeque &) = delete;
+
+public:
+    // 队列是否为空，只是一个近似值
+    bool isempty() {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+    // 队列当前长度，只是一个近似值
+    int64_t size() {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b >= t ? b - t : 0;
+    }
+
+    // 拥有者线程在底部压入元素，队列满时自动扩容
+    void push(T x) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Array *a = m_array.load(std::memory_order_relaxed);
+
+        if (b - t > a->m_cap - 1) {
+            m_garbage.push_back(a);
+            a = a->grow(b, t);
+            m_array.store(a, std::memory_order_release);
+        }
+
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // 拥有者线程从底部弹出元素，队列为空或最后一个元素被窃取时返回 false
+    bool pop(T &x) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array *a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {    // 队列为空，恢复 bottom
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        x = a->get(b);
+        if (t == b) {
+            // 只剩最后一个元素，与窃取者竞争
+            bool ok = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, \
+                                                    std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return ok;
+        }
+
+        return true;
+    }
+
+    // 其它线程从顶部窃取元素，队列为空或竞争失败时返回 false
+    bool steal(T &x) {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return false;
+
+        Array *a = m_array.load(std::memory_order_acquire);
+        x = a->get(t);
+        return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, \
+                                             std::memory_order_relaxed);
+    }
+};
+
+#endif // __WSDEQUE_H__
@@ -0,0 +1,501 @@
+#include "asyncdb.h"
+#include "log.h"
+
+#include <poll.h>
+#include <string.h>
+
+#ifndef HAVE_MYSQL_NONBLOCK
+/* 客户端库没有非阻塞接口时只为了编译，init 直接返回 false */
+#define MYSQL_WAIT_READ     1
+#define MYSQL_WAIT_WRITE    2
+#define MYSQL_WAIT_EXCEPT   4
+#define MYSQL_WAIT_TIMEOUT  8
+#endif
+
+/* mysql 客户端错误码的范围(CR_MIN_ERROR 到 CR_MAX_ERROR)，出现时连接不能继续使用 */
+static const unsigned int CLIENT_ERROR_MIN = 2000;
+static const unsigned int CLIENT_ERROR_MAX = 2999;
+
+thread_local AsyncDb *AsyncDb::s_local = nullptr;
+
+AsyncDb::AsyncDb() : m_timer(TimerWheel::nowMs()) {
+    m_backend = nullptr;
+    m_port = 0;
+    m_timeout = ASYNC_DB_QUERY_TIMEOUT;
+    m_close_log = 0;
+    m_head = m_tail = nullptr;
+    m_free = nullptr;
+    m_pending = 0;
+    m_running = 0;
+    m_up = 0;
+    m_now = TimerWheel::nowMs();
+}
+
+// 不调用任何回调，reactor 退出时连接都已经关闭
+AsyncDb::~AsyncDb() {
+    for (size_t i = 0; i < m_conns.size(); ++i) {
+        Conn *c = &m_conns[i];
+        if (c->m_fd != -1)
+            m_backend->unwatch(c->m_fd);
+        if (c->m_sql)
+            mysql_close(c->m_sql);
+        if (c->m_query) {
+            if (c->m_query->m_result)
+                mysql_free_result(c->m_query->m_result);
+            delete c->m_query;
+        }
+    }
+
+    while (m_head) {
+        AsyncQuery *next = m_head->m_next;
+        delete m_head;
+        m_head = next;
+    }
+    while (m_free) {
+        AsyncQuery *next = m_free->m_next;
+        delete m_free;
+        m_free = next;
+    }
+}
+
+bool AsyncDb::init(EventBackend *backend, const std::string &host, int port, const std::string &user, \
+                   const std::string &passwd, const std::string &db, int conn_num, int timeout_ms, int close_log) {
+    m_close_log = close_log;
+#ifndef HAVE_MYSQL_NONBLOCK
+    LogError("async db: the mysql client library has no non-blocking api.");
+    return false;
+#endif
+    if (backend == nullptr || conn_num <= 0)
+        return false;
+
+    m_backend = backend;
+    m_host = host;
+    m_port = port;
+    m_user = user;
+    m_passwd = passwd;
+    m_db = db;
+    m_timeout = timeout_ms > 0 ? timeout_ms : ASYNC_DB_QUERY_TIMEOUT;
+    m_now = TimerWheel::nowMs();
+
+    // 连接中有侵入式的定时器节点，数组之后不能再扩大
+    m_conns.resize(conn_num);
+    for (int i = 0; i < conn_num; ++i) {
+        Conn *c = &m_conns[i];
+        c->m_sql = nullptr;
+        c->m_state = STATE_DOWN;
+        c->m_fd = -1;
+        c->m_waiting = false;
+        c->m_lib_expire = 0;
+        c->m_connect_expire = 0;
+        c->m_query = nullptr;
+        c->m_timer.m_data = c;
+        c->m_connect_ret = nullptr;
+        c->m_query_ret = 0;
+        c->m_store_ret = nullptr;
+        connect(c);
+    }
+    return true;
+}
+
+void AsyncDb::connect(Conn *c) {
+    c->m_sql = mysql_init(nullptr);
+    if (c->m_sql == nullptr) {
+        LogError("async db: mysql init failed.");
+        disconnect(c, 0, nullptr, ASYNC_DB_RECONNECT_MS);
+        return ;
+    }
+
+    c->m_state = STATE_CONNECTING;
+    c->m_connect_expire = m_now + m_timeout;
+    step(c, startPhase(c));
+}
+
+// mysql_close 会发送 COM_QUIT，只有几个字节，不会等待发送缓冲区
+void AsyncDb::disconnect(Conn *c, int error, const char *reason, int delay) {
+    if (c->m_fd != -1) {
+        m_backend->unwatch(c->m_fd);
+        c->m_fd = -1;
+    }
+    c->m_waiting = false;
+    c->m_lib_expire = 0;
+    if (c->m_sql) {
+        mysql_close(c->m_sql);
+        c->m_sql = nullptr;
+    }
+    if (c->m_state >= STATE_IDLE)
+        --m_up;
+    c->m_state = STATE_DOWN;
+    m_timer.modify(&c->m_timer, m_now + delay);
+
+    if (c->m_query) {
+        AsyncQuery *query = c->m_query;
+        c->m_query = nullptr;
+        --m_running;
+        query->m_errno = error;
+        query->m_error = reason ? reason : "";
+        complete(query);
+    }
+}
+
+void AsyncDb::execute(Conn *c, AsyncQuery *query) {
+    c->m_query = query;
+    c->m_state = STATE_QUERY;
+    ++m_running;
+    step(c, startPhase(c));
+}
+
+// 库要求等待时注册套接字，需要时同时等待超时，一次性的 watch 在就绪后由下一次 step 重新注册
+void AsyncDb::step(Conn *c, int status) {
+    if (status == 0) {
+        c->m_lib_expire = 0;
+        finishPhase(c);
+        return ;
+    }
+
+    int events = 0;
+    if (status & MYSQL_WAIT_READ)
+        events |= POLLIN;
+    if (status & MYSQL_WAIT_WRITE)
+        events |= POLLOUT;
+    if (status & MYSQL_WAIT_EXCEPT)
+        events |= POLLPRI;
+
+    c->m_lib_expire = (status & MYSQL_WAIT_TIMEOUT) ? m_now + libTimeout(c) : 0;
+    if (events) {
+        c->m_fd = socketOf(c);
+        m_backend->watch(c->m_fd, events);
+        c->m_waiting = true;
+    }
+    armTimer(c);
+}
+
+// 空闲的连接等待可读，服务器关闭连接(例如 wait_timeout)时立即发现并重新连接，不等下一个查询失败
+void AsyncDb::idle(Conn *c) {
+    c->m_state = STATE_IDLE;
+    armTimer(c);
+    c->m_fd = socketOf(c);
+    m_backend->watch(c->m_fd, POLLIN);
+    c->m_waiting = true;
+}
+
+void AsyncDb::finishPhase(Conn *c) {
+    switch (c->m_state) {
+        case STATE_CONNECTING:
+            if (c->m_connect_ret == nullptr) {
+                LogError("async db: connect %s:%d failed: %s", m_host.c_str(), m_port, mysql_error(c->m_sql));
+                disconnect(c, 0, nullptr, ASYNC_DB_RECONNECT_MS);
+                return ;
+            }
+            ++m_up;
+            idle(c);
+            LogInfo("async db: connect %s:%d, %d connections.", m_host.c_str(), m_port, m_up);
+            break;
+        case STATE_QUERY:
+            if (c->m_query_ret != 0) {
+                queryError(c);
+                return ;
+            }
+            // 没有结果集的语句直接结束，否则把结果集完整读入
+            if (mysql_field_count(c->m_sql) == 0) {
+                c->m_query->m_affected_rows = mysql_affected_rows(c->m_sql);
+                endQuery(c, 0, nullptr);
+                return ;
+            }
+            c->m_state = STATE_STORE;
+            step(c, startPhase(c));
+            break;
+        case STATE_STORE:
+            if (c->m_store_ret == nullptr) {
+                queryError(c);
+                return ;
+            }
+            c->m_query->m_result = c->m_store_ret;
+            c->m_store_ret = nullptr;
+            endQuery(c, 0, nullptr);
+            break;
+        default:
+            break;
+    }
+}
+
+void AsyncDb::endQuery(Conn *c, int error, const char *message) {
+    AsyncQuery *query = c->m_query;
+    c->m_query = nullptr;
+    --m_running;
+    idle(c);
+
+    query->m_errno = error;
+    if (error)
+        query->m_error = message;
+    complete(query);
+}
+
+// 服务器返回的错误不影响连接，客户端错误(例如连接断开)之后连接的状态不确定，立即重新连接
+void AsyncDb::queryError(Conn *c) {
+    unsigned int error = mysql_errno(c->m_sql);
+    if (error >= CLIENT_ERROR_MIN && error <= CLIENT_ERROR_MAX) {
+        std::string reason = mysql_error(c->m_sql);
+        LogError("async db: connection lost: %s", reason.c_str());
+        disconnect(c, error, reason.c_str(), 0);
+        return ;
+    }
+    endQuery(c, error, mysql_error(c->m_sql));
+}
+
+void AsyncDb::complete(AsyncQuery *query) {
+    if (query->m_callback)
+        query->m_callback(query, query->m_arg);
+    if (query->m_result) {
+        mysql_free_result(query->m_result);
+        query->m_result = nullptr;
+    }
+    freeQuery(query);
+}
+
+// 执行中的连接按库的超时和查询的超时中较早的一个，连接中按连接的超时，其余状态不需要定时器
+void AsyncDb::armTimer(Conn *c) {
+    uint64_t expire = c->m_lib_expire;
+    uint64_t deadline = 0;
+    if (c->m_query)
+        deadline = c->m_query->m_deadline;
+    else if (c->m_state == STATE_CONNECTING)
+        deadline = c->m_connect_expire;
+    if (deadline && (expire == 0 || deadline < expire))
+        expire = deadline;
+
+    if (expire)
+        m_timer.modify(&c->m_timer, expire);
+    else
+        m_timer.remove(&c->m_timer);
+}
+
+// 所有查询的超时时间相同，队首最先到期
+void AsyncDb::armQueueTimer() {
+    if (m_head)
+        m_timer.modify(&m_queue_timer, m_head->m_deadline);
+    else
+        m_timer.remove(&m_queue_timer);
+}
+
+void AsyncDb::handleTimer(TimerNode *node) {
+    Conn *c = (Conn *)node->m_data;
+
+    // 排队超时的查询
+    if (c == nullptr) {
+        while (m_head && m_head->m_deadline <= m_now) {
+            AsyncQuery *query = m_head;
+            m_head = query->m_next;
+            if (m_head == nullptr)
+                m_tail = nullptr;
+            --m_pending;
+            query->m_errno = ERROR_TIMEOUT;
+            query->m_error = "query timeout";
+            complete(query);
+        }
+        armQueueTimer();
+        return ;
+    }
+
+    if (c->m_state == STATE_DOWN) {
+        connect(c);
+        return ;
+    }
+
+    // 连接或查询进行到一半，协议的状态不确定，关闭后重新连接
+    if (c->m_state == STATE_CONNECTING && m_now >= c->m_connect_expire) {
+        LogError("async db: connect %s:%d timeout.", m_host.c_str(), m_port);
+        disconnect(c, 0, nullptr, ASYNC_DB_RECONNECT_MS);
+        return ;
+    }
+    if (c->m_query && m_now >= c->m_query->m_deadline) {
+        LogWarn("async db: query timeout, reconnect.");
+        disconnect(c, ERROR_TIMEOUT, "query timeout", 0);
+        return ;
+    }
+
+    // 库要求的超时，之前注册的 watch 由下一次 step 替换
+    if (c->m_lib_expire && m_now >= c->m_lib_expire) {
+        c->m_waiting = false;
+        c->m_lib_expire = 0;
+        step(c, continuePhase(c, MYSQL_WAIT_TIMEOUT));
+        return ;
+    }
+    armTimer(c);
+}
+
+AsyncQuery *AsyncDb::allocQuery() {
+    AsyncQuery *query = m_free;
+    if (query)
+        m_free = query->m_next;
+    else
+        query = new AsyncQuery();
+    return query;
+}
+
+void AsyncDb::freeQuery(AsyncQuery *query) {
+    query->m_callback = nullptr;
+    query->m_arg = nullptr;
+    query->m_next = m_free;
+    m_free = query;
+}
+
+AsyncQuery *AsyncDb::query(const char *sql, int len, AsyncQuery::Callback callback, void *arg) {
+    if (m_up == 0 || m_pending >= ASYNC_DB_QUEUE_MAX)
+        return nullptr;
+
+    AsyncQuery *query = allocQuery();
+    query->m_sql.assign(sql, len);
+    query->m_callback = callback;
+    query->m_arg = arg;
+    query->m_deadline = TimerWheel::nowMs() + m_timeout;
+    query->m_errno = 0;
+    query->m_error.clear();
+    query->m_result = nullptr;
+    query->m_affected_rows = 0;
+    query->m_next = nullptr;
+
+    if (m_tail)
+        m_tail->m_next = query;
+    else
+        m_head = query;
+    m_tail = query;
+    if (++m_pending == 1)
+        armQueueTimer();
+    return query;
+}
+
+// 排队的查询在出队时回收，执行中的查询在结束时回收
+void AsyncDb::cancel(AsyncQuery *query) {
+    query->m_callback = nullptr;
+}
+
+// 就绪的事件转换成库的等待状态，出错或挂断时让库自己读写后发现错误
+bool AsyncDb::handleEvent(int fd, int events) {
+    Conn *c = nullptr;
+    for (size_t i = 0; i < m_conns.size(); ++i) {
+        if (m_conns[i].m_fd == fd) {
+            c = &m_conns[i];
+            break;
+        }
+    }
+    if (c == nullptr)
+        return false;
+    // 库的超时先到，之前的等待已经被替换
+    if (!c->m_waiting)
+        return true;
+
+    m_now = TimerWheel::nowMs();
+    if (c->m_state == STATE_IDLE) {
+        LogWarn("async db: connection closed by server, reconnect.");
+        disconnect(c, 0, nullptr, 0);
+        return true;
+    }
+
+    int status = 0;
+    if (events & (POLLIN | POLLERR | POLLHUP))
+        status |= MYSQL_WAIT_READ;
+    if (events & (POLLOUT | POLLERR | POLLHUP))
+        status |= MYSQL_WAIT_WRITE;
+    if (events & POLLPRI)
+        status |= MYSQL_WAIT_EXCEPT;
+
+    c->m_waiting = false;
+    step(c, continuePhase(c, status));
+    return true;
+}
+
+void AsyncDb::advance(uint64_t now_ms) {
+    m_now = now_ms;
+    m_timer.advance(now_ms, timerCallback, this);
+    dispatch();
+}
+
+// 查询同步完成(例如立即出错)时连接马上又是空闲的，继续取下一个
+// 回调中提交的查询排在队尾，同一个循环中执行
+void AsyncDb::dispatch() {
+    while (m_head) {
+        Conn *idle = nullptr;
+        for (size_t i = 0; i < m_conns.size(); ++i) {
+            if (m_conns[i].m_state == STATE_IDLE) {
+                idle = &m_conns[i];
+                break;
+            }
+        }
+        if (idle == nullptr)
+            break;
+
+        AsyncQuery *query = m_head;
+        m_head = query->m_next;
+        if (m_head == nullptr)
+            m_tail = nullptr;
+        --m_pending;
+        query->m_next = nullptr;
+
+        if (query->m_callback == nullptr)
+            freeQuery(query);
+        else
+            execute(idle, query);
+    }
+    armQueueTimer();
+}
+
+#ifdef HAVE_MYSQL_NONBLOCK
+int AsyncDb::startPhase(Conn *c) {
+    switch (c->m_state) {
+        case STATE_CONNECTING: {
+            // 连接的超时由定时器负责，这里只让库在同样的时间内放弃
+            unsigned int timeout = (m_timeout + 999) / 1000;
+            mysql_options(c->m_sql, MYSQL_OPT_NONBLOCK, 0);
+            mysql_options(c->m_sql, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+            return mysql_real_connect_start(&c->m_connect_ret, c->m_sql, m_host.c_str(), m_user.c_str(), \
+                                            m_passwd.c_str(), m_db.c_str(), m_port, nullptr, 0);
+        }
+        case STATE_QUERY:
+            return mysql_real_query_start(&c->m_query_ret, c->m_sql, c->m_query->m_sql.data(), c->m_query->m_sql.size());
+        case STATE_STORE:
+            return mysql_store_result_start(&c->m_store_ret, c->m_sql);
+        default:
+            return 0;
+    }
+}
+
+int AsyncDb::continuePhase(Conn *c, int status) {
+    switch (c->m_state) {
+        case STATE_CONNECTING:
+            return mysql_real_connect_cont(&c->m_connect_ret, c->m_sql, status);
+        case STATE_QUERY:
+            return mysql_real_query_cont(&c->m_query_ret, c->m_sql, status);
+        case STATE_STORE:
+            return mysql_store_result_cont(&c->m_store_ret, c->m_sql, status);
+        default:
+            return 0;
+    }
+}
+
+int AsyncDb::socketOf(Conn *c) {
+    return mysql_get_socket(c->m_sql);
+}
+
+unsigned int AsyncDb::libTimeout(Conn *c) {
+    return mysql_get_timeout_value_ms(c->m_sql);
+}
+#else
+int AsyncDb::startPhase(Conn *c) {
+    c->m_connect_ret = nullptr;
+    c->m_query_ret = 1;
+    c->m_store_ret = nullptr;
+    return 0;
+}
+
+int AsyncDb::continuePhase(Conn *c, int) {
+    return startPhase(c);
+}
+
+int AsyncDb::socketOf(Conn *) {
+    return -1;
+}
+
+unsigned int AsyncDb::libTimeout(Conn *) {
+    return 0;
+}
+#endif
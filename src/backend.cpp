@@ -0,0 +1,130 @@
+#include "backend.h"
+#include "http.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+
+EpollBackend::EpollBackend(int TRIGMode) {
+    m_epollfd = -1;
+    m_listenfd = -1;
+    m_wakeupfd = -1;
+    m_TRIGMode = TRIGMode;
+}
+
+EpollBackend::~EpollBackend() {
+    if (m_epollfd != -1) close(m_epollfd);
+}
+
+// 创建 epoll，监听套接字和 eventfd 使用 LT 模式且不设置 EPOLLONESHOT
+bool EpollBackend::init(int listenfd, int wakeupfd) {
+    m_epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollfd == -1)
+        return false;
+
+    m_listenfd = listenfd;
+    m_wakeupfd = wakeupfd;
+    addfd(m_epollfd, m_listenfd, false, 0);
+    addfd(m_epollfd, m_wakeupfd, false, 0);
+    return true;
+}
+
+// 等待 epoll 事件并转换成后端事件
+int EpollBackend::wait(BackendEvent *events, int max, int timeout) {
+    if (max > MAX_EVENT_NUMBER)
+        max = MAX_EVENT_NUMBER;
+
+    int number = epoll_wait(m_epollfd, m_events, max, timeout);
+    if (number < 0)
+        return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < number; ++i) {
+        BackendEvent &event = events[i];
+        int fd = m_events[i].data.fd;
+        uint32_t mask = m_events[i].events;
+
+        event.m_fd = fd;
+        event.m_data = nullptr;
+        event.m_len = 0;
+        event.m_buf = -1;
+        if (fd == m_listenfd) {
+            event.m_type = BackendEvent::EVENT_ACCEPT;
+            event.m_fd = -1;
+        } else if (fd == m_wakeupfd) {
+            event.m_type = BackendEvent::EVENT_WAKEUP;
+        } else if (fd < (int)m_watched.size() && m_watched[fd]) {
+            // EPOLLIN 等与 POLLIN 等的取值相同
+            event.m_type = BackendEvent::EVENT_POLL;
+            event.m_len = mask;
+        } else if (mask & (EPOLLHUP | EPOLLERR)) {
+            // 连接出错或两个方向都已关闭，直接关闭连接
+            event.m_type = BackendEvent::EVENT_CLOSE;
+        } else if (mask & EPOLLIN) {
+            // 对端只关闭了写方向(EPOLLRDHUP)时先读完剩余的请求，读到 EOF 时由连接自己关闭
+            event.m_type = BackendEvent::EVENT_READ;
+        } else if (mask & EPOLLOUT) {
+            event.m_type = BackendEvent::EVENT_WRITE;
+        } else {
+            event.m_type = BackendEvent::EVENT_CLOSE;
+        }
+    }
+    return number;
+}
+
+void EpollBackend::addConn(int fd) {
+    addfd(m_epollfd, fd, true, m_TRIGMode);
+}
+
+void EpollBackend::armRead(int fd) {
+    modfd(m_epollfd, fd, EPOLLIN, m_TRIGMode);
+}
+
+// 直接发送，发送缓冲区满时注册 EPOLLOUT
+// 不带 EPOLLRDHUP，对端只关闭写方向时仍然可以把响应发完
+int EpollBackend::send(int fd, OutputQueue *queue) {
+    int ret = queue->flush(fd);
+    if (ret == 0) {
+        epoll_event event;
+        event.data.fd = fd;
+        event.events = EPOLLOUT | EPOLLONESHOT | (m_TRIGMode == 1 ? EPOLLET : 0);
+        epoll_ctl(m_epollfd, EPOLL_CTL_MOD, fd, &event);
+    }
+    return ret;
+}
+
+void EpollBackend::removeConn(int fd) {
+    removefd(m_epollfd, fd);
+}
+
+// 暂停时把监听套接字从 epoll 中删除，恢复时重新加入
+void EpollBackend::pauseAccept(bool pause) {
+    if (pause)
+        epoll_ctl(m_epollfd, EPOLL_CTL_DEL, m_listenfd, 0);
+    else
+        addfd(m_epollfd, m_listenfd, false, 0);
+}
+
+// 第一次 watch 时加入 epoll，之后用 EPOLL_CTL_MOD 重新开启一次性的事件
+void EpollBackend::watch(int fd, int events) {
+    if (fd >= (int)m_watched.size())
+        m_watched.resize(fd + 1, 0);
+
+    epoll_event event;
+    event.data.fd = fd;
+    event.events = events | EPOLLONESHOT;
+    if (m_watched[fd]) {
+        epoll_ctl(m_epollfd, EPOLL_CTL_MOD, fd, &event);
+    } else {
+        epoll_ctl(m_epollfd, EPOLL_CTL_ADD, fd, &event);
+        m_watched[fd] = 1;
+    }
+}
+
+// 描述符关闭之前从 epoll 中删除，否则复用这个 fd 的连接会被当成 watch 的描述符
+void EpollBackend::unwatch(int fd) {
+    if (fd < 0 || fd >= (int)m_watched.size() || !m_watched[fd])
+        return ;
+
+    epoll_ctl(m_epollfd, EPOLL_CTL_DEL, fd, 0);
+    m_watched[fd] = 0;
+}
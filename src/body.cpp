@@ -0,0 +1,139 @@
+#include "body.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "log.h"
+
+FileBodySink::FileBodySink() {
+    m_fd = -1;
+    m_pipe[0] = m_pipe[1] = -1;
+    m_written = 0;
+    m_path = nullptr;
+    m_tmp[0] = '\0';
+    m_close_log = 1;
+}
+
+FileBodySink::~FileBodySink() {
+    onAbort();
+}
+
+// 在 path 所在的目录创建临时文件
+bool FileBodySink::open(const char *path) {
+    onAbort();
+
+    const char *slash = strrchr(path, '/');
+    if (slash == nullptr || slash[1] == '\0') {
+        errno = EISDIR;
+        return false;
+    }
+
+    int dir_len = slash - path;
+    if (snprintf(m_tmp, PATH_LEN, "%.*s/.upload-XXXXXX", dir_len, path) >= PATH_LEN) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+
+    m_fd = mkostemp(m_tmp, O_CLOEXEC);
+    if (m_fd == -1) {
+        m_tmp[0] = '\0';
+        return false;
+    }
+    fchmod(m_fd, 0644);
+    m_path = path;
+    m_written = 0;
+    return true;
+}
+
+// 写入一块请求体，普通文件的 write 会阻塞直到写完
+bool FileBodySink::onData(const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t ret = ::write(m_fd, data, len);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            LogError("upload write %s error: %s", m_tmp, strerror(errno));
+            return false;
+        }
+        data += ret;
+        len -= ret;
+        m_written += ret;
+    }
+    return true;
+}
+
+// 经过管道把 socket 中的数据 splice 到文件
+ssize_t FileBodySink::receive(int sockfd, size_t len) {
+    if (m_pipe[0] == -1 && pipe2(m_pipe, O_NONBLOCK | O_CLOEXEC) == -1)
+        return -2;
+
+    // 管道默认容量 64KB
+    if (len > 65536)
+        len = 65536;
+
+    ssize_t in = splice(sockfd, nullptr, m_pipe[1], nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (in <= 0)
+        return in;
+
+    // 管道中的数据必须全部写入文件，否则后面的数据会错位
+    ssize_t left = in;
+    while (left > 0) {
+        ssize_t out = splice(m_pipe[0], nullptr, m_fd, nullptr, left, SPLICE_F_MOVE);
+        if (out <= 0) {
+            if (out < 0 && errno == EINTR)
+                continue;
+            LogError("upload splice %s error: %s", m_tmp, strerror(errno));
+            errno = EIO;
+            return -1;
+        }
+        left -= out;
+    }
+
+    m_written += in;
+    return in;
+}
+
+// 接收完毕，临时文件改名为目标文件
+bool FileBodySink::onEnd() {
+    if (m_fd == -1)
+        return false;
+
+    close();
+    if (rename(m_tmp, m_path) == -1) {
+        LogError("upload rename %s to %s error: %s", m_tmp, m_path, strerror(errno));
+        unlink(m_tmp);
+        m_tmp[0] = '\0';
+        return false;
+    }
+
+    LogInfo("upload %s: %lu bytes", m_path, (unsigned long)m_written);
+    m_tmp[0] = '\0';
+    return true;
+}
+
+// 没有接收完，删除临时文件
+void FileBodySink::onAbort() {
+    close();
+    if (m_tmp[0] != '\0') {
+        unlink(m_tmp);
+        m_tmp[0] = '\0';
+    }
+}
+
+// 关闭文件和管道
+void FileBodySink::close() {
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    if (m_pipe[0] != -1) {
+        ::close(m_pipe[0]);
+        ::close(m_pipe[1]);
+        m_pipe[0] = m_pipe[1] = -1;
+    }
+}
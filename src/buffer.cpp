@@ -0,0 +1,108 @@
+#include "buffer.h"
+
+/* 每个线程缓存的少量空闲段，keep-alive 连接每个请求都会取出和归还读缓冲区和输出队列的段，
+ * 在同一个线程中周转时不需要加锁，线程退出时还给共享的空闲链表 */
+struct LocalSegments {
+    BufferSegment   *m_segs[SEGMENT_LOCAL_CACHE];
+    int             m_count;
+
+    LocalSegments() : m_count(0) {}
+    ~LocalSegments() {
+        while (m_count > 0)
+            SegmentPool::get()->freeShared(m_segs[--m_count]);
+    }
+};
+
+static thread_local LocalSegments _local;
+
+SegmentPool::SegmentPool() {
+    m_free = nullptr;
+    m_free_count = 0;
+    m_max_free = SEGMENT_POOL_MAX_FREE;
+}
+
+SegmentPool::~SegmentPool() {
+    while (m_free) {
+        BufferSegment *seg = m_free;
+        m_free = seg->m_next;
+        delete seg;
+    }
+}
+
+// 设置最多保留的空闲段个数
+void SegmentPool::init(size_t max_free) {
+    m_mutex.lock();
+    m_max_free = max_free;
+    m_mutex.unlock();
+}
+
+// 取出一个段，先从线程的缓存中取，再从共享的空闲链表取，都为空时新分配
+BufferSegment *SegmentPool::alloc() {
+    if (_local.m_count > 0) {
+        BufferSegment *seg = _local.m_segs[--_local.m_count];
+        seg->m_next = nullptr;
+        return seg;
+    }
+
+    BufferSegment *seg = nullptr;
+
+    m_mutex.lock();
+    if (m_free) {
+        seg = m_free;
+        m_free = seg->m_next;
+        --m_free_count;
+    }
+    m_mutex.unlock();
+
+    if (seg == nullptr)
+        seg = new BufferSegment;
+
+    seg->m_next = nullptr;
+    return seg;
+}
+
+// 归还一个段，线程的缓存满时还给共享的空闲链表
+void SegmentPool::free(BufferSegment *seg) {
+    if (seg == nullptr)
+        return ;
+
+    if (_local.m_count < SEGMENT_LOCAL_CACHE) {
+        _local.m_segs[_local.m_count++] = seg;
+        return ;
+    }
+    freeShared(seg);
+}
+
+// 还给共享的空闲链表
+void SegmentPool::freeShared(BufferSegment *seg) {
+
+    m_mutex.lock();
+    if (m_free_count < m_max_free) {
+        seg->m_next = m_free;
+        m_free = seg;
+        ++m_free_count;
+        seg = nullptr;
+    }
+    m_mutex.unlock();
+
+    // 空闲段已经足够多，直接释放
+    if (seg)
+        delete seg;
+}
+
+// 归还从 head 开始到 end(不含)为止的整条链表
+void SegmentPool::freeChain(BufferSegment *head, BufferSegment *end) {
+    while (head != end) {
+        BufferSegment *next = head->m_next;
+        free(head);
+        head = next;
+    }
+}
+
+// 空闲段的个数，包括当前线程缓存的
+size_t SegmentPool::freeCount() {
+    m_mutex.lock();
+    size_t count = m_free_count;
+    m_mutex.unlock();
+    return count + _local.m_count;
+}
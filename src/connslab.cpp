@@ -0,0 +1,55 @@
+#include "connslab.h"
+
+#include <sys/mman.h>
+#include <new>
+
+ConnSlab::ConnSlab() {
+    m_conns = nullptr;
+    m_size = 0;
+    m_built = nullptr;
+    m_capacity = 0;
+}
+
+// 只析构构造过的对象，未使用的页不会被触碰
+ConnSlab::~ConnSlab() {
+    for (int fd = 0; fd < m_capacity; ++fd) {
+        if (m_built[fd].load(std::memory_order_acquire))
+            m_conns[fd].~HttpConn();
+    }
+
+    if (m_conns) munmap(m_conns, m_size);
+    if (m_built) delete [] m_built;
+}
+
+// 预留地址空间，MAP_NORESERVE 使未使用的槽位不计入内存提交
+bool ConnSlab::init(int capacity) {
+    if (m_conns != nullptr || capacity <= 0)
+        return false;
+
+    m_size = sizeof(HttpConn) * (size_t)capacity;
+    void *addr = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        m_size = 0;
+        return false;
+    }
+
+    // 连接很多时按 fd 随机访问连接对象，大页减少 TLB 未命中，内核不支持时忽略
+    madvise(addr, m_size, MADV_HUGEPAGE);
+
+    m_conns = (HttpConn *)addr;
+    m_built = new std::atomic<bool>[capacity]();
+    m_capacity = capacity;
+    return true;
+}
+
+// 第一次使用时原地构造，之后直接返回
+HttpConn *ConnSlab::acquire(int fd) {
+    if (fd < 0 || fd >= m_capacity)
+        return nullptr;
+
+    if (!m_built[fd].load(std::memory_order_acquire)) {
+        new (m_conns + fd) HttpConn();
+        m_built[fd].store(true, std::memory_order_release);
+    }
+    return m_conns + fd;
+}
@@ -0,0 +1,315 @@
+#include "credential.h"
+#include "mysqlpool.h"
+#include "log.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+// 每个线程固定使用一个读者分片，第一次读时按顺序分配
+static std::atomic<int> _next_shard(0);
+static thread_local int _reader_shard = -1;
+
+CredentialStore::CredentialStore() : m_current(new Snapshot()), m_epoch(0), m_pool(nullptr), \
+    m_refresh_ms(CREDENTIAL_REFRESH_MS), m_close_log(0) {
+    for (int i = 0; i < CREDENTIAL_READER_SHARDS; ++i) {
+        m_readers[i].m_active[0].store(0, std::memory_order_relaxed);
+        m_readers[i].m_active[1].store(0, std::memory_order_relaxed);
+    }
+}
+
+CredentialStore::~CredentialStore() {
+    // 刷新线程在进程退出前一直运行，快照交由系统回收
+}
+
+// FNV-1a，0 表示空槽，不会作为哈希值
+uint32_t CredentialStore::hash(const char *data, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; ++i) {
+        h ^= (unsigned char)data[i];
+        h *= 16777619u;
+    }
+    return h == 0 ? 1 : h;
+}
+
+// 线性探测，遇到空槽说明不存在
+const CredentialStore::Slot *CredentialStore::Snapshot::find(const char *user, int len, uint32_t hash) const {
+    if (m_count == 0)
+        return nullptr;
+
+    for (uint32_t i = hash & m_mask; ; i = (i + 1) & m_mask) {
+        const Slot *slot = m_slots + i;
+        if (slot->m_hash == 0)
+            return nullptr;
+        if (slot->m_hash == hash && slot->m_user_len == len && memcmp(m_arena + slot->m_offset, user, len) == 0)
+            return slot;
+    }
+}
+
+// 槽数不小于用户数的两倍，探测序列很短
+CredentialStore::Snapshot *CredentialStore::build(const UserList &users) {
+    Snapshot *snapshot = new Snapshot();
+    uint32_t capacity = 16;
+    while (capacity < users.size() * 2)
+        capacity <<= 1;
+
+    size_t arena_len = 0;
+    for (size_t i = 0; i < users.size(); ++i)
+        arena_len += users[i].first.size() + users[i].second.size();
+
+    snapshot->m_mask = capacity - 1;
+    snapshot->m_slots = new Slot[capacity];
+    memset(snapshot->m_slots, 0, sizeof(Slot) * capacity);
+    snapshot->m_arena = new char[arena_len > 0 ? arena_len : 1];
+
+    uint32_t offset = 0;
+    for (size_t i = 0; i < users.size(); ++i) {
+        const std::string &user = users[i].first;
+        const std::string &passwd = users[i].second;
+        if (user.empty() || user.size() > UINT16_MAX || passwd.size() > UINT16_MAX)
+            continue;
+
+        uint32_t h = hash(user.data(), user.size());
+        Slot *slot = const_cast<Slot *>(snapshot->find(user.data(), user.size(), h));
+        if (slot == nullptr) {
+            uint32_t j = h & snapshot->m_mask;
+            while (snapshot->m_slots[j].m_hash != 0)
+                j = (j + 1) & snapshot->m_mask;
+            slot = snapshot->m_slots + j;
+            slot->m_hash = h;
+            ++snapshot->m_count;
+        }
+
+        // 重复的用户名使用新的偏移，旧的字节留在 m_arena 中不再引用
+        memcpy(snapshot->m_arena + offset, user.data(), user.size());
+        memcpy(snapshot->m_arena + offset + user.size(), passwd.data(), passwd.size());
+        slot->m_offset = offset;
+        slot->m_user_len = user.size();
+        slot->m_passwd_len = passwd.size();
+        offset += user.size() + passwd.size();
+    }
+    return snapshot;
+}
+
+void CredentialStore::dump(const Snapshot *snapshot, UserList *users) {
+    users->reserve(users->size() + snapshot->m_count);
+    for (uint32_t i = 0; snapshot->m_count > 0 && i <= snapshot->m_mask; ++i) {
+        const Slot &slot = snapshot->m_slots[i];
+        if (slot.m_hash == 0)
+            continue;
+        const char *user = snapshot->m_arena + slot.m_offset;
+        users->emplace_back(std::string(user, slot.m_user_len), std::string(user + slot.m_user_len, slot.m_passwd_len));
+    }
+}
+
+// 先在当前纪元的计数上加一，再确认纪元没有变化，之后读到的快照在离开前不会被释放
+const CredentialStore::Snapshot *CredentialStore::enter(int *shard, int *parity) const {
+    if (_reader_shard < 0)
+        _reader_shard = _next_shard.fetch_add(1, std::memory_order_relaxed) % CREDENTIAL_READER_SHARDS;
+    *shard = _reader_shard;
+
+    while (true) {
+        uint64_t epoch = m_epoch.load();
+        *parity = epoch & 1;
+        std::atomic<long> &active = m_readers[*shard].m_active[*parity];
+        active.fetch_add(1);
+        if (m_epoch.load() == epoch)
+            break;
+        active.fetch_sub(1);
+    }
+    return m_current.load();
+}
+
+void CredentialStore::leave(int shard, int parity) const {
+    m_readers[shard].m_active[parity].fetch_sub(1, std::memory_order_release);
+}
+
+// 读到旧快照的读者都是在交换之前确认的纪元，翻转纪元后等这些计数归零
+void CredentialStore::synchronize() {
+    int parity = m_epoch.fetch_add(1) & 1;
+    for (int i = 0; i < CREDENTIAL_READER_SHARDS; ++i) {
+        while (m_readers[i].m_active[parity].load(std::memory_order_acquire) != 0)
+            sched_yield();
+    }
+}
+
+void CredentialStore::publish(Snapshot *next) {
+    Snapshot *old = m_current.load();
+    next->m_version = old->m_version + 1;
+    m_current.store(next);
+    synchronize();
+    delete old;
+}
+
+bool CredentialStore::verify(const char *user, int user_len, const char *passwd, int passwd_len) const {
+    int shard, parity;
+    const Snapshot *snapshot = enter(&shard, &parity);
+    const Slot *slot = snapshot->find(user, user_len, hash(user, user_len));
+
+    // 长度相同时逐字节异或，耗时与第一个不同的字节位置无关
+    bool ok = false;
+    if (slot && slot->m_passwd_len == passwd_len) {
+        const char *expect = snapshot->m_arena + slot->m_offset + slot->m_user_len;
+        unsigned char diff = 0;
+        for (int i = 0; i < passwd_len; ++i)
+            diff |= expect[i] ^ passwd[i];
+        ok = diff == 0;
+    }
+
+    leave(shard, parity);
+    return ok;
+}
+
+bool CredentialStore::contains(const char *user, int len) const {
+    int shard, parity;
+    const Snapshot *snapshot = enter(&shard, &parity);
+    bool found = snapshot->find(user, len, hash(user, len)) != nullptr;
+    leave(shard, parity);
+    return found;
+}
+
+size_t CredentialStore::size() const {
+    int shard, parity;
+    size_t count = enter(&shard, &parity)->m_count;
+    leave(shard, parity);
+    return count;
+}
+
+uint64_t CredentialStore::version() const {
+    int shard, parity;
+    uint64_t version = enter(&shard, &parity)->m_version;
+    leave(shard, parity);
+    return version;
+}
+
+void CredentialStore::load(const UserList &users) {
+    Snapshot *next = build(users);
+    m_write_mutex.lock();
+    publish(next);
+    m_write_mutex.unlock();
+}
+
+// 写者持有互斥锁，当前快照不会被其它写者释放，可以直接读取
+bool CredentialStore::upsert(const std::string &user, const std::string &passwd) {
+    if (user.empty() || user.size() > UINT16_MAX || passwd.size() > UINT16_MAX)
+        return false;
+
+    UserList users;
+    m_write_mutex.lock();
+    dump(m_current.load(), &users);
+    users.emplace_back(user, passwd);
+    publish(build(users));
+    m_write_mutex.unlock();
+    return true;
+}
+
+bool CredentialStore::remove(const std::string &user) {
+    m_write_mutex.lock();
+    const Snapshot *current = m_current.load();
+    if (current->find(user.data(), user.size(), hash(user.data(), user.size())) == nullptr) {
+        m_write_mutex.unlock();
+        return false;
+    }
+
+    UserList users;
+    dump(current, &users);
+    for (size_t i = 0; i < users.size(); ++i) {
+        if (users[i].first == user) {
+            users[i] = users.back();
+            users.pop_back();
+            break;
+        }
+    }
+    publish(build(users));
+    m_write_mutex.unlock();
+    return true;
+}
+
+// 查询在写锁之外完成，只有比较和发布持有写锁
+int CredentialStore::refresh(MysqlPool *pool) {
+    UserList users;
+    {
+        MYSQL *sql = nullptr;
+        MysqlConnRAII sql_conn(&sql, pool);
+        if (sql == nullptr) {
+            LogError("credential: no mysql connect.");
+            return -1;
+        }
+
+        // 在 user 表中检索 username, passwd 数据，语句在这个连接上只准备一次
+        StmtCache *stmts = sql_conn.stmts();
+        MysqlStmt *stmt = stmts->prepare("select username,passwd from user");
+        if (stmt == nullptr) {
+            LogError("credential: mysql prepare error: %s", stmts->error());
+            return -1;
+        }
+        if (!stmt->execute()) {
+            LogError("credential: mysql select error: %s", stmt->error());
+            return -1;
+        }
+        while (stmt->fetch()) {
+            unsigned long user_len, passwd_len;
+            const char *user = stmt->getString(0, &user_len);
+            const char *passwd = stmt->getString(1, &passwd_len);
+            if (user == nullptr || passwd == nullptr)
+                continue;
+            users.emplace_back(std::string(user, user_len), std::string(passwd, passwd_len));
+        }
+        bool failed = stmt->errorno() != 0;
+        if (failed)
+            LogError("credential: mysql fetch error: %s", stmt->error());
+        stmt->freeResult();
+        if (failed)
+            return -1;
+    }
+
+    Snapshot *next = build(users);
+    m_write_mutex.lock();
+    const Snapshot *current = m_current.load();
+    uint32_t added = 0, changed = 0;
+    for (uint32_t i = 0; next->m_count > 0 && i <= next->m_mask; ++i) {
+        const Slot &slot = next->m_slots[i];
+        if (slot.m_hash == 0)
+            continue;
+        const char *user = next->m_arena + slot.m_offset;
+        const Slot *old = current->find(user, slot.m_user_len, slot.m_hash);
+        if (old == nullptr)
+            ++added;
+        else if (old->m_passwd_len != slot.m_passwd_len || \
+                 memcmp(current->m_arena + old->m_offset + old->m_user_len, user + slot.m_user_len, slot.m_passwd_len) != 0)
+            ++changed;
+    }
+    uint32_t removed = current->m_count - (next->m_count - added);
+    int total = added + changed + removed;
+
+    if (total == 0) {
+        m_write_mutex.unlock();
+        delete next;
+        return 0;
+    }
+    publish(next);
+    m_write_mutex.unlock();
+
+    LogInfo("credential: %u users, %u added, %u changed, %u removed", next->m_count, added, changed, removed);
+    return total;
+}
+
+bool CredentialStore::startRefresh(MysqlPool *pool, int interval_ms, int close_log) {
+    m_pool = pool;
+    m_refresh_ms = interval_ms;
+    m_close_log = close_log;
+
+    if (pthread_create(&m_tid, nullptr, refreshThreadRun, nullptr) != 0) {
+        LogError("credential: create refresh thread failed.");
+        return false;
+    }
+    pthread_detach(m_tid);
+    return true;
+}
+
+void CredentialStore::refreshLoop() {
+    while (true) {
+        usleep(m_refresh_ms * 1000);
+        refresh(m_pool);
+    }
+}
@@ -0,0 +1,447 @@
+#include "filecache.h"
+#include "response.h"
+#include "log.h"
+#include "debug.h"
+
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+#include <vector>
+
+// inotify 关注的事件：内容修改、属性或链接数变化(rename 替换会减少旧文件的链接数)、删除和移动
+static const uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF;
+
+FileCache::FileCache() {
+    m_shard_bytes = 0;
+    m_shard_count = 0;
+    m_inotifyfd = -1;
+    m_close_log = 0;
+
+    for (int i = 0; i < SHARD_NUM; ++i) {
+        m_shards[i].m_head = nullptr;
+        m_shards[i].m_tail = nullptr;
+        m_shards[i].m_bytes = 0;
+        m_shards[i].m_count = 0;
+    }
+}
+
+FileCache::~FileCache() {
+    // inotify 线程在进程退出前一直阻塞在 read 上，缓存的文件交由系统回收
+}
+
+// 初始化缓存，启动 inotify 线程
+bool FileCache::init(size_t max_bytes, size_t max_files, int close_log) {
+    m_close_log = close_log;
+    m_shard_bytes = max_bytes / SHARD_NUM;
+    m_shard_count = max_files / SHARD_NUM + 1;
+
+    m_inotifyfd = inotify_init1(IN_CLOEXEC);
+    if (m_inotifyfd < 0) {
+        LogError("filecache: inotify_init1 failed: %s, cache disabled.", strerror(errno));
+        return false;
+    }
+
+    if (pthread_create(&m_tid, nullptr, watchThreadRun, nullptr) != 0) {
+        LogError("filecache: create inotify thread failed, cache disabled.");
+        close(m_inotifyfd);
+        m_inotifyfd = -1;
+        return false;
+    }
+    pthread_detach(m_tid);
+
+    return true;
+}
+
+// 计算路径所在的分片
+FileCache::Shard *FileCache::shardOf(std::string_view path) {
+    return m_shards + std::hash<std::string_view>()(path) % SHARD_NUM;
+}
+
+// 格式化 Last-Modified 和 ETag 响应头，ETag 由 inode、大小和纳秒精度的修改时间组成，
+// 文件被替换或修改后至少有一项不同
+static void formatValidators(FileEntry *entry) {
+    const struct stat &st = entry->m_stat;
+    char *buf = entry->m_validators;
+    int len = 0;
+
+    memcpy(buf, "Last-Modified: ", 15);
+    len += 15;
+    entry->m_last_modified = buf + len;
+    len += HttpDate::format(st.st_mtime, buf + len);
+
+    memcpy(buf + len, "\r\nETag: ", 8);
+    len += 8;
+    entry->m_etag = buf + len;
+    uint64_t mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    entry->m_etag_len = snprintf(buf + len, FileEntry::VALIDATORS_LEN - len - 2, "\"%lx-%lx-%lx\"", \
+                                 (unsigned long)st.st_ino, (unsigned long)st.st_size, (unsigned long)mtime);
+    len += entry->m_etag_len;
+
+    memcpy(buf + len, "\r\n", 2);
+    entry->m_validators_len = len + 2;
+}
+
+// 查找预压缩版本，只在打开文件时各 stat 一次，比原文件旧的版本视为过期
+// 压缩文件本身不再查找，之后新生成的版本要等原文件的缓存失效后才会被发现
+static int findVariants(const char *path, const struct stat &st) {
+    static const struct {
+        FILE_VARIANT    m_variant;
+        const char      *m_suffix;
+    } suffixes[] = {{VARIANT_BR, ".br"}, {VARIANT_GZIP, ".gz"}};
+
+    int len = strlen(path);
+    if (len + 4 > PATH_MAX || (len > 3 && (strcmp(path + len - 3, ".br") == 0 || strcmp(path + len - 3, ".gz") == 0)))
+        return VARIANT_NONE;
+
+    char variant[PATH_MAX];
+    memcpy(variant, path, len);
+    int found = VARIANT_NONE;
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+        memcpy(variant + len, suffixes[i].m_suffix, 4);
+        struct stat vst;
+        if (stat(variant, &vst) == 0 && S_ISREG(vst.st_mode) && vst.st_mtime >= st.st_mtime)
+            found |= suffixes[i].m_variant;
+    }
+    return found;
+}
+
+// 按扩展名查找 Content-Type，扩展名不区分大小写
+static const char *mimeType(const char *path) {
+    static const struct {
+        const char  *m_ext;
+        const char  *m_mime;
+    } types[] = {
+        {"html", "text/html"}, {"htm", "text/html"}, {"css", "text/css"},
+        {"js", "text/javascript"}, {"mjs", "text/javascript"}, {"json", "application/json"},
+        {"txt", "text/plain"}, {"xml", "application/xml"}, {"svg", "image/svg+xml"},
+        {"png", "image/png"}, {"jpg", "image/jpeg"}, {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"}, {"webp", "image/webp"}, {"ico", "image/x-icon"},
+        {"mp4", "video/mp4"}, {"webm", "video/webm"}, {"mp3", "audio/mpeg"},
+        {"ogg", "audio/ogg"}, {"wav", "audio/wav"}, {"pdf", "application/pdf"},
+        {"wasm", "application/wasm"}, {"woff", "font/woff"}, {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"}, {"gz", "application/gzip"}, {"zip", "application/zip"},
+    };
+
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    if (dot != nullptr && (slash == nullptr || dot > slash)) {
+        for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+            if (strcasecmp(dot + 1, types[i].m_ext) == 0)
+                return types[i].m_mime;
+        }
+    }
+    return "application/octet-stream";
+}
+
+// 打开文件并创建一个未缓存的 entry
+FileEntry *FileCache::openEntry(const char *path, int *error) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = errno;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        *error = errno;
+        close(fd);
+        return nullptr;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        *error = EISDIR;
+        close(fd);
+        return nullptr;
+    }
+
+    if (!(st.st_mode & S_IROTH)) {
+        *error = EACCES;
+        close(fd);
+        return nullptr;
+    }
+
+    // 小文件映射到内存，与响应头一起 writev；大文件只保留描述符给 sendfile
+    char *address = nullptr;
+    if (st.st_size > 0 && st.st_size <= MMAP_FILE_MAX) {
+        address = (char *)mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            *error = errno;
+            close(fd);
+            return nullptr;
+        }
+    }
+
+    FileEntry *entry = new FileEntry;
+    entry->m_path = path;
+    entry->m_fd = fd;
+    entry->m_stat = st;
+    entry->m_address = address;
+    formatValidators(entry);
+    entry->m_variants = findVariants(path, st);
+    entry->m_mime = mimeType(path);
+    entry->m_wd = -1;
+    entry->m_charge = sizeof(FileEntry) + entry->m_path.size() + (address ? st.st_size : 0);
+    entry->m_refs.store(1, std::memory_order_relaxed);
+    entry->m_prev = nullptr;
+    entry->m_next = nullptr;
+    return entry;
+}
+
+// 释放 entry 占用的资源
+void FileCache::destroyEntry(FileEntry *entry) {
+    if (entry->m_address)
+        munmap(entry->m_address, entry->m_stat.st_size);
+
+    close(entry->m_fd);
+    delete entry;
+}
+
+// 释放一次引用，最后一个引用释放时关闭文件并解除映射
+void FileCache::release(FileEntry *entry) {
+    if (entry == nullptr)
+        return ;
+
+    if (entry->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        destroyEntry(entry);
+}
+
+// 已经持有引用时再增加一次引用，返回 entry
+FileEntry *FileCache::retain(FileEntry *entry) {
+    if (entry)
+        entry->m_refs.fetch_add(1, std::memory_order_relaxed);
+    return entry;
+}
+
+void FileCache::lruUnlink(Shard *shard, FileEntry *entry) {
+    if (entry->m_prev) entry->m_prev->m_next = entry->m_next;
+    else shard->m_head = entry->m_next;
+
+    if (entry->m_next) entry->m_next->m_prev = entry->m_prev;
+    else shard->m_tail = entry->m_prev;
+
+    entry->m_prev = nullptr;
+    entry->m_next = nullptr;
+}
+
+void FileCache::lruPushFront(Shard *shard, FileEntry *entry) {
+    entry->m_prev = nullptr;
+    entry->m_next = shard->m_head;
+    if (shard->m_head) shard->m_head->m_prev = entry;
+    shard->m_head = entry;
+    if (shard->m_tail == nullptr) shard->m_tail = entry;
+}
+
+// 从分片中移除 entry，调用者持有分片锁
+void FileCache::detach(Shard *shard, FileEntry *entry) {
+    shard->m_map.erase(std::string_view(entry->m_path));
+    lruUnlink(shard, entry);
+    shard->m_bytes -= entry->m_charge;
+    --shard->m_count;
+}
+
+// 取消 entry 的 inotify 监视，调用者持有 m_watch_mutex
+// 同一个 inode 的多个路径共享一个监视描述符，最后一个路径移除时才真正删除监视
+void FileCache::unwatch(FileEntry *entry) {
+    auto range = m_watches.equal_range(entry->m_wd);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == entry->m_path) {
+            m_watches.erase(it);
+            break;
+        }
+    }
+
+    if (m_watches.count(entry->m_wd) == 0)
+        inotify_rm_watch(m_inotifyfd, entry->m_wd);
+}
+
+// 获取文件，返回的 entry 引用计数已加一
+FileEntry *FileCache::acquire(const char *path, int *error) {
+    std::string_view key(path);
+    Shard *shard = shardOf(key);
+
+    // 命中时只需要一次分片锁，不做任何系统调用
+    if (m_inotifyfd != -1) {
+        shard->m_mutex.lock();
+        auto it = shard->m_map.find(key);
+        if (it != shard->m_map.end()) {
+            FileEntry *entry = it->second;
+            entry->m_refs.fetch_add(1, std::memory_order_relaxed);
+            lruUnlink(shard, entry);
+            lruPushFront(shard, entry);
+            shard->m_mutex.unlock();
+            return entry;
+        }
+        shard->m_mutex.unlock();
+    }
+
+    FileEntry *entry = openEntry(path, error);
+    if (entry == nullptr || m_inotifyfd == -1)
+        return entry;
+
+    // 未命中的路径很少，串行化在 m_watch_mutex 上，锁顺序为 m_watch_mutex -> 分片锁
+    m_watch_mutex.lock();
+
+    int wd = inotify_add_watch(m_inotifyfd, path, WATCH_MASK);
+    struct stat st;
+    if (wd < 0 || stat(path, &st) < 0 || st.st_ino != entry->m_stat.st_ino || \
+        st.st_dev != entry->m_stat.st_dev || st.st_mtime != entry->m_stat.st_mtime || \
+        st.st_size != entry->m_stat.st_size) {
+        // 监视失败，或者打开之后文件已经被替换或修改，本次不缓存
+        if (wd >= 0 && m_watches.count(wd) == 0)
+            inotify_rm_watch(m_inotifyfd, wd);
+        m_watch_mutex.unlock();
+        return entry;
+    }
+
+    std::vector<FileEntry *> evicted;
+    shard->m_mutex.lock();
+    auto it = shard->m_map.find(key);
+    if (it != shard->m_map.end()) {
+        // 其它线程在等待 m_watch_mutex 期间已经缓存了同一路径，使用已缓存的 entry
+        FileEntry *cached = it->second;
+        cached->m_refs.fetch_add(1, std::memory_order_relaxed);
+        shard->m_mutex.unlock();
+        if (m_watches.count(wd) == 0)
+            inotify_rm_watch(m_inotifyfd, wd);
+        m_watch_mutex.unlock();
+        release(entry);
+        return cached;
+    }
+
+    entry->m_wd = wd;
+    entry->m_refs.fetch_add(1, std::memory_order_relaxed);     // 缓存持有的引用
+    shard->m_map.emplace(std::string_view(entry->m_path), entry);
+    lruPushFront(shard, entry);
+    shard->m_bytes += entry->m_charge;
+    ++shard->m_count;
+    m_watches.emplace(wd, entry->m_path);
+
+    // 超出预算时从最久未使用的一端淘汰，刚插入的不淘汰
+    while ((shard->m_bytes > m_shard_bytes || shard->m_count > m_shard_count) && shard->m_tail != entry) {
+        FileEntry *victim = shard->m_tail;
+        detach(shard, victim);
+        evicted.push_back(victim);
+    }
+    shard->m_mutex.unlock();
+
+    for (size_t i = 0; i < evicted.size(); ++i)
+        unwatch(evicted[i]);
+    m_watch_mutex.unlock();
+
+    for (size_t i = 0; i < evicted.size(); ++i)
+        release(evicted[i]);
+
+    return entry;
+}
+
+// 处理 inotify 事件，移除该监视描述符对应的所有缓存
+void FileCache::invalidate(int wd) {
+    std::vector<FileEntry *> removed;
+
+    m_watch_mutex.lock();
+    auto range = m_watches.equal_range(wd);
+    for (auto it = range.first; it != range.second; ++it) {
+        Shard *shard = shardOf(it->second);
+        shard->m_mutex.lock();
+        auto found = shard->m_map.find(std::string_view(it->second));
+        if (found != shard->m_map.end() && found->second->m_wd == wd) {
+            FileEntry *entry = found->second;
+            detach(shard, entry);
+            removed.push_back(entry);
+        }
+        shard->m_mutex.unlock();
+    }
+
+    if (range.first != range.second) {
+        m_watches.erase(wd);
+        inotify_rm_watch(m_inotifyfd, wd);
+    }
+    m_watch_mutex.unlock();
+
+    for (size_t i = 0; i < removed.size(); ++i) {
+        DebugPrint("filecache: invalidate %s\n", removed[i]->m_path.c_str());
+        release(removed[i]);
+    }
+}
+
+// 清空所有缓存，inotify 队列溢出时已经无法知道哪些文件变化了
+void FileCache::invalidateAll() {
+    std::vector<FileEntry *> removed;
+
+    m_watch_mutex.lock();
+    for (int i = 0; i < SHARD_NUM; ++i) {
+        Shard *shard = m_shards + i;
+        shard->m_mutex.lock();
+        while (shard->m_tail) {
+            FileEntry *entry = shard->m_tail;
+            detach(shard, entry);
+            removed.push_back(entry);
+        }
+        shard->m_mutex.unlock();
+    }
+
+    for (auto it = m_watches.begin(); it != m_watches.end(); ++it)
+        inotify_rm_watch(m_inotifyfd, it->first);
+    m_watches.clear();
+    m_watch_mutex.unlock();
+
+    for (size_t i = 0; i < removed.size(); ++i)
+        release(removed[i]);
+}
+
+// inotify 线程，阻塞读取事件并使对应的缓存失效
+void *FileCache::watchLoop() {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (true) {
+        ssize_t len = read(m_inotifyfd, buffer, sizeof(buffer));
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            LogError("filecache: read inotify failed: %s", strerror(errno));
+            break;
+        }
+
+        for (char *ptr = buffer; ptr < buffer + len; ) {
+            struct inotify_event *event = (struct inotify_event *)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                LogWarn("filecache: inotify queue overflow, drop all cache.");
+                invalidateAll();
+            } else if (!(event->mask & IN_IGNORED)) {
+                invalidate(event->wd);
+            }
+        }
+    }
+
+    return (void *)nullptr;
+}
+
+// 当前缓存的文件个数
+size_t FileCache::count() {
+    size_t total = 0;
+    for (int i = 0; i < SHARD_NUM; ++i) {
+        m_shards[i].m_mutex.lock();
+        total += m_shards[i].m_count;
+        m_shards[i].m_mutex.unlock();
+    }
+    return total;
+}
+
+// 当前缓存占用的字节数
+size_t FileCache::bytes() {
+    size_t total = 0;
+    for (int i = 0; i < SHARD_NUM; ++i) {
+        m_shards[i].m_mutex.lock();
+        total += m_shards[i].m_bytes;
+        m_shards[i].m_mutex.unlock();
+    }
+    return total;
+}
@@ -0,0 +1,127 @@
+#include "governor.h"
+
+#include <sys/resource.h>
+#include <stdio.h>
+
+ConnGovernor::ConnGovernor() {
+    m_total.store(0, std::memory_order_relaxed);
+    m_peak.store(0, std::memory_order_relaxed);
+    m_limit = MAX_FD;
+    m_resume = MAX_FD;
+    m_policy = POLICY_REJECT;
+    m_counter_num = 0;
+    m_counters = nullptr;
+}
+
+ConnGovernor::~ConnGovernor() {
+    if (m_counters) delete [] m_counters;
+}
+
+// 没有指定上限时按打开文件数的限制计算，恢复水位比上限低一些，避免在上限附近反复暂停和恢复
+void ConnGovernor::init(int reactor_num, int limit, int policy) {
+    if (limit <= 0) {
+        limit = MAX_FD;
+        struct rlimit rlim;
+        if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY && rlim.rlim_cur < (rlim_t)limit)
+            limit = (int)rlim.rlim_cur;
+        limit = limit > CONN_FD_RESERVE * 2 ? limit - CONN_FD_RESERVE : limit / 2;
+    }
+    m_limit = limit;
+    m_resume = (int)((int64_t)limit * ACCEPT_RESUME_PERCENT / 100);
+    if (m_resume >= m_limit)
+        m_resume = m_limit - 1;
+    m_policy = policy;
+
+    if (m_counters) delete [] m_counters;
+    m_counter_num = reactor_num > 0 ? reactor_num : 1;
+    m_counters = new Counter[m_counter_num];
+    for (int i = 0; i < m_counter_num; ++i) {
+        m_counters[i].m_active.store(0, std::memory_order_relaxed);
+        m_counters[i].m_peak.store(0, std::memory_order_relaxed);
+        m_counters[i].m_accepted.store(0, std::memory_order_relaxed);
+        m_counters[i].m_rejected.store(0, std::memory_order_relaxed);
+        m_counters[i].m_pauses.store(0, std::memory_order_relaxed);
+        m_counters[i].m_paused.store(false, std::memory_order_relaxed);
+    }
+}
+
+// 比较并交换占一个名额，多个 reactor 同时 admit 时总连接数在任何时刻都不会超过上限
+bool ConnGovernor::admit(int reactor) {
+    int total = m_total.load(std::memory_order_relaxed);
+    do {
+        if (total >= m_limit)
+            return false;
+    } while (!m_total.compare_exchange_weak(total, total + 1, std::memory_order_relaxed));
+    ++total;
+
+    int peak = m_peak.load(std::memory_order_relaxed);
+    while (total > peak && !m_peak.compare_exchange_weak(peak, total, std::memory_order_relaxed));
+
+    if (reactor >= 0 && reactor < m_counter_num) {
+        // 计数只由所属 reactor 修改，不需要原子的读改写
+        Counter &counter = m_counters[reactor];
+        int active = counter.m_active.load(std::memory_order_relaxed) + 1;
+        counter.m_active.store(active, std::memory_order_relaxed);
+        if (active > counter.m_peak.load(std::memory_order_relaxed))
+            counter.m_peak.store(active, std::memory_order_relaxed);
+        counter.m_accepted.store(counter.m_accepted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void ConnGovernor::release(int reactor) {
+    m_total.fetch_sub(1, std::memory_order_relaxed);
+
+    if (reactor >= 0 && reactor < m_counter_num) {
+        Counter &counter = m_counters[reactor];
+        counter.m_active.store(counter.m_active.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+}
+
+void ConnGovernor::reject(int reactor) {
+    if (reactor >= 0 && reactor < m_counter_num) {
+        Counter &counter = m_counters[reactor];
+        counter.m_rejected.store(counter.m_rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+void ConnGovernor::pause(int reactor, bool paused) {
+    if (reactor >= 0 && reactor < m_counter_num) {
+        Counter &counter = m_counters[reactor];
+        if (paused)
+            counter.m_pauses.store(counter.m_pauses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counter.m_paused.store(paused, std::memory_order_relaxed);
+    }
+}
+
+// 各个计数分别读取，合计不是严格的快照
+ConnGovernor::Metrics ConnGovernor::metrics(int reactor) const {
+    Metrics metrics = { 0, 0, 0, 0, 0, 0 };
+    int begin = reactor < 0 ? 0 : reactor;
+    int end = reactor < 0 ? m_counter_num : reactor + 1;
+    if (end > m_counter_num)
+        return metrics;
+
+    for (int i = begin; i < end; ++i) {
+        const Counter &counter = m_counters[i];
+        metrics.m_active += counter.m_active.load(std::memory_order_relaxed);
+        metrics.m_peak += counter.m_peak.load(std::memory_order_relaxed);
+        metrics.m_accepted += counter.m_accepted.load(std::memory_order_relaxed);
+        metrics.m_rejected += counter.m_rejected.load(std::memory_order_relaxed);
+        metrics.m_pauses += counter.m_pauses.load(std::memory_order_relaxed);
+        metrics.m_paused += counter.m_paused.load(std::memory_order_relaxed) ? 1 : 0;
+    }
+    // 合计的最大值是全局的最大值，不是各个 reactor 最大值的和
+    if (reactor < 0)
+        metrics.m_peak = m_peak.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+int ConnGovernor::report(char *buf, int size) const {
+    Metrics total = metrics();
+    int len = snprintf(buf, size, "connections %d/%d, peak %d, accepted %lu, rejected %lu, accept pauses %lu, paused reactors %d/%d, policy %s", \
+                       active(), m_limit, total.m_peak, (unsigned long)total.m_accepted, (unsigned long)total.m_rejected, \
+                       (unsigned long)total.m_pauses, total.m_paused, m_counter_num, \
+                       m_policy == POLICY_PAUSE ? "pause" : "reject");
+    return len < size ? len : size - 1;
+}
@@ -2,71 +2,76 @@
 #include "locker.h"
 #include "log.h"
 #include "debug.h"
+#include "filecache.h"
+#include "tokenizer.h"
+#include "response.h"
+#include "range.h"
 
 #include <fstream>
 #include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 
 
 using std::string;
-using std::map;
-
-// 定义 http 响应的状态
-const char *ok_200 = "Ok";
-const char *error_400_title = "Bad Request";
-const char *error_400_form = "Your request has bad syntax or is inherently impossible to staisfy.\n";
-const char *error_403_title = "Forbidden";
-const char *error_403_form = "You do not have permission to get file form this server.\n";
-const char *error_404_title = "Not Found";
-const char *error_404_form = "The requested file was not found on this server.\n";
-const char *error_500_title = "Internal Error";
-const char *error_500_form = "There was an unusual problem serving the request file.\n";
-
-// 初始化类中静态变量
-int HttpConn::m_user_count = 0;
-int HttpConn::m_epollfd = -1;
-
-locker m_lock;  // 互斥锁
-map<string, string> users;
 
 HttpConn::HttpConn() {
-
+    // 连接对象在 ConnSlab 中按 fd 第一次使用时构造，之后一直复用，构造时只保证指针和描述符处于安全状态
+    m_sockfd = -1;
+    m_backend = nullptr;
+    m_TRIGMode = 0;
+    m_close_log = 0;
+    m_check_state = CHECK_STATE_REQUESTLINE;
+    m_linger = false;
+    m_read_buf = nullptr;
+    m_read_head = nullptr;
+    m_read_seg = nullptr;
+    m_read_segs = 0;
+    m_read_idx = 0;
+    m_checked_idx = 0;
+    m_start_line = 0;
+    m_file = nullptr;
+    m_file_address = nullptr;
+    m_file_fd = -1;
+    m_close_after = false;
+    m_body_handler = nullptr;
+    m_range_count = 0;
+    m_variant = VARIANT_NONE;
+    m_vary = false;
+    m_mime = nullptr;
+    m_request.reset();
+    m_route = nullptr;
+    m_allow = 0;
+    m_params.m_count = 0;
+    m_query = nullptr;
+    m_query_reply = nullptr;
+    m_query_arg = nullptr;
+    m_timer.m_data = this;
+    m_last_active = 0;
+    m_request_start = 0;
+    m_busy.store(0, std::memory_order_relaxed);
 }
 
 HttpConn::~HttpConn() {
-    if (m_url)  delete m_url;
-
-    if (m_version) delete m_version;
+    freeReadBuf();
 }
 
-// 初始化 mysql 中存储的用户名和密码到程序
-void HttpConn::initMysqlResult(MysqlPool *conn_pool) {
-    // 从连接池中取出一个连接
-    MYSQL *sql = nullptr;
-    MysqlConnRAII sql_conn(&sql, conn_pool);
-
-    // 在 user 表中检索 username, passwd 数据
-    if (mysql_query(sql, "select username,passwd from user")) {
-        LogError("mysql select error: %s\n", mysql_error(sql));
-    }
-
-    // 从表中检索完整的结果集合
-    MYSQL_RES *result = mysql_store_result(sql);
+// 按名字查找请求头，不区分大小写，常用请求头直接按编号查找
+const TokenSpan *HttpConn::Request::header(const char *name) const {
+    int len = strlen(name);
+    HEADER_ID id = HttpHeader::lookup(name, len);
+    if (id != HEADER_UNKNOWN)
+        return header(id);
 
-    // 返回结果集中的列数
-    int num_fields = mysql_num_fields(result);
-
-    // 返回所有字段结构的数组
-    MYSQL_FIELD *fields = mysql_fetch_field(result);
-
-    // 从结果集中获取下一行，将对应的用户名和密码存入 map 中
-    while (MYSQL_ROW row = mysql_fetch_row(result)) {
-        string temp1(row[0]);
-        string temp2(row[1]);
-        users[temp1] = temp2;
+    for (int i = 0; i < m_header_count; ++i) {
+        if (m_headers[i].m_id == HEADER_UNKNOWN && m_headers[i].m_name.m_len == len && \
+            strncasecmp(m_headers[i].m_name.m_data, name, len) == 0)
+            return &m_headers[i].m_value;
     }
+    return nullptr;
 }
 
 // 对文件描述符设置非阻塞
@@ -129,251 +134,561 @@ void modfd(int epollfd, int fd, int events, int TRIGMode) {
 void HttpConn::closeConn(bool real_close) {
     if (real_close && (m_sockfd != -1)) {
         DebugPrint("close fd: %d\n", m_sockfd);
-        // 从内核事件中移除文件描述符
-        removefd(m_epollfd, m_sockfd);
-        // 用户数量减一
+        // 先置空再关闭，fd 关闭后可能立刻被其它 reactor 复用
+        int sockfd = m_sockfd;
         m_sockfd = -1;
-        m_user_count--;       
+        // 查询的结果到达时连接已经不在了
+        if (m_query) {
+            AsyncDb::local()->cancel(m_query);
+            m_query = nullptr;
+        }
+        unmap();
+        abortBody();
+        m_output.clear();
+        freeReadBuf();
+        // 从事件后端移除并关闭文件描述符
+        m_backend->removeConn(sockfd);
     }
 }
 
+// 关闭 socket 的读写但不释放 fd，重新等待读事件后所属 reactor 会收到关闭事件并关闭连接
+void HttpConn::shutdownConn() {
+    if (m_sockfd == -1)
+        return ;
+
+    shutdown(m_sockfd, SHUT_RDWR);
+    m_backend->armRead(m_sockfd);
+}
+
+// 根据连接当前所处的阶段计算超时的绝对时间(毫秒)
+uint64_t HttpConn::expireTime() {
+    // 异步查询由 AsyncDb 按 ASYNC_DB_QUERY_TIMEOUT 结束，这里只作为兜底
+    if (m_query)
+        return m_last_active + ASYNC_DB_QUERY_TIMEOUT + REQUEST_BODY_TIMEOUT;
+
+    // 响应还没有写完，或者在等待下一个请求
+    if (!m_output.empty() || isIdle())
+        return m_last_active + KEEPALIVE_TIMEOUT;
+
+    // 请求体按读之间的间隔计时
+    if (m_check_state == CHECK_STATE_CONTENT)
+        return m_last_active + REQUEST_BODY_TIMEOUT;
+
+    // 请求头从第一个字节开始计时，不因为陆续到达的字节而延长
+    uint64_t header_expire = m_request_start + REQUEST_HEADER_TIMEOUT;
+    uint64_t read_expire = m_last_active + REQUEST_BODY_TIMEOUT;
+    return header_expire < read_expire ? header_expire : read_expire;
+}
+
 
 // 初始化函数
-void HttpConn::init(int sockfd, const sockaddr_in &addr, char *root, int TRIGMode, \
-                    int close_log, const string &user, const string &passwd, const string &sqlname) {
+void HttpConn::init(int sockfd, const sockaddr_in &addr, EventBackend *backend, char *root, int TRIGMode, int close_log) {
     m_sockfd = sockfd;
     m_address = addr;
+    m_backend = backend;
+    m_TRIGMode = TRIGMode;
 
-    addfd(m_epollfd, m_sockfd, true, TRIGMode);
-    ++m_user_count;
+    m_backend->addConn(m_sockfd);
 
     // 当浏览器出现连接重置时，可能是网站根目录出错或http响应格式出错或者访问的文件中内容完全为空
     m_close_log = close_log;
     m_doc_root = root;
-
-    strcpy(m_sql_user, user.c_str());
-    strcpy(m_sql_passwd, passwd.c_str());
-    strcpy(m_sql_name, sqlname.c_str());
+    m_file_sink.init(close_log);
 
     // 调用内部初始化函数
     this->init();
 }
 
-//初始化新接受的连接
-//check_state默认为分析请求行状态
+// 连接级的重置，新接受的连接从分析请求行开始，输出队列和读缓冲区都还给内存池
 void HttpConn::init() {
-    m_sql = nullptr;
-    m_bytes_have_send = 0;
-    m_bytes_to_send = 0;
+    resetRequest();
+    m_close_after = false;
+    m_output.clear();
+
+    // 读缓冲区在第一次读数据时才从内存池获取
+    freeReadBuf();
+}
+
+// 请求级的重置，只写下标、计数和标志，不清空任何数组：
+// 请求头数组按计数访问，文件路径在使用前总是完整写入，只把第一个字节置 0
+void HttpConn::resetRequest() {
+    abortBody();
     m_check_state = CHECK_STATE_REQUESTLINE;
-    m_linger = false; 
-    m_method = GET;
+    m_linger = false;
+    m_request.reset();
     m_content_length = 0;
-    m_start_line = 0;
-    m_checked_idx = 0;
-    m_read_idx = 0;
-    m_write_idx = 0;
+    m_content_read = 0;
+    m_range_count = 0;
+    m_variant = VARIANT_NONE;
+    m_vary = false;
+    m_mime = nullptr;
     m_cgi = 0;
-    m_state = 0;
-    m_timer_falg = 0;
-    m_improv = 0;
-    m_bytes_read = 0;
+    m_route = nullptr;
+    m_real_file[0] = '\0';
+    // 只有跨段的请求体会用到，用完就释放，空闲的连接不占用这块内存
+    if (!m_body_copy.empty())
+        std::string().swap(m_body_copy);
+}
+
+// 一个请求处理完后重置请求相关的状态，缓冲区中剩余的字节属于下一个请求，
+// 剩余的流水线字节留在原处，段写满时由 compactReadBuf 一次 memmove 移到段的开头
+void HttpConn::nextRequest() {
+    resetRequest();
+    m_start_line = m_checked_idx;
+
+    // 之前的段只属于已经处理完的请求
+    if (m_read_head != m_read_seg) {
+        SegmentPool::get()->freeChain(m_read_head, m_read_seg);
+        m_read_head = m_read_seg;
+        m_read_segs = 1;
+    }
+}
 
-    m_url = new char[URL_SER_HOST_MAX];
-    memset(m_url, 0, URL_SER_HOST_MAX);
-    m_version = new char[URL_SER_HOST_MAX];
-    memset(m_version, 0, URL_SER_HOST_MAX);
-    m_host = new char[URL_SER_HOST_MAX];
-    memset(m_host, 0, URL_SER_HOST_MAX);
+// 把未解析完的字节移动到当前段开头，给后续的 recv 留出空间
+void HttpConn::compactReadBuf() {
+    if (m_start_line == 0)
+        return ;
 
-    memset(m_read_buf, 0, READ_BUFFER_SIZE);
-    memset(m_write_buf, 0, WRITE_BUFFER_SIZE);
-    memset(m_real_file, 0, FILENAME_LEN);
+    memmove(m_read_buf, m_read_buf + m_start_line, m_read_idx - m_start_line);
+    m_checked_idx -= m_start_line;
+    m_read_idx -= m_start_line;
+    m_start_line = 0;
+}
+
+// 保证当前段还有空闲空间，返回 false 表示请求过大
+bool HttpConn::prepareReadBuf() {
+    if (m_read_seg == nullptr) {
+        m_read_seg = m_read_head = SegmentPool::get()->alloc();
+        m_read_segs = 1;
+        m_read_buf = m_read_seg->m_data;
+        m_read_idx = 0;
+        m_checked_idx = 0;
+        m_start_line = 0;
+        return true;
+    }
+
+    if (m_read_idx < READ_BUFFER_SIZE)
+        return true;
+
+    // 还没开始解析新的请求，前面都是已经处理完的请求，原地移动即可
+    if (m_check_state == CHECK_STATE_REQUESTLINE && m_start_line > 0) {
+        compactReadBuf();
+        return true;
+    }
+
+    // 流式接收的请求体已经交给 BodyHandler，请求体所在的段从头重复使用，
+    // 请求头所在的第一个段保留，请求的视图一直有效
+    if (m_check_state == CHECK_STATE_CONTENT && m_body_handler && m_checked_idx == m_read_idx && \
+        m_read_seg != m_read_head) {
+        m_read_idx = m_checked_idx = m_start_line = 0;
+        return true;
+    }
+
+    // 一行占满了整个段
+    if (m_check_state != CHECK_STATE_CONTENT && m_start_line == 0) {
+        LogError("request line or header too long, more than %d bytes.", READ_BUFFER_SIZE);
+        return false;
+    }
+
+    if (m_read_segs >= READ_SEGMENT_MAX) {
+        LogError("request too large, more than %d segments.", READ_SEGMENT_MAX);
+        return false;
+    }
+
+    // 已经解析过的行和请求体留在原来的段中，只把不完整的行复制到新段的开头，解析从新段继续
+    BufferSegment *seg = SegmentPool::get()->alloc();
+    int partial = m_read_idx - m_start_line;
+    memcpy(seg->m_data, m_read_buf + m_start_line, partial);
+
+    m_read_seg->m_next = seg;
+    m_read_seg = seg;
+    ++m_read_segs;
+    m_read_buf = seg->m_data;
+    m_checked_idx -= m_start_line;
+    m_read_idx = partial;
+    m_start_line = 0;
+    return true;
+}
+
+// 把读缓冲区的所有段还给内存池
+void HttpConn::freeReadBuf() {
+    if (m_read_head)
+        SegmentPool::get()->freeChain(m_read_head);
+
+    m_read_head = nullptr;
+    m_read_seg = nullptr;
+    m_read_segs = 0;
+    m_read_buf = nullptr;
+    m_read_idx = 0;
+    m_checked_idx = 0;
+    m_start_line = 0;
 }
 
 // 从状态机，用于分析出一行内容
 // 返回值为行的读取状态，有LINE_OK,LINE_BAD,LINE_OPEN
 HttpConn::LINE_STATUS HttpConn::parseLine() {
-    char tmp;
-    for (;m_checked_idx < m_read_idx; ++m_checked_idx) {    
-        // m_check_idx 当前 m_read_buf 中读取的位置,m_read_idx当前 m_read_buf 的长度
-        tmp = m_read_buf[m_checked_idx];
-        if (tmp == '\r') {
-            // 判断是否已经被读取过
-            if ((m_checked_idx + 1) == m_read_idx) { // 表示已经被读取过了
-                return LINE_OPEN;
-            } else if (m_read_buf[m_checked_idx + 1] == '\n') {
-                // 表示一行读取完毕
-                m_read_buf[m_checked_idx++] = '\0';
-                m_read_buf[m_checked_idx++] = '\0';
-                return LINE_OK;
-            }
-            return LINE_BAD;
-        } else if (tmp == '\n') {
-            if (m_checked_idx > 1 && (m_read_buf[m_checked_idx - 1] == '\r')) {
-                // 保证最后两个字符为 '\0' 
-                m_read_buf[m_checked_idx-1] = '\0';
-                m_read_buf[m_checked_idx++] = '\0';
-                return LINE_OK;
-            }
-            return LINE_BAD;
+    if (m_checked_idx >= m_read_idx)
+        return LINE_OPEN;
+
+    // 向量化查找行尾，m_checked_idx 停在 '\r' 或 '\n' 上
+    const char *pos = HttpTokenizer::findLineEnd(m_read_buf + m_checked_idx, m_read_buf + m_read_idx);
+    m_checked_idx = pos - m_read_buf;
+    if (m_checked_idx == m_read_idx)
+        return LINE_OPEN;
+
+    if (*pos == '\r') {
+        // 判断是否已经被读取过
+        if ((m_checked_idx + 1) == m_read_idx) { // '\n' 还没有收到，下次从 '\r' 继续
+            return LINE_OPEN;
+        } else if (m_read_buf[m_checked_idx + 1] == '\n') {
+            // 表示一行读取完毕
+            m_read_buf[m_checked_idx++] = '\0';
+            m_read_buf[m_checked_idx++] = '\0';
+            return LINE_OK;
         }
+        return LINE_BAD;
+    }
+
+    if (m_checked_idx > 1 && (m_read_buf[m_checked_idx - 1] == '\r')) {
+        // 保证最后两个字符为 '\0' 
+        m_read_buf[m_checked_idx-1] = '\0';
+        m_read_buf[m_checked_idx++] = '\0';
+        return LINE_OK;
     }
-    return LINE_OPEN;
+    return LINE_BAD;
 }
 
 // 循环读取客户数据，直到无数据可读或对方关闭连接
 // 非阻塞ET工作模式下，需要一次性将数据读完
 bool HttpConn::readOnce() {
-    if (m_read_idx >= READ_BUFFER_SIZE) // 
+    // 剩余的请求体较大且缓冲区中没有未处理的数据时，由 BodyHandler 直接从 socket 接收
+    if (m_check_state == CHECK_STATE_CONTENT && m_body_handler && m_checked_idx == m_read_idx && \
+        m_content_length - m_content_read >= BODY_SPLICE_MIN) {
+        bool done = false;
+        if (!receiveBody(&done))
+            return false;
+        if (done)
+            return true;
+    }
+
+    if (!prepareReadBuf())
         return false;
     
+    int bytes_read;
     if (m_TRIGMode == 0) {
         // 表示为 EPOLLIN 模式
-        m_bytes_read = recv(m_sockfd, m_read_buf+m_read_idx, READ_BUFFER_SIZE-m_read_idx, 0);
-        m_read_idx = m_bytes_read;
-
-        if (m_bytes_read <= 0) 
+        bytes_read = recv(m_sockfd, m_read_buf+m_read_idx, READ_BUFFER_SIZE-m_read_idx, 0);
+        if (bytes_read <= 0) 
             return false;
+
+        m_read_idx += bytes_read;
+        return true;
     } else {
         // 表示为 EPOLLET 模式
-        while (true) {  // 一次性读取所有数据
-            m_bytes_read = recv(m_sockfd, m_read_buf+m_read_idx, READ_BUFFER_SIZE-m_read_idx, 0);
-            if (m_bytes_read == -1) {
+        // 一次性读取所有数据，缓冲区满时先处理已读到的请求，重新注册事件后会再次触发
+        // 对端半关闭时先处理这次读到的数据，EOF 在重新注册事件后再次触发时关闭
+        int start = m_read_idx;
+        while (m_read_idx < READ_BUFFER_SIZE) {
+            bytes_read = recv(m_sockfd, m_read_buf+m_read_idx, READ_BUFFER_SIZE-m_read_idx, 0);
+            if (bytes_read == -1) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) 
                     break;
                 return false;
-            } else if (m_bytes_read == 0) {
-                return false;
+            } else if (bytes_read == 0) {
+                return m_read_idx > start;
             }
 
-            m_read_idx += m_bytes_read;
+            m_read_idx += bytes_read;
         }
         return true;
     }
 }
 
-// 解析http请求行，获得请求方法，目标url及http版本号
-HttpConn::HTTP_CODE HttpConn::parseRequestLine(char *text) {
-    m_url = strpbrk(text, " \t");
-    if (!m_url)     // 解析失败，没有 m_url
-        return BAD_REQUEST;
-    
-    char *tmp_url = strpbrk(text, " \t");
-    if (tmp_url == nullptr) // 解析失败，在请求中没有 url 
-        return BAD_REQUEST;
-    
-    *tmp_url++ = '\0';    // text首地址是请求方法，m_url首地址后面是 url 和版本号
+// 后端已经收到的数据复制到读缓冲区，放不下的部分由后端在下一次读事件时再交出
+int HttpConn::receive(const char *data, int len) {
+    if (!prepareReadBuf())
+        return -1;
+
+    int take = READ_BUFFER_SIZE - m_read_idx;
+    if (take > len)
+        take = len;
+    memcpy(m_read_buf + m_read_idx, data, take);
+    m_read_idx += take;
+    return take;
+}
+
+// 由 BodyHandler 直接从 socket 接收请求体，只接收属于当前请求的字节，
+// done 为 true 表示已经处理了这次读事件，为 false 表示 BodyHandler 不支持，需要读到缓冲区
+bool HttpConn::receiveBody(bool *done) {
+    while (m_content_read < m_content_length) {
+        ssize_t ret = m_body_handler->receive(m_sockfd, m_content_length - m_content_read);
+        if (ret == -2)
+            return true;
+
+        *done = true;
+        if (ret == 0)
+            return false;
+        if (ret < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+
+        m_content_read += ret;
+        // LT 模式每个读事件只接收一次
+        if (m_TRIGMode == 0)
+            break;
+    }
+
+    *done = true;
+    return true;
+}
 
-    // 记录请求方法
-    char *method = text;
+// 解析http请求行，获得请求方法，目标url及http版本号，len 为行的长度，-1 表示以 '\0' 结尾
+HttpConn::HTTP_CODE HttpConn::parseRequestLine(char *text, int len) {
+    if (len < 0)
+        len = strlen(text);
 
-    if (strcasecmp(method, "GET") == 0) {
-        m_method = GET;
-    } else if (strcasecmp(method, "POST") == 0) {
-        m_method = POST;
+    // 一次分词得到方法、url 和版本号
+    TokenSpan method, url, version;
+    if (!HttpTokenizer::parseRequestLine(text, len, &method, &url, &version))
+        return BAD_REQUEST;
+
+    if (method.m_len == 3 && strncasecmp(method.m_data, "GET", 3) == 0) {
+        m_request.m_method = GET;
+    } else if (method.m_len == 4 && strncasecmp(method.m_data, "POST", 4) == 0) {
+        m_request.m_method = POST;
         m_cgi = 1;      // ?
+    } else if (method.m_len == 3 && strncasecmp(method.m_data, "PUT", 3) == 0) {
+        m_request.m_method = PUT;
     } else {
         return BAD_REQUEST;
     }
 
-    // 获取url
-    tmp_url += strspn(tmp_url, " \t");
-    DebugPrint("tmp_url: %s\n", tmp_url);
-    
-    // 得到 http 版本所在位置
-    char *tmp_version = strpbrk(tmp_url, " \t");
-    DebugPrint("tmp_version: %s\n", tmp_version);
+    // 判断版本号是否正确
+    if (version.m_len != 8 || strncasecmp(version.m_data, "HTTP/1.1", 8) != 0)
+        return BAD_REQUEST;
+    // HTTP/1.1 的连接默认是持久的，只有 Connection: close 才在响应后关闭
+    m_linger = true;
+    m_request.m_version = version;
+    m_request.m_target = url;
 
-    if (tmp_version == nullptr) {
+    // 绝对形式的 url 去掉协议和主机，从第一个 / 开始
+    const char *tmp_url = url.m_data;
+    const char *url_end = url.m_data + url.m_len;
+    if (url.m_len >= 7 && strncasecmp(tmp_url, "http://", 7) == 0)
+        tmp_url = (const char *)memchr(tmp_url + 7, '/', url_end - tmp_url - 7);
+    else if (url.m_len >= 8 && strncasecmp(tmp_url, "https://", 8) == 0)
+        tmp_url = (const char *)memchr(tmp_url + 8, '/', url_end - tmp_url - 8);
+
+    // 判断是否正确的 url
+    if (tmp_url == nullptr || tmp_url[0] != '/')
         return BAD_REQUEST;
+    m_request.m_path.m_data = tmp_url;
+    m_request.m_path.m_len = url_end - tmp_url;
+    DebugPrint("real url: %.*s\n", m_request.m_path.m_len, m_request.m_path.m_data);
+
+    m_check_state = CHECK_STATE_HEADER; // 解析状态为头部
+    return NO_REQUEST;
+}
+
+// 逗号分隔的列表中是否有 token，不区分大小写，例如 Connection: keep-alive, close
+static bool hasToken(const TokenSpan &list, const char *token, int len) {
+    const char *pos = list.m_data;
+    const char *end = list.m_data + list.m_len;
+
+    while (pos < end) {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == ','))
+            ++pos;
+        const char *item = pos;
+        while (pos < end && *pos != ',')
+            ++pos;
+        const char *tail = pos;
+        while (tail > item && (tail[-1] == ' ' || tail[-1] == '\t'))
+            --tail;
+        if (tail - item == len && strncasecmp(item, token, len) == 0)
+            return true;
     }
-    *tmp_version++ = '\0';  // 找到版本号所在位置
+    return false;
+}
 
-    // 获取版本号
-    tmp_version += strspn(tmp_version, " \t");
-    // 判断版本号是否正确
-    if (strcasecmp(tmp_version, "HTTP/1.1") != 0) {
-        return BAD_REQUEST;
+// Content-Length 只能是十进制数字，不接受符号、空白和超过 18 位的值
+static bool parseLength(const TokenSpan &value, int64_t *length) {
+    if (value.m_len == 0 || value.m_len > 18)
+        return false;
+
+    int64_t n = 0;
+    for (int i = 0; i < value.m_len; ++i) {
+        char c = value.m_data[i];
+        if (c < '0' || c > '9')
+            return false;
+        n = n * 10 + (c - '0');
     }
-    strcpy(m_version, tmp_version);
-    DebugPrint("real version: %s\n", m_version);
-
-    if (strncasecmp(tmp_url, "http://", 7) == 0) {
-        // 获取真正的 url, 判断 http
-        tmp_url += 7;
-        tmp_url = strchr(tmp_url, '/');     // 找到第一个/所在位置
-        strcpy(m_url, tmp_url);
-    } else if (strncasecmp(tmp_url, "https://", 8) == 0) {
-        // 获取真正的 url, 判断 https
-        tmp_url += 8;
-        tmp_url = strchr(tmp_url, '/');
-        strcpy(m_url, tmp_url);
-    } else {
-        strcpy(m_url, tmp_url);
+    *length = n;
+    return true;
+}
+
+// 解析http请求的一个头部信息，len 为行的长度，-1 表示以 '\0' 结尾
+HttpConn::HTTP_CODE HttpConn::parseHeaders(char *text, int len) {
+    if (len < 0)
+        len = strlen(text);
+
+    // 空行，请求头结束
+    if (len == 0)
+        return beginBody();
+
+    TokenSpan name, value;
+    if (!HttpTokenizer::parseHeader(text, len, &name, &value)) {
+        LogInfo("oop!bad header: %s", text);
+        return NO_REQUEST;
     }
 
+    // 所有请求头都以视图保存，超出数组的不保存，常用请求头另外按编号保存
+    HEADER_ID id = HttpHeader::lookup(name.m_data, name.m_len);
+    if (m_request.m_header_count < MAX_HEADERS) {
+        Header *header = m_request.m_headers + m_request.m_header_count++;
+        header->m_id = id;
+        header->m_name = name;
+        header->m_value = value;
+    }
+    if (id == HEADER_UNKNOWN)
+        return NO_REQUEST;
+    if ((m_request.m_known_mask >> id) & 1) {
+        // 两个 Content-Length 无法确定请求体的边界
+        return id == HEADER_CONTENT_LENGTH ? BAD_REQUEST : NO_REQUEST;
+    }
+    m_request.m_known[id] = value;
+    m_request.m_known_mask |= 1u << id;
 
-    // 判断是否正确的 url 
-    if (strlen(m_url) == 0 || m_url[0] != '/')
-        return BAD_REQUEST;
-    DebugPrint("real url: %s\n", m_url);
-    DebugPrint("real version: %s\n", m_version);
+    switch (id) {
+        case HEADER_CONNECTION:
+            // 获取连接类型
+            if (hasToken(value, "close", 5))
+                m_linger = false;
+            DebugPrint("conn: %.*s\n", value.m_len, value.m_data);
+            break;
+        case HEADER_CONTENT_LENGTH:
+            if (!parseLength(value, &m_content_length))
+                return BAD_REQUEST;
+            DebugPrint("len: %lld\n", (long long)m_content_length);
+            break;
+        case HEADER_TRANSFER_ENCODING:
+            // 不支持分块等传输编码，按 Content-Length 接收会把请求体当成下一个流水线请求
+            return NOT_IMPLEMENTED;
+        case HEADER_HOST:
+            DebugPrint("host: %.*s\n", value.m_len, value.m_data);
+            break;
+        default:
+            break;
+    }
 
-    // 当 url 为 / 时显示主页面
-    if (strlen(m_url) == 1) 
-        strcat(m_url, "index.html");
-    
-    m_check_state = CHECK_STATE_HEADER; // 解析状态为头部
     return NO_REQUEST;
 }
 
-// 解析http请求的一个头部信息
-HttpConn::HTTP_CODE HttpConn::parseHeaders(char *text) {
-    if (text[0] == '\0') {
-        if (m_content_length != 0) {
-            m_check_state = CHECK_STATE_CONTENT;    // 表示有 content 
-            return NO_REQUEST;
-        }
+// 请求头解析完后先查找路由，再决定如何接收请求体
+// 处理函数的请求体留在读缓冲区中，跨段时复制成连续的一块，超过 BODY_BUFFER_MAX 时回复 413；
+// 上传路由的 PUT/POST 请求体流式写入上传目录下的文件，没有上传路由的 PUT 回复 403，
+// 其他请求超过 BODY_BUFFER_MAX 的请求体流式丢弃，较小的请求体留在读缓冲区中
+HttpConn::HTTP_CODE HttpConn::beginBody() {
+    const TokenSpan &path = m_request.m_path;
+    m_route = nullptr;
+    if (Router::get()->find(m_request.m_method, path.m_data, path.m_len, &m_route, &m_params, &m_allow) == Router::MATCH_METHOD)
+        return METHOD_NOT_ALLOWED;
 
-        return GET_REQUEST; // 应该获取请求
-    } else if (strncasecmp(text, "Connection:", 11) == 0) {
-        // 获取连接类型
-        text += 11;
-        text += strspn(text, " \t");
-        if (strcasecmp(text, "keep-alive") == 0) {
-            m_linger = true;
+    if (m_route && m_route->m_handler) {
+        if (m_content_length > BODY_BUFFER_MAX)
+            return TOO_LARGE_REQUEST;
+    } else if (m_route && m_route->m_upload) {
+        const TokenSpan &rest = m_params.m_rest;
+        if (memmem(rest.m_data, rest.m_len, "..", 2) != nullptr)
+            return FORBIDDEN_REQUEST;
+        if (m_content_length > UPLOAD_MAX_SIZE)
+            return TOO_LARGE_REQUEST;
+
+        int len = snprintf(m_real_file, FILENAME_LEN, "%s%.*s", m_route->m_dir.c_str(), rest.m_len, rest.m_data);
+        if (len >= FILENAME_LEN)
+            return BAD_REQUEST;
+        if (!m_backend->beginUpload())
+            return SERVICE_UNAVAILABLE;
+        if (!m_file_sink.open(m_real_file)) {
+            int error = errno;
+            m_backend->endUpload();
+            if (error == ENOENT || error == ENOTDIR)
+                return NO_RESOURCE;
+            if (error == EACCES)
+                return FORBIDDEN_REQUEST;
+            if (error == EISDIR || error == ENAMETOOLONG)
+                return BAD_REQUEST;
+            return INTERNAL_ERROR;
         }
-        DebugPrint("conn: %s\n", text);
-    } else if (strncasecmp(text, "Content-length:", 15) == 0) {
-        text += 15;
-        text += strspn(text, " \t");
-        m_content_length = atol(text);
-        DebugPrint("len: %d\n", m_content_length);
-    } else if (strncasecmp(text, "Host:", 5) == 0) {
-        text += 5;
-        text += strspn(text, " \t");
-        strcpy(m_host, text);
-        DebugPrint("host: %s\n", m_host);
-    } else {
-        LogInfo("oop!unknow header: %s", text);
+        m_body_handler = &m_file_sink;
+    } else if (m_request.m_method == PUT) {
+        return FORBIDDEN_REQUEST;
+    } else if (m_content_length > BODY_BUFFER_MAX) {
+        m_body_handler = &m_discard_body;
+    }
+
+    if (m_body_handler && !m_body_handler->onBegin(m_content_length))
+        return INTERNAL_ERROR;
+    if (m_content_length == 0)
+        return GET_REQUEST;
+
+    // 客户端等待 100 Continue 后才发送请求体，排在已生成的响应之后发送
+    const TokenSpan *expect = m_request.header(HEADER_EXPECT);
+    if (expect && expect->m_len == 12 && strncasecmp(expect->m_data, "100-continue", 12) == 0) {
+        static const char continue_100[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (!m_output.pushMemory(continue_100, sizeof(continue_100) - 1))
+            return INTERNAL_ERROR;
     }
 
+    m_check_state = CHECK_STATE_CONTENT;
     return NO_REQUEST;
 }
 
-// 判断http请求是否被完整读入
+// 判断http请求是否被完整读入，每次消费当前段中属于请求体的部分
+// 有 BodyHandler 时交给它处理，否则请求体可以跨多个段留在读缓冲区中
 HttpConn::HTTP_CODE HttpConn::parseContent(char *text) {
-    if (m_read_idx >= (m_content_length + m_checked_idx)) {
-        text[m_content_length] = '\0';
-        m_string = text;
-        DebugPrint("parseContent: %s\n", text);
+    int take = m_read_idx - m_checked_idx;
+    if (take > m_content_length - m_content_read)
+        take = m_content_length - m_content_read;
+
+    if (m_body_handler) {
+        if (take > 0 && !m_body_handler->onData(text, take))
+            return INTERNAL_ERROR;
+    } else if (take > 0 && m_route && m_route->m_handler && (m_content_read > 0 || take < m_content_length)) {
+        // 处理函数的请求体跨段时复制到一块连续的内存，处理函数看到的总是完整的请求体
+        if (m_content_read == 0)
+            m_body_copy.reserve(m_content_length);
+        m_body_copy.append(text, take);
+        if (m_content_read + take >= m_content_length) {
+            m_request.m_body.m_data = m_body_copy.data();
+            m_request.m_body.m_len = m_body_copy.size();
+        }
+    } else if (m_content_read == 0 && take > 0) {
+        m_request.m_body.m_data = text;
+        m_request.m_body.m_len = take;
+    }
+
+    // 不在请求体后写入 '\0'，后面可能紧跟着下一个流水线请求
+    m_checked_idx += take;
+    m_content_read += take;
+    m_start_line = m_checked_idx;
+
+    if (m_content_read >= m_content_length) {
+        DebugPrint("parseContent: %lld bytes\n", (long long)m_content_length);
         return GET_REQUEST;
     }
 
     return NO_REQUEST;
 }
 
+// 请求体没有接收完时通知 BodyHandler，上传的临时文件被删除
+void HttpConn::abortBody() {
+    if (m_body_handler == &m_file_sink)
+        m_backend->endUpload();
+    if (m_body_handler) {
+        m_body_handler->onAbort();
+        m_body_handler = nullptr;
+    }
+}
+
 // 读取数据进程
 HttpConn::HTTP_CODE HttpConn::processRead() {
     LINE_STATUS line_status = LINE_OK;
@@ -383,28 +698,616 @@ HttpConn::HTTP_CODE HttpConn::processRead() {
 
     while ((m_check_state == CHECK_STATE_CONTENT && line_status == LINE_OK) || ((line_status = parseLine()) == LINE_OK)) {
         text = getLine();
+        // 完整的行以 "\r\n" 结尾，两个字节都已经替换成 '\0'
+        int len = m_checked_idx - m_start_line - 2;
         m_start_line = m_checked_idx;       // 更新起始位置
-        LogInfo("%s", text);
         switch (m_check_state) {
             case CHECK_STATE_REQUESTLINE:    // 读取请求行，获取 url 和 版本号以及请求方式
-                ret = parseRequestLine(text);
+                LogInfo("%s", text);
+                ret = parseRequestLine(text, len);
                 if (ret == BAD_REQUEST)
                     return BAD_REQUEST;
                 break;
             case CHECK_STATE_HEADER:   //  解析请求头
-                ret = parseHeaders(text);
-                if (ret = BAD_REQUEST)
-                    return BAD_REQUEST;
-                else if (ret == GET_REQUEST)    // 继续获取请求
+                ret = parseHeaders(text, len);
+                if (ret == GET_REQUEST)         // 继续获取请求
                     return doRequest();
+                else if (ret != NO_REQUEST)     // 请求格式错误或者不能接收请求体
+                    return ret;
                 break;
             case CHECK_STATE_CONTENT:
                 ret = parseContent(text);
+                if (ret == GET_REQUEST)
+                    return doRequest();
+                else if (ret != NO_REQUEST)
+                    return ret;
                 line_status = LINE_OPEN;
                 break;
             default:
                 return INTERNAL_ERROR;  // 否则发生错误
         }
     }
+
+    // 行中出现单独的 '\r' 或 '\n'
+    if (line_status == LINE_BAD)
+        return BAD_REQUEST;
     return NO_REQUEST;
-}
\ No newline at end of file
+}
+
+// 读取请求，路由到处理函数的请求在 processWrite 中调用处理函数，
+// 静态目录的路由把剩余路径映射到目录下的文件，没有路由时把 url 映射到 m_doc_root 下的文件
+HttpConn::HTTP_CODE HttpConn::doRequest() {
+    // 上传的请求体已经全部写入临时文件，改名为目标文件
+    if (m_body_handler == &m_file_sink) {
+        m_body_handler = nullptr;
+        m_backend->endUpload();
+        return m_file_sink.onEnd() ? CREATED_REQUEST : INTERNAL_ERROR;
+    }
+    m_body_handler = nullptr;
+    if (m_route && m_route->m_handler)
+        return HANDLER_REQUEST;
+
+    // 与 Router::find 一样去掉查询串，不允许通过 .. 访问根目录以外的文件
+    TokenSpan path = m_request.m_path;
+    const char *query = (const char *)memchr(path.m_data, '?', path.m_len);
+    if (query)
+        path.m_len = query - path.m_data;
+    if (memmem(path.m_data, path.m_len, "..", 2) != nullptr)
+        return FORBIDDEN_REQUEST;
+
+    // 以 / 结尾的 url 显示目录下的主页面
+    int len;
+    if (m_route) {
+        const TokenSpan &rest = m_params.m_rest;
+        bool index = rest.m_len == 0 || rest.m_data[rest.m_len - 1] == '/';
+        len = snprintf(m_real_file, FILENAME_LEN, "%s%.*s%s", m_route->m_dir.c_str(), rest.m_len, rest.m_data, \
+                       index ? "index.html" : "");
+    } else {
+        bool index = path.m_data[path.m_len - 1] == '/';
+        len = snprintf(m_real_file, FILENAME_LEN, "%s%.*s%s", m_doc_root, path.m_len, path.m_data, \
+                       index ? "index.html" : "");
+    }
+    if (len >= FILENAME_LEN)
+        return BAD_REQUEST;
+
+    // 从文件缓存获取文件，热点文件不再重复 stat/open/mmap
+    int error = 0;
+    m_file = FileCache::get()->acquire(m_real_file, &error);
+    if (m_file == nullptr) {
+        if (error == ENOENT || error == ENOTDIR)
+            return NO_RESOURCE;
+        if (error == EACCES)
+            return FORBIDDEN_REQUEST;
+        if (error == EISDIR)
+            return BAD_REQUEST;
+        return INTERNAL_ERROR;
+    }
+    // 发送预压缩版本时 Content-Type 仍然是原文件的类型
+    m_mime = m_file->m_mime;
+    if (m_file->m_variants != VARIANT_NONE && m_request.m_method == GET)
+        selectVariant();
+
+    // 小文件使用缓存中的映射与响应头一起用 writev 一次发送，
+    // 大文件使用缓存中的描述符，由 write 调用 sendfile 发送，文件内容不经过用户态
+    m_file_address = m_file->m_address;
+    if (m_file_address == nullptr && m_file->m_stat.st_size > 0)
+        m_file_fd = m_file->m_fd;
+
+    // 客户端缓存仍然有效时只回复 304，不碰文件内容
+    if (m_request.m_method == GET && notModified())
+        return NOT_MODIFIED;
+
+    // 范围请求，格式错误或者 If-Range 不匹配时发送整个文件
+    const TokenSpan *range = m_request.header(HEADER_RANGE);
+    if (range && m_request.m_method == GET && m_file->m_stat.st_size > 0 && ifRangeMatch()) {
+        m_range_count = HttpRange::parse(*range, m_file->m_stat.st_size, m_ranges, RANGE_MAX_COUNT);
+        if (m_range_count < 0) {
+            m_range_count = 0;
+            return RANGE_NOT_SATISFIABLE;
+        }
+    }
+
+    return FILE_REQUEST;
+}
+
+// 解析 Accept-Encoding，返回客户端接受的预压缩版本
+// q=0 表示明确拒绝，"*" 只作用于没有单独列出的编码
+static int acceptedVariants(const TokenSpan &value) {
+    const char *pos = value.m_data;
+    const char *end = value.m_data + value.m_len;
+    int accepted = VARIANT_NONE, listed = VARIANT_NONE;
+    bool star = false;
+
+    while (pos < end) {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == ','))
+            ++pos;
+        const char *name = pos;
+        while (pos < end && *pos != ',' && *pos != ';' && *pos != ' ' && *pos != '\t')
+            ++pos;
+        int name_len = pos - name;
+
+        // 参数中只关心 q，q 为 0、0.0、0.00 或 0.000 时不接受
+        bool zero = false;
+        while (pos < end && *pos != ',') {
+            if (*pos == ';') {
+                ++pos;
+                while (pos < end && (*pos == ' ' || *pos == '\t'))
+                    ++pos;
+                if (end - pos > 2 && (pos[0] == 'q' || pos[0] == 'Q') && pos[1] == '=') {
+                    const char *q = pos + 2;
+                    zero = *q == '0';
+                    for (++q; q < end && *q != ',' && *q != ';' && *q != ' ' && *q != '\t'; ++q) {
+                        if (*q != '.' && *q != '0')
+                            zero = false;
+                    }
+                    pos = q;
+                }
+                continue;
+            }
+            ++pos;
+        }
+
+        int variant = VARIANT_NONE;
+        if (name_len == 2 && strncasecmp(name, "br", 2) == 0)
+            variant = VARIANT_BR;
+        else if ((name_len == 4 && strncasecmp(name, "gzip", 4) == 0) || \
+                 (name_len == 6 && strncasecmp(name, "x-gzip", 6) == 0))
+            variant = VARIANT_GZIP;
+        else if (name_len == 1 && *name == '*')
+            star = !zero;
+
+        listed |= variant;
+        if (!zero)
+            accepted |= variant;
+    }
+
+    if (star)
+        accepted |= (VARIANT_BR | VARIANT_GZIP) & ~listed;
+    return accepted;
+}
+
+// 优先发送 brotli 版本，压缩文件被删除或者无法打开时发送原文件
+void HttpConn::selectVariant() {
+    static const struct {
+        FILE_VARIANT    m_variant;
+        const char      *m_suffix;
+    } suffixes[] = {{VARIANT_BR, ".br"}, {VARIANT_GZIP, ".gz"}};
+
+    m_vary = true;
+    const TokenSpan *accept = m_request.header(HEADER_ACCEPT_ENCODING);
+    if (accept == nullptr)
+        return ;
+    int usable = m_file->m_variants & acceptedVariants(*accept);
+
+    int len = strlen(m_real_file);
+    for (size_t i = 0; usable != VARIANT_NONE && i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+        if (!(usable & suffixes[i].m_variant) || len + 4 > FILENAME_LEN)
+            continue;
+
+        char path[FILENAME_LEN];
+        memcpy(path, m_real_file, len);
+        memcpy(path + len, suffixes[i].m_suffix, 4);
+        int error = 0;
+        FileEntry *variant = FileCache::get()->acquire(path, &error);
+        if (variant == nullptr)
+            continue;
+
+        FileCache::release(m_file);
+        m_file = variant;
+        m_variant = suffixes[i].m_variant;
+        return ;
+    }
+}
+
+// 预压缩版本的 Content-Encoding 和 Vary 头
+static void writeEncoding(ResponseWriter &writer, int variant, bool vary) {
+    if (variant == VARIANT_BR)
+        writer.append("Content-Encoding: br\r\n", 22);
+    else if (variant == VARIANT_GZIP)
+        writer.append("Content-Encoding: gzip\r\n", 24);
+    if (vary)
+        writer.append("Vary: Accept-Encoding\r\n", 23);
+}
+
+// 405 响应的 Allow 头，与 HttpConn::METHOD 的顺序相同
+static void writeAllow(ResponseWriter &writer, int allow) {
+    static const char *names[Router::METHOD_COUNT] = {"GET", "POST", "HEAD", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE"};
+
+    writer.append("Allow: ", 7);
+    bool first = true;
+    for (int i = 0; i < Router::METHOD_COUNT; ++i) {
+        if (!(allow & (1 << i)))
+            continue;
+        if (!first)
+            writer.append(", ", 2);
+        writer.append(names[i], strlen(names[i]));
+        first = false;
+    }
+    writer.append("\r\n", 2);
+}
+
+// 释放当前请求从文件缓存获取的文件，映射和描述符属于文件缓存，这里只归还引用，
+// 已经加入输出队列的文件由队列在发送完后归还
+void HttpConn::unmap() {
+    if (m_file) {
+        FileCache::release(m_file);
+        m_file = nullptr;
+    }
+
+    m_file_address = nullptr;
+    m_file_fd = -1;
+}
+
+// 通过事件后端发送输出队列，epoll 遇到 EAGAIN 时保留进度并注册 EPOLLOUT，io_uring 提交异步发送，
+// 等队列发完之前不再读新的请求，返回 -1 出错，0 没有发完，1 全部发送完毕
+int HttpConn::flush() {
+    return m_backend->send(m_sockfd, &m_output);
+}
+
+// 写数据，由 reactor 在写事件时调用，发送完后继续处理读缓冲区中剩余的流水线请求
+bool HttpConn::write() {
+    int ret = flush();
+    if (ret <= 0)
+        return ret == 0;
+
+    if (m_close_after)
+        return false;
+
+    return doProcess();
+}
+
+// 写入数据进程，根据 processRead 的结果组织响应，追加到输出队列
+// 响应头由预先生成的片段拼装在队列的段中，错误页面直接复制到响应头之后
+bool HttpConn::processWrite(HTTP_CODE ret) {
+    int avail;
+    char *buf = m_output.reserve(&avail);
+    ResponseWriter writer(buf, avail);
+    const StatusTemplate *status;
+
+    switch (ret) {
+        case INTERNAL_ERROR:
+            status = HttpStatus::get(500);
+            break;
+        case BAD_REQUEST:
+            status = HttpStatus::get(400);
+            break;
+        case NO_RESOURCE:
+            status = HttpStatus::get(404);
+            break;
+        case FORBIDDEN_REQUEST:
+            status = HttpStatus::get(403);
+            break;
+        case FILE_REQUEST:
+            if (m_range_count > 0) {
+                bool ok = processRanges();
+                unmap();
+                return ok;
+            }
+            status = HttpStatus::get(200);
+            break;
+        case RANGE_NOT_SATISFIABLE:
+            status = HttpStatus::get(416);
+            break;
+        case CREATED_REQUEST:
+            status = HttpStatus::get(201);
+            break;
+        case TOO_LARGE_REQUEST:
+            status = HttpStatus::get(413);
+            break;
+        case NOT_MODIFIED:
+            status = HttpStatus::get(304);
+            break;
+        case HANDLER_REQUEST:
+            return processHandler();
+        case METHOD_NOT_ALLOWED:
+            status = HttpStatus::get(405);
+            break;
+        case NOT_IMPLEMENTED:
+            status = HttpStatus::get(501);
+            break;
+        case SERVICE_UNAVAILABLE:
+            status = HttpStatus::get(503);
+            break;
+        default:
+            return false;
+    }
+
+    // 非空文件的内容由 mmap 地址或 sendfile 发送，其余响应的页面跟在响应头后面
+    // 非空文件的 Content-Type 按扩展名确定
+    bool file_body = ret == FILE_REQUEST && m_file->m_stat.st_size != 0;
+    if (file_body)
+        writer.statusLine(200, m_mime);
+    else
+        writer.statusLine(status);
+    // 304 只带验证器和 Vary，不带 Content-Encoding 这样描述响应体的头
+    if (ret == FILE_REQUEST || ret == NOT_MODIFIED) {
+        writer.append(m_file->m_validators, m_file->m_validators_len);
+        writeEncoding(writer, ret == FILE_REQUEST ? m_variant : VARIANT_NONE, m_vary);
+    }
+    if (ret == RANGE_NOT_SATISFIABLE)
+        writer.contentRangeUnsatisfied(m_file->m_stat.st_size);
+    if (ret == METHOD_NOT_ALLOWED)
+        writeAllow(writer, m_allow);
+    // 304 没有响应体，不发送 Content-Length
+    if (ret != NOT_MODIFIED)
+        writer.contentLength(file_body ? m_file->m_stat.st_size : status->m_body_len);
+    writer.connection(m_linger);
+    writer.end();
+    if (!file_body)
+        writer.append(status->m_body, status->m_body_len);
+    if (writer.overflow() || !m_output.commit(writer.length()))
+        return false;
+
+    // 文件的引用交给输出队列，内容发送完后归还
+    if (file_body) {
+        bool ok = pushFileData(0, m_file->m_stat.st_size, m_file);
+        m_file = nullptr;
+        if (!ok)
+            return false;
+    }
+    unmap();
+    return true;
+}
+
+// 调用路由的处理函数，处理函数使用一个完整的段，响应体先写在为响应头预留的空间之后，
+// 生成响应头后把响应体移到紧跟响应头的位置，响应头和复制的响应体是一个数据块
+// 处理函数发出异步查询时段只是预留，不提交，结果到达后重新预留
+bool HttpConn::processHandler() {
+    int avail;
+    char *buf = m_output.reserve(&avail, BUFFER_SEGMENT_SIZE);
+    RouteReply reply(buf + ROUTE_HEADER_RESERVE, avail - ROUTE_HEADER_RESERVE);
+    m_route->m_handler(this, m_params, &reply, m_route->m_arg);
+    if (m_query)
+        return true;
+    return commitReply(buf, reply);
+}
+
+bool HttpConn::commitReply(char *buf, const RouteReply &reply) {
+    if (reply.overflow()) {
+        LogWarn("route %s: reply is larger than %d bytes", m_route->m_pattern.c_str(), reply.capacity());
+        return processWrite(INTERNAL_ERROR);
+    }
+
+    ResponseWriter writer(buf, ROUTE_HEADER_RESERVE);
+    writer.statusLine(reply.statusCode(), reply.contentType());
+    writer.contentLength(reply.length() + reply.externalLength());
+    writer.connection(m_linger);
+    writer.end();
+    if (writer.overflow())
+        return false;
+
+    memmove(buf + writer.length(), buf + ROUTE_HEADER_RESERVE, reply.length());
+    if (!m_output.commit(writer.length() + reply.length()))
+        return false;
+    if (reply.externalLength() > 0)
+        return m_output.pushMemory(reply.externalBody(), reply.externalLength());
+    return true;
+}
+
+// 查询只在 reactor 线程中提交和结束，与连接的其它处理在同一个线程，不需要加锁
+bool HttpConn::deferQuery(const char *sql, int len, QueryReply callback, void *arg) {
+    AsyncDb *db = AsyncDb::local();
+    if (db == nullptr || m_query != nullptr)
+        return false;
+
+    m_query = db->query(sql, len, queryDone, this);
+    if (m_query == nullptr)
+        return false;
+    m_query_reply = callback;
+    m_query_arg = arg;
+    return true;
+}
+
+// 由 AsyncDb 在 reactor 线程中调用，请求的视图在读缓冲区中仍然有效
+// 回调可以再发出下一个查询，这时继续等待；出错时与工作线程相同，只 shutdown，由 reactor 关闭连接
+void HttpConn::resumeQuery(AsyncQuery *query) {
+    m_query = nullptr;
+    m_last_active = TimerWheel::nowMs();
+
+    int avail;
+    char *buf = m_output.reserve(&avail, BUFFER_SEGMENT_SIZE);
+    RouteReply reply(buf + ROUTE_HEADER_RESERVE, avail - ROUTE_HEADER_RESERVE);
+    m_query_reply(this, query, &reply, m_query_arg);
+    if (m_query)
+        return ;
+
+    if (!commitReply(buf, reply)) {
+        shutdownConn();
+        return ;
+    }
+    if (!m_linger)
+        m_close_after = true;
+    nextRequest();
+
+    if (!doProcess())
+        shutdownConn();
+}
+
+// 把当前文件的一段加入输出队列，小文件直接引用 mmap 的地址，大文件用 sendfile 的偏移，都不复制文件内容
+bool HttpConn::pushFileData(uint64_t offset, uint64_t len, FileEntry *file) {
+    if (m_file_address)
+        return m_output.pushMemory(m_file_address + offset, len, file);
+    return m_output.pushFile(m_file_fd, offset, len, file);
+}
+
+// multipart/byteranges 中一个部分的头，Content-Type 是文件的类型
+static void writePartHeader(ResponseWriter &writer, const ByteRange &range, uint64_t size, const char *mime) {
+    writer.append("\r\n--" RANGE_BOUNDARY "\r\nContent-Type: ", sizeof("\r\n--" RANGE_BOUNDARY "\r\nContent-Type: ") - 1);
+    writer.append(mime, strlen(mime));
+    writer.append("\r\n", 2);
+    writer.contentRange(range.m_start, range.m_end, size);
+    writer.end();
+}
+
+// 范围请求的响应，一个范围时直接发送文件的这一段，
+// 多个范围时各部分的头写在输出队列的段中，与文件的各段交替排列成 multipart/byteranges
+bool HttpConn::processRanges() {
+    static const char closing[] = "\r\n--" RANGE_BOUNDARY "--\r\n";
+    uint64_t size = m_file->m_stat.st_size;
+    int avail;
+    char *buf = m_output.reserve(&avail);
+    ResponseWriter writer(buf, avail);
+
+    if (m_range_count == 1) {
+        const ByteRange &range = m_ranges[0];
+        writer.statusLine(206, m_mime);
+        writer.append(m_file->m_validators, m_file->m_validators_len);
+        writeEncoding(writer, m_variant, m_vary);
+        writer.contentRange(range.m_start, range.m_end, size);
+        writer.contentLength(range.m_end - range.m_start + 1);
+        writer.connection(m_linger);
+        writer.end();
+    } else {
+        // 先生成一遍各部分的头，得到整个响应的长度
+        uint64_t total = sizeof(closing) - 1;
+        for (int i = 0; i < m_range_count; ++i) {
+            char part[256];
+            ResponseWriter part_writer(part, sizeof(part));
+            writePartHeader(part_writer, m_ranges[i], size, m_mime);
+            total += part_writer.length() + m_ranges[i].m_end - m_ranges[i].m_start + 1;
+        }
+
+        writer.statusLine(HttpStatus::byteranges());
+        writer.append(m_file->m_validators, m_file->m_validators_len);
+        writeEncoding(writer, m_variant, m_vary);
+        writer.contentLength(total);
+        writer.connection(m_linger);
+        writer.end();
+    }
+    if (writer.overflow() || !m_output.commit(writer.length()))
+        return false;
+
+    // 文件的引用交给最后一段，队列按顺序发送，之前的各段发送时文件一直有效
+    for (int i = 0; i < m_range_count; ++i) {
+        const ByteRange &range = m_ranges[i];
+        if (m_range_count > 1) {
+            char *part_buf = m_output.reserve(&avail);
+            ResponseWriter part_writer(part_buf, avail);
+            writePartHeader(part_writer, range, size, m_mime);
+            if (part_writer.overflow() || !m_output.commit(part_writer.length()))
+                return false;
+        }
+
+        // 每个范围各持有一个文件引用，io_uring 后端发送某个范围时文件描述符必须仍然有效
+        if (!pushFileData(range.m_start, range.m_end - range.m_start + 1, FileCache::retain(m_file))) {
+            FileCache::release(m_file);
+            return false;
+        }
+    }
+
+    if (m_range_count > 1) {
+        char *closing_buf = m_output.reserve(&avail);
+        ResponseWriter closing_writer(closing_buf, avail);
+        closing_writer.append(closing, sizeof(closing) - 1);
+        if (closing_writer.overflow() || !m_output.commit(closing_writer.length()))
+            return false;
+    }
+    return true;
+}
+
+// If-Range 为 ETag 时按强比较，为日期时必须与 Last-Modified 完全相同，匹配时才按范围发送，否则发送整个文件
+bool HttpConn::ifRangeMatch() {
+    const TokenSpan *value = m_request.header(HEADER_IF_RANGE);
+    if (value == nullptr)
+        return true;
+
+    if (value->m_len > 0 && value->m_data[0] == '"')
+        return value->m_len == m_file->m_etag_len && memcmp(value->m_data, m_file->m_etag, value->m_len) == 0;
+    return value->m_len == HttpDate::DATE_LEN && memcmp(value->m_data, m_file->m_last_modified, value->m_len) == 0;
+}
+
+// If-None-Match 列表中是否有与 etag 弱比较相同的项，"*" 匹配任何存在的文件
+static bool etagListMatch(const TokenSpan &list, const char *etag, int etag_len) {
+    const char *pos = list.m_data;
+    const char *end = list.m_data + list.m_len;
+
+    while (pos < end) {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == ','))
+            ++pos;
+        const char *item = pos;
+        while (pos < end && *pos != ',')
+            ++pos;
+        const char *tail = pos;
+        while (tail > item && (tail[-1] == ' ' || tail[-1] == '\t'))
+            --tail;
+
+        if (tail - item == 1 && *item == '*')
+            return true;
+        // 弱比较忽略 W/ 前缀
+        if (tail - item > 2 && item[0] == 'W' && item[1] == '/')
+            item += 2;
+        if (tail - item == etag_len && memcmp(item, etag, etag_len) == 0)
+            return true;
+    }
+    return false;
+}
+
+// 有 If-None-Match 时忽略 If-Modified-Since；
+// If-Modified-Since 通常就是之前发送的 Last-Modified，先直接比较字符串，不同时才解析日期
+bool HttpConn::notModified() {
+    const TokenSpan *none_match = m_request.header(HEADER_IF_NONE_MATCH);
+    if (none_match)
+        return etagListMatch(*none_match, m_file->m_etag, m_file->m_etag_len);
+
+    const TokenSpan *since = m_request.header(HEADER_IF_MODIFIED_SINCE);
+    if (since == nullptr)
+        return false;
+    if (since->m_len == HttpDate::DATE_LEN && memcmp(since->m_data, m_file->m_last_modified, since->m_len) == 0)
+        return true;
+
+    time_t t;
+    return HttpDate::parse(since->m_data, since->m_len, &t) && m_file->m_stat.st_mtime <= t;
+}
+
+// 主进程，可能运行在工作线程中，出错时只 shutdown，由 reactor 关闭连接
+void HttpConn::process() {
+    if (!doProcess())
+        shutdownConn();
+    // 最后一步，之后 reactor 的定时器才可以关闭这个连接
+    m_busy.fetch_sub(1, std::memory_order_release);
+}
+
+// 循环解析读缓冲区中的请求，流水线上的多个响应按顺序加入输出队列后一次写出，
+// 队列超过高水位时先发送，写不完时只注册 EPOLLOUT，队列发完之前不再读新的请求
+bool HttpConn::doProcess() {
+    while (true) {
+        HTTP_CODE read_ret;
+        while (!m_close_after && m_query == nullptr && !m_output.full() && (read_ret = processRead()) != NO_REQUEST) {
+            // 请求格式错误、请求体的编码不支持或者请求体没有读完时找不到下一个请求的起点，响应后关闭连接
+            if (read_ret == BAD_REQUEST || read_ret == NOT_IMPLEMENTED || m_content_read < m_content_length)
+                m_linger = false;
+
+            if (!processWrite(read_ret))
+                return false;
+
+            // 处理函数发出了异步查询，结果到达后由 resumeQuery 结束这个请求
+            if (m_query)
+                break;
+
+            if (!m_linger)
+                m_close_after = true;
+            nextRequest();
+        }
+
+        if (m_output.empty()) {
+            // 等待查询结果时不读新的数据，结果到达后 resumeQuery 重新进入这里
+            if (m_query)
+                return true;
+
+            // 请求不完整，继续等待读事件；缓冲区里没有剩余数据时把段还给内存池
+            if (isIdle())
+                freeReadBuf();
+            m_backend->armRead(m_sockfd);
+            return true;
+        }
+
+        int ret = flush();
+        if (ret <= 0)
+            return ret == 0;
+
+        if (m_close_after)
+            return false;
+
+        // 队列已经发完，继续处理缓冲区中剩余的请求
+    }
+}
@@ -1,18 +1,224 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <string>
+
+#include "common.h"
 #include "log.h"
+#include "mysqlpool.h"
+#include "http.h"
+#include "reactor.h"
+#include "filecache.h"
+#include "governor.h"
+#include "router.h"
+#include "credential.h"
 
 bool m_close_log = false;
 
-int main() {
+// GET /server-status: 连接数和准入控制的计数，纯文本
+static void serverStatus(HttpConn *, const RouteParams &, RouteReply *reply, void *) {
+    char buf[256];
+    int len = ConnGovernor::get()->report(buf, sizeof(buf));
+    reply->append(buf, len);
+    reply->append("\n", 1);
+}
+
+// 从 application/x-www-form-urlencoded 的请求体中取出一个字段并解码，没有或者超长时返回 -1
+static int formField(const TokenSpan &body, const char *name, char *out, int size) {
+    int name_len = strlen(name);
+    const char *pos = body.m_data;
+    const char *end = body.m_data + body.m_len;
+    while (pos < end) {
+        const char *amp = (const char *)memchr(pos, '&', end - pos);
+        const char *field_end = amp ? amp : end;
+        if (field_end - pos > name_len && pos[name_len] == '=' && memcmp(pos, name, name_len) == 0) {
+            int len = 0;
+            for (const char *p = pos + name_len + 1; p < field_end; ++p) {
+                if (len >= size)
+                    return -1;
+                if (*p == '+') {
+                    out[len++] = ' ';
+                } else if (*p == '%' && field_end - p > 2 && isxdigit(p[1]) && isxdigit(p[2])) {
+                    char hex[3] = {p[1], p[2], 0};
+                    out[len++] = (char)strtol(hex, nullptr, 16);
+                    p += 2;
+                } else {
+                    out[len++] = *p;
+                }
+            }
+            return len;
+        }
+        pos = field_end + 1;
+    }
+    return -1;
+}
+
+// POST /api/login: 表单中的 user 和 passwd 与用户表比较，成功 200，失败 401
+static void login(HttpConn *conn, const RouteParams &, RouteReply *reply, void *) {
+    char user[LINE_MAX], passwd[LINE_MAX];
+    const TokenSpan &body = conn->request().m_body;
+    int user_len = formField(body, "user", user, sizeof(user));
+    int passwd_len = formField(body, "passwd", passwd, sizeof(passwd));
+    if (user_len <= 0 || passwd_len < 0) {
+        reply->status(400);
+        reply->append("missing user or passwd\n");
+        return ;
+    }
+
+    if (CredentialStore::get()->verify(user, user_len, passwd, passwd_len)) {
+        reply->append("ok\n");
+    } else {
+        reply->status(401);
+        reply->append("wrong user or passwd\n");
+    }
+}
+
+// 用户数只有一个值，查询失败时为 nullptr
+static void writeUserCount(const char *count, RouteReply *reply) {
+    if (count == nullptr) {
+        reply->status(503);
+        reply->append("database unavailable\n");
+        return ;
+    }
+    reply->append(count);
+    reply->append("\n", 1);
+}
+
+static void userCountReply(HttpConn *, const AsyncQuery *query, RouteReply *reply, void *) {
+    if (query->m_errno != 0)
+        LogError("count users: %s", query->m_error.c_str());
+    MYSQL_ROW row = query->m_errno == 0 && query->m_result ? mysql_fetch_row(query->m_result) : nullptr;
+    writeUserCount(row ? row[0] : nullptr, reply);
+}
+
+// GET /api/users/count: user 表的行数，reactor 线程中使用异步查询，
+// 只有工作线程中才使用连接池同步执行预处理语句；reactor 线程不能阻塞，
+// 异步查询被拒绝(没有连上的连接、队列已满或者客户端库没有非阻塞接口)时直接回复 503
+static void userCount(HttpConn *conn, const RouteParams &, RouteReply *reply, void *) {
+    static const char sql[] = "select count(*) from user";
+    if (conn->deferQuery(sql, sizeof(sql) - 1, userCountReply))
+        return ;
+    if (EventLoop::inLoop()) {
+        writeUserCount(nullptr, reply);
+        return ;
+    }
+
+    MYSQL *mysql = nullptr;
+    MysqlConnRAII sql_conn(&mysql, MysqlPool::get());
+    StmtCache *stmts = sql_conn.stmts();
+    MysqlStmt *stmt = stmts ? stmts->prepare(sql, sizeof(sql) - 1) : nullptr;
+    if (stmt == nullptr || !stmt->execute() || !stmt->fetch()) {
+        writeUserCount(nullptr, reply);
+        return ;
+    }
+    writeUserCount(stmt->getString(0), reply);
+    stmt->freeResult();
+}
+
+int main(int argc, char *argv[]) {
+    int port = 9006;                                    // 监听端口
+    int loop_num = sysconf(_SC_NPROCESSORS_ONLN);       // reactor 线程数，默认每个核一个
+    int thread_num = 0;                                 // 工作线程数，0 表示在 reactor 线程内处理
+    int TRIGMode = 1;                                   // 连接的触发模式，1 为 ET
+    int sql_num = 8;                                    // mysql 连接池的最多连接数
+    int async_sql_num = ASYNC_DB_CONNS;                 // 每个 reactor 的非阻塞 mysql 连接数，0 表示不使用异步查询
+    int backend = EventBackend::BACKEND_AUTO;           // 事件后端，默认内核支持时使用 io_uring
+    int conn_limit = 0;                                 // 连接数上限，0 表示按打开文件数的限制计算
+    int accept_policy = ConnGovernor::POLICY_REJECT;    // 超过上限时回复 503 还是暂停 accept
+
+    // 解析命令行参数
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:n:m:c:s:q:e:l:a:")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 't': loop_num = atoi(optarg); break;
+            case 'n': thread_num = atoi(optarg); break;
+            case 'm': TRIGMode = atoi(optarg); break;
+            case 'c': m_close_log = atoi(optarg); break;
+            case 's': sql_num = atoi(optarg); break;
+            case 'q': async_sql_num = atoi(optarg); break;
+            case 'e':
+                if (strcmp(optarg, "epoll") == 0)
+                    backend = EventBackend::BACKEND_EPOLL;
+                else if (strcmp(optarg, "uring") == 0)
+                    backend = EventBackend::BACKEND_URING;
+                else
+                    backend = EventBackend::BACKEND_AUTO;
+                break;
+            case 'l': conn_limit = atoi(optarg); break;
+            case 'a':
+                accept_policy = strcmp(optarg, "pause") == 0 ? ConnGovernor::POLICY_PAUSE : ConnGovernor::POLICY_REJECT;
+                break;
+            default: break;
+        }
+    }
+
+    // 对端关闭后继续写入不应终止进程
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!m_close_log)
+        Log::getInstance()->init("httpserver", false);
+
+    // 从配置文件中读取 http 根目录，没有配置时使用当前目录下的 root
+    static char root[FILE_PATH_MAX_LINE] = {0};
+    const char *conf_path = GetConfigPath();
+    if (ReadConfig(conf_path, "doc-root", root) == nullptr) {
+        getcwd(root, FILE_PATH_MAX_LINE - 6);
+        strcat(root, "/root");
+    }
+
+    // 配置了数据库用户时初始化 mysql 连接池，并加载用户表
+    char sql_user[LINE_MAX] = {0};
+    char sql_passwd[LINE_MAX] = {0};
+    char sql_name[LINE_MAX] = {0};
+    char sql_host[LINE_MAX] = "localhost";
+    if (sql_num > 0 && ReadConfig(conf_path, "sql-user", sql_user) != nullptr) {
+        ReadConfig(conf_path, "sql-passwd", sql_passwd);
+        ReadConfig(conf_path, "sql-name", sql_name);
+        ReadConfig(conf_path, "sql-host", sql_host);
+
+        // 数据库暂时不可用时照常启动，连接池在后台重试，用户表在下一次刷新时加载
+        if (!MysqlPool::get()->init(sql_host, sql_user, sql_passwd, sql_name, 3306, sql_num, m_close_log))
+            LogWarn("mysql is unavailable at startup, keep retrying.");
+        // startRefresh 先记录日志开关，后台线程第一次刷新在一个间隔之后
+        CredentialStore::get()->startRefresh(MysqlPool::get(), CREDENTIAL_REFRESH_MS, m_close_log);
+        CredentialStore::get()->refresh(MysqlPool::get());
+    }
+
+    // 路由只在启动前注册，没有匹配的 url 按根目录下的文件处理
+    Router::get()->addHandler(1 << HttpConn::GET, "/server-status", serverStatus);
+    Router::get()->addHandler(1 << HttpConn::POST, "/api/login", login);
+    Router::get()->addHandler(1 << HttpConn::GET, "/api/users/count", userCount);
+
+    // 只有配置了 upload-root 时才接受上传，上传目录不能在 doc-root 中，否则上传的文件会被当成静态文件发出
+    char upload_root[FILE_PATH_MAX_LINE] = {0};
+    if (ReadConfig(conf_path, "upload-root", upload_root) != nullptr) {
+        char real_root[PATH_MAX], real_upload[PATH_MAX];
+        int root_len = realpath(root, real_root) ? strlen(real_root) : 0;
+        if (realpath(upload_root, real_upload) == nullptr) {
+            LogError("upload-root %s: %s, uploads are disabled.", upload_root, strerror(errno));
+        } else if (root_len > 0 && strncmp(real_upload, real_root, root_len) == 0 && \
+                   (real_root[root_len - 1] == '/' || real_upload[root_len] == '/' || real_upload[root_len] == '\0')) {
+            LogError("upload-root %s is inside doc-root, uploads are disabled.", upload_root);
+        } else {
+            Router::get()->addUpload(UPLOAD_PATH_PREFIX, real_upload);
+        }
+    }
 
-    Log::getInstance()->init("httpserver", false, 8192, 100);
-    // Log::getInstance()->init("httpserver", false, 8192, 100, 0, 0);
+    // 静态文件缓存，默认 256MB 字节预算
+    FileCache::get()->init(FILE_CACHE_MAX_BYTES, FILE_CACHE_MAX_FILES, m_close_log);
 
-    for (int i = 0; i < 1000; i++) {
-        char buffer[1024];
-        sprintf(buffer, "这是第: %d", i+1);
-        LogError(buffer);
+    WebServer server;
+    server.init(port, root, loop_num, thread_num, TRIGMode, m_close_log, sql_user, sql_passwd, sql_name, backend, \
+                conn_limit, accept_policy, sql_host, sql_num > 0 ? async_sql_num : 0);
+    if (!server.start()) {
+        LogError("httpserver start failed.");
+        return EXIT_FAILURE;
     }
 
-    while (1);
     return 0;
-}
\ No newline at end of file
+}
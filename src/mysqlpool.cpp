@@ -1,86 +1,184 @@
 #include <exception>
+#include <time.h>
+#include <vector>
 #include "mysqlpool.h"
+#include "timerwheel.h"
 #include "log.h"
 
+/* mysql 客户端错误码的范围(CR_MIN_ERROR 到 CR_MAX_ERROR)，出现时连接不能继续使用 */
+static const unsigned int CLIENT_ERROR_MIN = 2000;
+static const unsigned int CLIENT_ERROR_MAX = 2999;
+
+// 当前时间加上 ms 毫秒，pthread_cond_timedwait 使用的绝对时间
+static struct timespec AfterMs(int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ++ts.tv_sec;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
 MysqlPool::MysqlPool() {
-    m_free = 0;
+    m_min = 0;
+    m_max = 0;
     m_use = 0;
     m_size = 0;
     m_prot = 0;
+    m_retry_at = 0;
+    m_check_ms = MYSQL_POOL_CHECK_MS;
+    m_idle_ms = MYSQL_POOL_IDLE_MS;
+    m_max_age_ms = MYSQL_POOL_MAX_AGE_MS;
+    m_stop = false;
+    m_started = false;
+    m_close_log = true;
 }
 
 MysqlPool::~MysqlPool() {
     destroyMysqlConnect();
 }
 
+void MysqlPool::setMaintain(int check_ms, int idle_ms, int max_age_ms) {
+    m_check_ms = check_ms;
+    m_idle_ms = idle_ms;
+    m_max_age_ms = max_age_ms;
+}
+
 // 初始化msyql
-void MysqlPool::init(const string &ip, const string &user, const string passwd, const string &db, \
-                     int port, int max_conn, int close_log) {
+bool MysqlPool::init(const string &ip, const string &user, const string passwd, const string &db, \
+                     int port, int max_conn, int close_log, int min_conn) {
     m_ip = ip;
     m_user = user;
     m_passwd = passwd;
     m_db = db;
     m_prot = port;
     m_close_log = close_log;
+    m_max = max_conn > 0 ? max_conn : 1;
+    m_min = min_conn < 0 ? 0 : (min_conn > m_max ? m_max : min_conn);
 
-    // 创建连接池
+    // 先建立最少的连接，一个失败时说明数据库不可用，剩下的交给维护线程
     LogInfo("start make mysql connect pool.");
-    for (int i = 0; i < max_conn; ++i) {
-        MYSQL *conn = nullptr;
-        conn = mysql_init(nullptr);
-        if (conn == nullptr) {
-            LogError("mysql init failed.");
-            exit(EXIT_FAILURE);
-        }
+    for (int i = 0; i < m_min; ++i) {
+        m_mutex.lock();
+        ++m_size;
+        m_mutex.unlock();
 
-        conn = mysql_real_connect(conn, m_ip.c_str(), m_user.c_str(), m_passwd.c_str(), m_db.c_str(), m_prot, nullptr, 0);
-        if (conn == nullptr) {
-            LogError("mysql real connect failed.");
-            free(conn); // 释放产生的资源
-            continue;
-        }
+        MYSQL *sql = grow(TimerWheel::nowMs());
+        if (sql == nullptr)
+            break;
 
-        m_sql_pool.push_back(conn);
-        ++m_free;
-        LogDebug("mysql connect successfully.");
+        m_mutex.lock();
+        m_sql_pool.push_back({sql, TimerWheel::nowMs()});
+        m_mutex.unlock();
     }
-    LogInfo("mysql connect number %d is successfully.", m_free);
+    LogInfo("mysql connect number %d is successfully, min %d, max %d.", m_size, m_min, m_max);
 
-    // 初始化信号量
-    try {
-        m_sem = sem(m_free);
-    } catch (std::exception){
-        LogError("sem init error.");
-        exit(EXIT_FAILURE);
+    // 启动维护线程
+    m_stop = false;
+    if (pthread_create(&m_tid, nullptr, maintainThreadRun, this) != 0) {
+        LogError("mysql pool: create maintain thread failed.");
+        return m_size > 0;
     }
+    m_started = true;
 
-    if (m_free == 0) {
-        LogError("mysql connect pool create failed, quit program.");
-        exit(EXIT_FAILURE);
+    if (m_size == 0 && m_min > 0) {
+        LogError("mysql connect pool has no connect, retry in background.");
+        return false;
     }
-
-    m_size = m_free;
-    m_use = 0;
+    return true;
 }
 
-// 获取一个连接
-MYSQL *MysqlPool::getMysqlConnect() {
-    if (m_free == 0)   // 如果当前的空闲连接为空，则返回nullptr
+// 连接和读写都有超时，数据库不可达时不会一直阻塞
+MYSQL *MysqlPool::connect() {
+    MYSQL *sql = mysql_init(nullptr);
+    if (sql == nullptr) {
+        LogError("mysql init failed.");
+        return nullptr;
+    }
+
+    unsigned int connect_timeout = MYSQL_POOL_CONNECT_TIMEOUT;
+    unsigned int io_timeout = MYSQL_POOL_IO_TIMEOUT;
+    mysql_options(sql, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+    mysql_options(sql, MYSQL_OPT_READ_TIMEOUT, &io_timeout);
+    mysql_options(sql, MYSQL_OPT_WRITE_TIMEOUT, &io_timeout);
+
+    if (mysql_real_connect(sql, m_ip.c_str(), m_user.c_str(), m_passwd.c_str(), m_db.c_str(), m_prot, nullptr, 0) == nullptr) {
+        LogError("mysql real connect failed: %s", mysql_error(sql));
+        mysql_close(sql);
         return nullptr;
+    }
+    LogDebug("mysql connect successfully.");
+    return sql;
+}
+
+MYSQL *MysqlPool::grow(uint64_t now) {
+    MYSQL *sql = connect();
+    StmtCache *stmts = sql ? new StmtCache(sql) : nullptr;
+
+    m_mutex.lock();
+    if (sql != nullptr) {
+        m_conns[sql] = {now, stmts};
+    } else {
+        // 归还名额，等待的线程可以重新判断
+        --m_size;
+        m_retry_at = TimerWheel::nowMs() + MYSQL_POOL_RETRY_MS;
+        m_cond.signal();
+    }
+    m_mutex.unlock();
+    return sql;
+}
+
+void MysqlPool::closeConn(MYSQL *sql, StmtCache *stmts) {
+    delete stmts;
+    mysql_close(sql);
+}
 
-    m_sem.wait();
+// 获取一个连接
+MYSQL *MysqlPool::getMysqlConnect(int timeout_ms) {
+    uint64_t deadline = TimerWheel::nowMs() + (timeout_ms > 0 ? timeout_ms : 0);
 
-    MYSQL *retSql = nullptr;
     m_mutex.lock();
-    // 从连接池中拿区一个
-    retSql = m_sql_pool.front();
-    m_sql_pool.pop_front();
+    while (!m_stop) {
+        // 优先使用最近归还的连接
+        if (!m_sql_pool.empty()) {
+            MYSQL *sql = m_sql_pool.front().m_sql;
+            m_sql_pool.pop_front();
+            ++m_use;
+            m_mutex.unlock();
+            return sql;
+        }
 
-    --m_free;
-    ++m_use;
+        // 没有空闲连接时新建，连接在锁外建立
+        uint64_t now = TimerWheel::nowMs();
+        if (m_size < m_max && now >= m_retry_at) {
+            ++m_size;
+            m_mutex.unlock();
 
+            MYSQL *sql = grow(now);
+            if (sql != nullptr) {
+                m_mutex.lock();
+                ++m_use;
+                m_mutex.unlock();
+            }
+            return sql;
+        }
+
+        // 数据库不可用时没有连接可以等待，直接失败
+        if (m_size == 0 || now >= deadline)
+            break;
+
+        // 连接失败后等到可以重新尝试新建连接的时间
+        uint64_t wake = deadline;
+        if (m_size < m_max && m_retry_at < wake)
+            wake = m_retry_at;
+        struct timespec abstime = AfterMs(wake - now);
+        m_cond.timedwait(m_mutex.getMutex(), &abstime);
+    }
     m_mutex.unlock();
-    return retSql;
+    return nullptr;
 }
 
 // 释放一个连接到连接池
@@ -88,47 +186,215 @@ bool MysqlPool::freeMysqlConnect(MYSQL *sql) {
     if (sql == nullptr)
         return false;
 
-    m_mutex.lock();
+    // 最后一次调用或者预处理语句出现客户端错误时连接已经不能使用
+    unsigned int error = mysql_errno(sql);
+    bool broken = error >= CLIENT_ERROR_MIN && error <= CLIENT_ERROR_MAX;
+    uint64_t now = TimerWheel::nowMs();
 
-    m_sql_pool.push_back(sql);
-    ++m_free;
+    m_mutex.lock();
+    std::unordered_map<MYSQL *, ConnInfo>::iterator it = m_conns.find(sql);
+    if (it == m_conns.end()) {
+        m_mutex.unlock();
+        return false;
+    }
     --m_use;
 
-    m_mutex.unlock();
+    StmtCache *stmts = it->second.m_stmts;
+    broken = broken || stmts->broken();
+    bool aged = m_max_age_ms > 0 && now - it->second.m_created >= (uint64_t)m_max_age_ms;
+    if (m_stop || broken || aged) {
+        m_conns.erase(it);
+        --m_size;
+        m_cond.signal();
+        m_mutex.unlock();
 
-    m_sem.post();
+        if (broken)
+            LogWarn("mysql pool: close broken connect: %s", mysql_error(sql));
+        closeConn(sql, stmts);
+        return true;
+    }
+
+    m_sql_pool.push_front({sql, now});
+    m_cond.signal();
+    m_mutex.unlock();
     return true;
 }
 
-// 释放所有连接
-void MysqlPool::destroyMysqlConnect() {
+void MysqlPool::maintain() {
+    std::vector<std::pair<MYSQL *, StmtCache *> > closing;
+    std::vector<IdleConn> checking;
+    uint64_t now = TimerWheel::nowMs();
+
+    // 取出要关闭和要 ping 的空闲连接，ping 期间它们仍然计入 m_size
     m_mutex.lock();
+    int keep = m_size;
+    std::list<IdleConn>::iterator it = m_sql_pool.begin();
+    while (it != m_sql_pool.end()) {
+        ConnInfo &info = m_conns[it->m_sql];
+        bool aged = m_max_age_ms > 0 && now - info.m_created >= (uint64_t)m_max_age_ms;
+        bool idle = now - it->m_idle_since >= (uint64_t)m_idle_ms && keep > m_min;
+        if (aged || idle) {
+            closing.push_back(std::make_pair(it->m_sql, info.m_stmts));
+            m_conns.erase(it->m_sql);
+            --keep;
+            it = m_sql_pool.erase(it);
+        } else if (now - it->m_idle_since >= (uint64_t)m_check_ms) {
+            checking.push_back(*it);
+            it = m_sql_pool.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_size = keep;
+    m_mutex.unlock();
 
-    if (m_sql_pool.size() > 0) {
-        std::list<MYSQL *>::iterator it;
-        for (it = m_sql_pool.begin(); it != m_sql_pool.end(); ++it) {
-            MYSQL *conn = *it;
-            mysql_close(conn);
+    for (size_t i = 0; i < closing.size(); ++i)
+        closeConn(closing[i].first, closing[i].second);
+
+    // ping 失败的连接关闭，之后按最少连接数补足
+    for (size_t i = 0; i < checking.size(); ++i) {
+        MYSQL *sql = checking[i].m_sql;
+        bool alive = mysql_ping(sql) == 0;
+        if (!alive)
+            LogWarn("mysql pool: ping failed: %s", mysql_error(sql));
+
+        StmtCache *stmts = nullptr;
+        m_mutex.lock();
+        if (alive && !m_stop) {
+            m_sql_pool.push_back(checking[i]);
+            m_cond.signal();
+            sql = nullptr;
+        } else {
+            stmts = m_conns[sql].m_stmts;
+            m_conns.erase(sql);
+            --m_size;
         }
+        m_mutex.unlock();
+
+        if (sql != nullptr)
+            closeConn(sql, stmts);
+    }
+
+    // 补足最少连接数，连接失败后等到下一次检查
+    m_mutex.lock();
+    int need = m_min - m_size;
+    if (m_stop || need <= 0 || now < m_retry_at) {
+        m_mutex.unlock();
+        return ;
+    }
+    m_size += need;
+    m_mutex.unlock();
+
+    int added = 0;
+    while (added < need) {
+        MYSQL *sql = grow(TimerWheel::nowMs());
+        if (sql == nullptr)
+            break;
+
+        m_mutex.lock();
+        m_sql_pool.push_front({sql, TimerWheel::nowMs()});
+        m_cond.signal();
+        m_mutex.unlock();
+        ++added;
+    }
+
+    // grow 已经归还了失败的那个名额，归还剩下没有用到的
+    if (added < need) {
+        m_mutex.lock();
+        m_size -= need - added - 1;
+        m_mutex.unlock();
+    }
+    if (added > 0)
+        LogInfo("mysql pool: %d connect added, %d in pool.", added, getSize());
+}
+
+void MysqlPool::maintainLoop() {
+    m_mutex.lock();
+    while (!m_stop) {
+        struct timespec abstime = AfterMs(m_check_ms);
+        m_stop_cond.timedwait(m_mutex.getMutex(), &abstime);
+        if (m_stop)
+            break;
+
+        m_mutex.unlock();
+        maintain();
+        m_mutex.lock();
+    }
+    m_mutex.unlock();
+}
+
+int MysqlPool::getFreeConnect() {
+    m_mutex.lock();
+    int free = m_sql_pool.size();
+    m_mutex.unlock();
+    return free;
+}
+
+int MysqlPool::getUsedConnect() {
+    m_mutex.lock();
+    int use = m_use;
+    m_mutex.unlock();
+    return use;
+}
+
+int MysqlPool::getSize() {
+    m_mutex.lock();
+    int size = m_size;
+    m_mutex.unlock();
+    return size;
+}
 
-        m_free = 0;
-        m_use = 0;
-        m_sem = 0;
-        m_sql_pool.clear();
+// 释放所有连接，正在使用的连接在归还时关闭
+void MysqlPool::destroyMysqlConnect() {
+    m_mutex.lock();
+    m_stop = true;
+    m_cond.broadcast();
+    m_stop_cond.signal();
+    m_mutex.unlock();
+
+    if (m_started) {
+        pthread_join(m_tid, nullptr);
+        m_started = false;
     }
 
+    std::vector<std::pair<MYSQL *, StmtCache *> > closing;
+    m_mutex.lock();
+    for (std::list<IdleConn>::iterator it = m_sql_pool.begin(); it != m_sql_pool.end(); ++it) {
+        closing.push_back(std::make_pair(it->m_sql, m_conns[it->m_sql].m_stmts));
+        m_conns.erase(it->m_sql);
+    }
+    m_size -= m_sql_pool.size();
+    m_sql_pool.clear();
     m_mutex.unlock();
+
+    for (size_t i = 0; i < closing.size(); ++i)
+        closeConn(closing[i].first, closing[i].second);
+}
+
+StmtCache *MysqlPool::getStmtCache(MYSQL *sql) {
+    m_mutex.lock();
+    std::unordered_map<MYSQL *, ConnInfo>::iterator it = m_conns.find(sql);
+    StmtCache *stmts = it != m_conns.end() ? it->second.m_stmts : nullptr;
+    m_mutex.unlock();
+    return stmts;
 }
 
 
 
-MysqlConnRAII::MysqlConnRAII(MYSQL **sql, MysqlPool *sql_pool) {
+MysqlConnRAII::MysqlConnRAII(MYSQL **sql, MysqlPool *sql_pool, int timeout_ms) {
     poolRAII = sql_pool;
 
-    *sql = poolRAII->getMysqlConnect();
+    *sql = poolRAII->getMysqlConnect(timeout_ms);
     sqlRAII = *sql;
+    stmtsRAII = nullptr;
+}
+
+StmtCache *MysqlConnRAII::stmts() {
+    if (stmtsRAII == nullptr && sqlRAII != nullptr)
+        stmtsRAII = poolRAII->getStmtCache(sqlRAII);
+    return stmtsRAII;
 }
 
 MysqlConnRAII::~MysqlConnRAII() {
     poolRAII->freeMysqlConnect(sqlRAII);
-}
\ No newline at end of file
+}
@@ -0,0 +1,223 @@
+#include "outqueue.h"
+
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <string.h>
+#include <errno.h>
+
+OutputQueue::OutputQueue() {
+    m_head = 0;
+    m_count = 0;
+    m_bytes = 0;
+    m_seg_head = nullptr;
+    m_seg_tail = nullptr;
+    m_seg_used = 0;
+}
+
+OutputQueue::~OutputQueue() {
+    clear();
+}
+
+// 取得写响应头的空间
+char *OutputQueue::reserve(int *avail, int want) {
+    if (m_seg_tail == nullptr || BUFFER_SEGMENT_SIZE - m_seg_used < want) {
+        BufferSegment *seg = SegmentPool::get()->alloc();
+        if (m_seg_tail == nullptr)
+            m_seg_head = seg;
+        else
+            m_seg_tail->m_next = seg;
+        m_seg_tail = seg;
+        m_seg_used = 0;
+    }
+
+    *avail = BUFFER_SEGMENT_SIZE - m_seg_used;
+    return m_seg_tail->m_data + m_seg_used;
+}
+
+// 把 reserve 得到的空间中写入的 len 字节加入队列
+bool OutputQueue::commit(int len) {
+    if (len <= 0)
+        return true;
+
+    const char *data = m_seg_tail->m_data + m_seg_used;
+    if (m_count > 0) {
+        OutputChunk *last = at(m_count - 1);
+        if (last->m_seg == m_seg_tail && last->m_data + last->m_len == data) {
+            last->m_len += len;
+            m_seg_used += len;
+            m_bytes += len;
+            return true;
+        }
+    }
+
+    OutputChunk *chunk = push();
+    if (chunk == nullptr)
+        return false;
+    chunk->m_data = data;
+    chunk->m_len = len;
+    chunk->m_seg = m_seg_tail;
+    m_seg_used += len;
+    m_bytes += len;
+    return true;
+}
+
+// 加入一块内存数据
+bool OutputQueue::pushMemory(const char *data, size_t len, FileEntry *file) {
+    if (len == 0) {
+        if (file)
+            FileCache::release(file);
+        return true;
+    }
+
+    OutputChunk *chunk = push();
+    if (chunk == nullptr)
+        return false;
+    chunk->m_data = data;
+    chunk->m_len = len;
+    chunk->m_file = file;
+    m_bytes += len;
+    return true;
+}
+
+// 加入一个文件区域
+bool OutputQueue::pushFile(int fd, off_t offset, size_t len, FileEntry *file) {
+    if (len == 0) {
+        if (file)
+            FileCache::release(file);
+        return true;
+    }
+
+    OutputChunk *chunk = push();
+    if (chunk == nullptr)
+        return false;
+    chunk->m_fd = fd;
+    chunk->m_offset = offset;
+    chunk->m_len = len;
+    chunk->m_file = file;
+    m_bytes += len;
+    return true;
+}
+
+// 加入一个数据块
+OutputChunk *OutputQueue::push() {
+    if (m_count == MAX_CHUNKS)
+        return nullptr;
+
+    OutputChunk *chunk = at(m_count++);
+    chunk->m_data = nullptr;
+    chunk->m_fd = -1;
+    chunk->m_offset = 0;
+    chunk->m_len = 0;
+    chunk->m_seg = nullptr;
+    chunk->m_file = nullptr;
+    return chunk;
+}
+
+// 发送数据直到队列为空或者 EAGAIN
+int OutputQueue::flush(int sockfd) {
+    while (m_count > 0) {
+        OutputChunk *chunk = at(0);
+        ssize_t ret;
+
+        if (chunk->m_data == nullptr) {
+            off_t offset = chunk->m_offset;
+            ret = sendfile(sockfd, chunk->m_fd, &offset, chunk->m_len);
+            if (ret == 0)       // 文件在发送过程中被截断
+                return -1;
+        } else {
+            // 合并队首连续的内存块，遇到文件区域为止
+            struct iovec iv[MAX_CHUNKS];
+            int n = 0;
+            bool file_next = false;
+            for (; n < m_count; ++n) {
+                OutputChunk *c = at(n);
+                if (c->m_data == nullptr) {
+                    file_next = true;
+                    break;
+                }
+                iv[n].iov_base = (void *)c->m_data;
+                iv[n].iov_len = c->m_len;
+            }
+
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iv;
+            msg.msg_iovlen = n;
+            // 后面还有 sendfile 时用 MSG_MORE 让内核把响应头和文件内容合并成满的报文
+            ret = sendmsg(sockfd, &msg, file_next ? MSG_MORE : 0);
+        }
+
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 0;
+            return -1;
+        }
+
+        consume(ret);
+    }
+
+    return 1;
+}
+
+// 从队首消费 len 个已发送的字节
+void OutputQueue::consume(size_t len) {
+    m_bytes -= len;
+
+    while (len > 0) {
+        OutputChunk *chunk = at(0);
+        if (len < chunk->m_len) {
+            if (chunk->m_data)
+                chunk->m_data += len;
+            else
+                chunk->m_offset += len;
+            chunk->m_len -= len;
+            break;
+        }
+
+        len -= chunk->m_len;
+        if (chunk->m_file)
+            FileCache::release(chunk->m_file);
+        m_head = (m_head + 1) % MAX_CHUNKS;
+        --m_count;
+    }
+
+    releaseSegments();
+}
+
+// 归还队列中已不再引用的段，队列为空时全部归还
+void OutputQueue::releaseSegments() {
+    if (m_count == 0) {
+        if (m_seg_head)
+            SegmentPool::get()->freeChain(m_seg_head);
+        m_seg_head = m_seg_tail = nullptr;
+        m_seg_used = 0;
+        m_head = 0;
+        return ;
+    }
+
+    // 段按顺序使用，最早被引用的段之前的段都已发送完，正在写入的段保留
+    BufferSegment *keep = m_seg_tail;
+    for (int i = 0; i < m_count; ++i) {
+        if (at(i)->m_seg) {
+            keep = at(i)->m_seg;
+            break;
+        }
+    }
+    while (m_seg_head != keep) {
+        BufferSegment *next = m_seg_head->m_next;
+        SegmentPool::get()->free(m_seg_head);
+        m_seg_head = next;
+    }
+}
+
+// 丢弃所有数据
+void OutputQueue::clear() {
+    for (int i = 0; i < m_count; ++i) {
+        if (at(i)->m_file)
+            FileCache::release(at(i)->m_file);
+    }
+    m_count = 0;
+    m_bytes = 0;
+    releaseSegments();
+}
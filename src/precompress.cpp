@@ -0,0 +1,180 @@
+/**
+ * 作用: 离线预压缩 http 根目录
+ *      对根目录下的文本类静态文件生成同目录的 .gz 文件，压缩等级默认为最高，
+ *      服务器按 Accept-Encoding 直接发送这些文件，不在请求时压缩
+ *      .gz 文件的修改时间与原文件相同，原文件更新后重新运行即可，没有变化的文件会被跳过
+ *      .br 文件需要用 brotli 命令生成，服务器同样会发送
+ *
+ * 用法: precompress [-l 压缩等级] [-m 最小字节数] 根目录
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+static int _level = Z_BEST_COMPRESSION;     // 压缩等级
+static off_t _min_size = 256;               // 小于该大小的文件不压缩，压缩后反而可能更大
+
+static long _compressed = 0;                // 生成的 .gz 文件数
+static long _skipped = 0;                   // 已经是最新的文件数
+static long _failed = 0;
+static long long _bytes_in = 0;
+static long long _bytes_out = 0;
+
+// 值得压缩的扩展名，图片、视频和压缩包本身已经压缩过
+static const char *_extensions[] = {
+    ".html", ".htm", ".css", ".js", ".mjs", ".json", ".map", ".svg", ".txt", ".xml", ".csv", ".md", ".wasm", ".ico"
+};
+
+static bool compressible(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (dot == nullptr || strchr(dot, '/') != nullptr)
+        return false;
+    for (size_t i = 0; i < sizeof(_extensions) / sizeof(_extensions[0]); ++i) {
+        if (strcasecmp(dot, _extensions[i]) == 0)
+            return true;
+    }
+    return false;
+}
+
+// 把 infd 的内容以 gzip 格式写入 outfd，返回写入的字节数，失败时返回 -1
+static long long gzipFile(int infd, int outfd) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits 加 16 生成 gzip 头，memLevel 9 换取更好的压缩率
+    if (deflateInit2(&stream, _level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+        return -1;
+
+    static unsigned char in[65536], out[65536];
+    long long total = 0;
+    int flush = Z_NO_FLUSH;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END) {
+        if (stream.avail_in == 0 && flush == Z_NO_FLUSH) {
+            ssize_t len = read(infd, in, sizeof(in));
+            if (len < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            stream.next_in = in;
+            stream.avail_in = len;
+            if (len == 0)
+                flush = Z_FINISH;
+        }
+
+        stream.next_out = out;
+        stream.avail_out = sizeof(out);
+        ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_ERROR)
+            break;
+
+        int len = sizeof(out) - stream.avail_out;
+        if (len > 0 && write(outfd, out, len) != len)
+            break;
+        total += len;
+    }
+
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END ? total : -1;
+}
+
+// 压缩一个文件，先写临时文件，压缩有效时才改名为 .gz，否则删除旧的 .gz
+static void precompress(const char *path, const struct stat *st) {
+    char gz[PATH_MAX], tmp[PATH_MAX];
+    if (snprintf(gz, sizeof(gz), "%s.gz", path) >= (int)sizeof(gz) || \
+        snprintf(tmp, sizeof(tmp), "%s.gz.XXXXXX", path) >= (int)sizeof(tmp)) {
+        ++_failed;
+        return ;
+    }
+
+    struct stat gst;
+    if (stat(gz, &gst) == 0 && gst.st_mtime == st->st_mtime) {
+        ++_skipped;
+        return ;
+    }
+
+    int infd = open(path, O_RDONLY | O_CLOEXEC);
+    if (infd < 0) {
+        fprintf(stderr, "open %s failed: %s\n", path, strerror(errno));
+        ++_failed;
+        return ;
+    }
+    int outfd = mkostemp(tmp, O_CLOEXEC);
+    if (outfd < 0) {
+        fprintf(stderr, "create %s failed: %s\n", tmp, strerror(errno));
+        close(infd);
+        ++_failed;
+        return ;
+    }
+
+    long long len = gzipFile(infd, outfd);
+    close(infd);
+
+    // 压缩后至少小 5% 才值得多一个文件
+    if (len < 0 || len * 20 > (long long)st->st_size * 19) {
+        if (len < 0) {
+            fprintf(stderr, "compress %s failed\n", path);
+            ++_failed;
+        }
+        close(outfd);
+        unlink(tmp);
+        unlink(gz);
+        return ;
+    }
+
+    // 与原文件相同的权限和修改时间，服务器据此判断 .gz 没有过期
+    struct timespec times[2] = {st->st_atim, st->st_mtim};
+    fchmod(outfd, st->st_mode & 07777);
+    futimens(outfd, times);
+    close(outfd);
+    if (rename(tmp, gz) < 0) {
+        fprintf(stderr, "rename %s failed: %s\n", gz, strerror(errno));
+        unlink(tmp);
+        ++_failed;
+        return ;
+    }
+
+    ++_compressed;
+    _bytes_in += st->st_size;
+    _bytes_out += len;
+}
+
+static int visit(const char *path, const struct stat *st, int type, struct FTW *) {
+    if (type == FTW_F && S_ISREG(st->st_mode) && st->st_size >= _min_size && compressible(path))
+        precompress(path, st);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "l:m:")) != -1) {
+        switch (opt) {
+            case 'l': _level = atoi(optarg); break;
+            case 'm': _min_size = atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-l level] [-m min_size] doc_root\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc || _level < 1 || _level > 9) {
+        fprintf(stderr, "usage: %s [-l level] [-m min_size] doc_root\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (nftw(argv[optind], visit, 32, FTW_PHYS) < 0) {
+        fprintf(stderr, "walk %s failed: %s\n", argv[optind], strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    printf("compressed: %ld, up to date: %ld, failed: %ld, %lld -> %lld bytes\n", \
+           _compressed, _skipped, _failed, _bytes_in, _bytes_out);
+    return _failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,90 @@
+#include "range.h"
+
+#include <strings.h>
+
+// 解析一个十进制数，至少一位数字，溢出时返回 false
+static bool parseUint(const char *&pos, const char *end, uint64_t *value) {
+    if (pos >= end || *pos < '0' || *pos > '9')
+        return false;
+
+    uint64_t result = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos) {
+        if (result > (UINT64_MAX - 9) / 10)
+            return false;
+        result = result * 10 + (*pos - '0');
+    }
+    *value = result;
+    return true;
+}
+
+static void skipBlank(const char *&pos, const char *end) {
+    while (pos < end && (*pos == ' ' || *pos == '\t'))
+        ++pos;
+}
+
+// 解析 Range 请求头的值
+int HttpRange::parse(const TokenSpan &value, uint64_t size, ByteRange *ranges, int max) {
+    const char *pos = value.m_data;
+    const char *end = value.m_data + value.m_len;
+
+    if (value.m_len < 6 || strncasecmp(pos, "bytes=", 6) != 0)
+        return 0;
+    pos += 6;
+
+    int count = 0;
+    bool valid = false;     // 至少有一个格式正确的范围
+    while (true) {
+        skipBlank(pos, end);
+        uint64_t first = 0, last = 0;
+        bool has_first = false, has_last = false;
+
+        if (pos < end && *pos != '-') {
+            if (!parseUint(pos, end, &first))
+                return 0;
+            has_first = true;
+        }
+        if (pos >= end || *pos != '-')
+            return 0;
+        ++pos;
+        if (pos < end && *pos >= '0' && *pos <= '9') {
+            if (!parseUint(pos, end, &last))
+                return 0;
+            has_last = true;
+        }
+        if (!has_first && !has_last)
+            return 0;
+        if (has_first && has_last && last < first)
+            return 0;
+        valid = true;
+
+        // 只保留与文件有交集的范围
+        ByteRange range;
+        bool satisfiable;
+        if (has_first) {
+            satisfiable = first < size;
+            range.m_start = first;
+            range.m_end = has_last && last < size ? last : size - 1;
+        } else {
+            // 最后 n 个字节
+            satisfiable = last > 0 && size > 0;
+            range.m_start = last < size ? size - last : 0;
+            range.m_end = size - 1;
+        }
+        if (satisfiable) {
+            if (count == max)
+                return 0;
+            ranges[count++] = range;
+        }
+
+        skipBlank(pos, end);
+        if (pos == end)
+            break;
+        if (*pos != ',')
+            return 0;
+        ++pos;
+    }
+
+    if (count == 0)
+        return valid ? -1 : 0;
+    return count;
+}
@@ -0,0 +1,538 @@
+#include "reactor.h"
+#include "uring.h"
+#include "response.h"
+#include "log.h"
+#include "debug.h"
+
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+
+thread_local bool EventLoop::s_in_loop = false;
+
+EventLoop::EventLoop() : m_timer(TimerWheel::nowMs()) {
+    m_id = 0;
+    m_backend = nullptr;
+    m_backend_type = EventBackend::BACKEND_EPOLL;
+    m_listenfd = -1;
+    m_wakeupfd = -1;
+    m_stop = false;
+    m_conns = nullptr;
+    m_pool = nullptr;
+    m_governor = ConnGovernor::get();
+    m_accept_paused = false;
+    m_last_report = 0;
+    m_root = nullptr;
+    m_TRIGMode = 0;
+    m_close_log = 0;
+    m_async_sql_num = 0;
+    m_db = nullptr;
+    m_now = TimerWheel::nowMs();
+}
+
+EventLoop::~EventLoop() {
+    // AsyncDb 析构时从事件后端取消 watch，先于后端释放
+    if (m_db) delete m_db;
+
+    if (m_listenfd != -1) close(m_listenfd);
+
+    if (m_wakeupfd != -1) close(m_wakeupfd);
+
+    if (m_backend) delete m_backend;
+}
+
+// 初始化 reactor，创建监听套接字以及用于退出的 eventfd，事件后端在 loop 中创建
+bool EventLoop::init(int id, int port, ConnSlab *conns, ThreadPool<HttpConn> *pool, char *root, int TRIGMode, int backend, \
+                     int close_log, const std::string &user, const std::string &passwd, const std::string &sqlname, \
+                     const std::string &host, int async_sql_num) {
+    m_id = id;
+    m_conns = conns;
+    m_pool = pool;
+    m_root = root;
+    m_TRIGMode = TRIGMode;
+    m_backend_type = backend;
+    m_close_log = close_log;
+    m_sql_user = user;
+    m_sql_passwd = passwd;
+    m_sql_name = sqlname;
+    m_sql_host = host;
+    m_async_sql_num = async_sql_num;
+
+    if (!createListen(port))
+        return false;
+
+    m_wakeupfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeupfd == -1) {
+        LogError("reactor %d: eventfd failed: %s", m_id, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+// 在 reactor 线程中创建事件后端
+// io_uring 在本线程内处理请求，工作线程池会在其它线程发送和重新等待读，这时只能使用 epoll
+bool EventLoop::createBackend() {
+    if (m_backend_type != EventBackend::BACKEND_EPOLL) {
+        if (m_pool == nullptr && UringBackend::supported()) {
+            m_backend = new UringBackend(m_close_log);
+            if (m_backend->init(m_listenfd, m_wakeupfd)) {
+                LogInfo("reactor %d: use io_uring backend.", m_id);
+                return true;
+            }
+            delete m_backend;
+            m_backend = nullptr;
+        }
+        if (m_backend_type == EventBackend::BACKEND_URING)
+            LogError("reactor %d: io_uring backend not available, fall back to epoll.", m_id);
+    }
+
+    // 监听套接字和 eventfd 使用 LT 模式且不设置 EPOLLONESHOT，所有连接都由本线程 accept
+    m_backend = new EpollBackend(m_TRIGMode);
+    if (!m_backend->init(m_listenfd, m_wakeupfd)) {
+        LogError("reactor %d: create epoll failed: %s", m_id, strerror(errno));
+        return false;
+    }
+    LogInfo("reactor %d: use epoll backend.", m_id);
+    return true;
+}
+
+// 处理函数在工作线程中运行时不能使用本线程的 AsyncDb，只在 reactor 线程内处理请求时创建
+void EventLoop::createAsyncDb() {
+    if (m_async_sql_num <= 0 || m_sql_user.empty())
+        return ;
+    if (m_pool != nullptr) {
+        LogWarn("reactor %d: async mysql queries need requests processed in reactor, disabled.", m_id);
+        return ;
+    }
+
+    m_db = new AsyncDb();
+    if (!m_db->init(m_backend, m_sql_host, 3306, m_sql_user, m_sql_passwd, m_sql_name, m_async_sql_num, \
+                    ASYNC_DB_QUERY_TIMEOUT, m_close_log)) {
+        delete m_db;
+        m_db = nullptr;
+        return ;
+    }
+    AsyncDb::setLocal(m_db);
+    LogInfo("reactor %d: %d async mysql connections.", m_id, m_async_sql_num);
+}
+
+// 创建 SO_REUSEPORT 监听套接字
+bool EventLoop::createListen(int port) {
+    m_listenfd = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenfd < 0) {
+        LogError("reactor %d: socket failed: %s", m_id, strerror(errno));
+        return false;
+    }
+
+    // 每个 reactor 绑定同一个端口，由内核按四元组哈希把连接分发给各个监听套接字
+    int flag = 1;
+    setsockopt(m_listenfd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    if (setsockopt(m_listenfd, SOL_SOCKET, SO_REUSEPORT, &flag, sizeof(flag)) < 0) {
+        LogError("reactor %d: SO_REUSEPORT failed: %s", m_id, strerror(errno));
+        return false;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(m_listenfd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        LogError("reactor %d: bind port %d failed: %s", m_id, port, strerror(errno));
+        return false;
+    }
+
+    if (listen(m_listenfd, LISTEN_BACKLOG) < 0) {
+        LogError("reactor %d: listen failed: %s", m_id, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+// 处理新连接，LT 模式下循环 accept 直到 EAGAIN
+void EventLoop::dealConnection() {
+    struct sockaddr_in client_address;
+    socklen_t client_addrlength = sizeof(client_address);
+
+    while (true) {
+        // PAUSE 策略下达到上限后不再 accept，新连接留在 backlog 中
+        if (m_governor->policy() == ConnGovernor::POLICY_PAUSE && m_governor->full()) {
+            pauseAccept(true);
+            break;
+        }
+
+        int connfd = accept(m_listenfd, (struct sockaddr *)&client_address, &client_addrlength);
+        if (connfd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                LogError("reactor %d: accept error: %s", m_id, strerror(errno));
+            break;
+        }
+
+        newConnection(connfd, client_address);
+    }
+}
+
+// 初始化一个新连接，connfd 由 dealConnection 或者后端 accept
+void EventLoop::newConnection(int connfd, const sockaddr_in &client_address) {
+    HttpConn *conn = m_conns->acquire(connfd);
+    if (conn == nullptr) {
+        LogError("reactor %d: fd %d out of range.", m_id, connfd);
+        rejectConnection(connfd);
+        return ;
+    }
+    if (!m_governor->admit(m_id)) {
+        rejectConnection(connfd);
+        return ;
+    }
+    // io_uring 在内核中提前 accept，PAUSE 策略下占满名额时立即暂停，不等下一个连接被拒绝
+    if (m_governor->policy() == ConnGovernor::POLICY_PAUSE && m_governor->full())
+        pauseAccept(true);
+
+    // 小响应较多，关闭 Nagle 算法减少 keep-alive 请求的延迟
+    int flag = 1;
+    setsockopt(connfd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    conn->init(connfd, client_address, m_backend, m_root, m_TRIGMode, m_close_log);
+
+    // 新连接在读到第一个字节之前按空闲连接计时
+    conn->m_last_active = m_now;
+    conn->m_request_start = m_now;
+    m_timer.add(&conn->m_timer, m_now + KEEPALIVE_TIMEOUT);
+}
+
+// 连接还没有注册到事件后端，直接回复 503 后关闭
+// 关闭前丢弃已经到达的请求，接收缓冲区中有未读数据时 close 会发送 RST，客户端可能收不到 503
+void EventLoop::rejectConnection(int connfd) {
+    char buf[512];
+    ResponseWriter writer(buf, sizeof(buf));
+    const StatusTemplate *status = HttpStatus::get(503);
+    writer.statusLine(status);
+    writer.append("Retry-After: 1\r\n", sizeof("Retry-After: 1\r\n") - 1);
+    writer.contentLength(status->m_body_len);
+    writer.connection(false);
+    writer.end();
+    writer.append(status->m_body, status->m_body_len);
+    send(connfd, buf, writer.length(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    shutdown(connfd, SHUT_WR);
+    for (int i = 0; i < 4 && recv(connfd, buf, sizeof(buf), MSG_DONTWAIT) > 0; ++i);
+    close(connfd);
+
+    m_governor->reject(m_id);
+    if (m_governor->policy() == ConnGovernor::POLICY_PAUSE)
+        pauseAccept(true);
+    reportGovernor();
+}
+
+// 暂停时新连接留在 backlog 中，事件循环每 ACCEPT_PAUSE_POLL_MS 检查一次连接数是否降到恢复水位
+void EventLoop::pauseAccept(bool pause) {
+    if (pause == m_accept_paused)
+        return ;
+
+    m_accept_paused = pause;
+    m_backend->pauseAccept(pause);
+    m_governor->pause(m_id, pause);
+    if (pause) {
+        LogWarn("reactor %d: %d connections reach the limit %d, pause accept.", m_id, m_governor->active(), m_governor->limit());
+        reportGovernor();
+    } else {
+        LogInfo("reactor %d: %d connections, resume accept.", m_id, m_governor->active());
+    }
+}
+
+// 只在过载时输出，正常运行时不产生日志
+void EventLoop::reportGovernor() {
+    if (m_now < m_last_report + GOVERNOR_REPORT_MS)
+        return ;
+
+    m_last_report = m_now;
+    char buf[256];
+    m_governor->report(buf, sizeof(buf));
+    LogWarn("reactor %d: %s", m_id, buf);
+}
+
+// 处理读事件，epoll 后端由连接自己 recv，io_uring 后端把已经收到的数据交给连接
+void EventLoop::dealRead(const BackendEvent &event) {
+    HttpConn *conn = m_conns->get(event.m_fd);
+    // 同一批事件中连接已经被前面的事件关闭
+    if (conn == nullptr || conn->getSockfd() != event.m_fd)
+        return ;
+
+    bool idle = conn->isIdle();
+    bool ok;
+    if (event.m_data) {
+        int used = conn->receive(event.m_data, event.m_len);
+        m_backend->release(event, used > 0 ? used : 0);
+        ok = used > 0;
+    } else {
+        ok = conn->readOnce();
+    }
+    if (!ok) {
+        closeConn(conn);
+        return ;
+    }
+
+    // 新请求的第一个字节到达时开始计算请求头超时
+    conn->m_last_active = m_now;
+    if (idle)
+        conn->m_request_start = m_now;
+
+    // 按请求头超时和读间隔超时中较早的一个设置定时器，请求处理完以后定时器到期时再按实际状态延长
+    uint64_t expire = conn->m_request_start + REQUEST_HEADER_TIMEOUT;
+    if (expire > m_now + REQUEST_BODY_TIMEOUT)
+        expire = m_now + REQUEST_BODY_TIMEOUT;
+    m_timer.modify(&conn->m_timer, expire);
+
+    // 读事件是一次性的，在 process 重新 armRead 之前不会再触发，交给工作线程不需要加锁
+    conn->m_busy.fetch_add(1, std::memory_order_relaxed);
+    if (m_pool == nullptr || !m_pool->append(conn))
+        conn->process();
+}
+
+// 处理写事件
+void EventLoop::dealWrite(int sockfd) {
+    HttpConn *conn = m_conns->get(sockfd);
+    if (conn == nullptr || conn->getSockfd() != sockfd)
+        return ;
+
+    conn->m_last_active = m_now;
+    if (!conn->write())
+        closeConn(conn);
+}
+
+// 处理到期的连接定时器，定时器已经从时间轮中摘下
+void EventLoop::dealTimer(HttpConn *conn) {
+    // 工作线程还在处理这个连接，稍后再检查
+    if (conn->m_busy.load(std::memory_order_acquire) > 0) {
+        m_timer.add(&conn->m_timer, m_now + TIMER_TICK_MS * 10);
+        return ;
+    }
+
+    // 连接的状态在定时器设置之后可能已经变化，按当前状态重新计算
+    uint64_t expire = conn->expireTime();
+    if (expire > m_now) {
+        m_timer.add(&conn->m_timer, expire);
+        return ;
+    }
+
+    LogInfo("reactor %d: connection %s timeout, close.", m_id, conn->isIdle() ? "idle" : "request");
+    closeConn(conn);
+}
+
+// 删除定时器并关闭连接，同一个连接可能收到多个关闭事件，只归还一次名额
+void EventLoop::closeConn(HttpConn *conn) {
+    m_timer.remove(&conn->m_timer);
+    if (conn->getSockfd() != -1)
+        m_governor->release(m_id);
+    conn->closeConn();
+}
+
+// 事件循环，直到 stop 被调用
+void EventLoop::loop() {
+    if (m_backend == nullptr && !createBackend())
+        return ;
+    s_in_loop = true;
+    createAsyncDb();
+
+    LogInfo("reactor %d start.", m_id);
+
+    while (!m_stop) {
+        int timeout = m_timer.nextTimeout(m_now);
+        if (m_db) {
+            int db_timeout = m_db->nextTimeout(m_now);
+            if (db_timeout >= 0 && (timeout < 0 || db_timeout < timeout))
+                timeout = db_timeout;
+        }
+        if (m_accept_paused && (timeout < 0 || timeout > ACCEPT_PAUSE_POLL_MS))
+            timeout = ACCEPT_PAUSE_POLL_MS;
+        int number = m_backend->wait(m_events, MAX_EVENT_NUMBER, timeout);
+        if (number < 0) {
+            LogError("reactor %d: %s wait failed: %s", m_id, m_backend->name(), strerror(errno));
+            break;
+        }
+
+        m_now = TimerWheel::nowMs();
+
+        for (int i = 0; i < number; ++i) {
+            const BackendEvent &event = m_events[i];
+            switch (event.m_type) {
+                case BackendEvent::EVENT_ACCEPT:
+                    if (event.m_fd == -1) {
+                        dealConnection();
+                    } else {
+                        // 后端已经 accept，地址只用于日志，按需查询
+                        struct sockaddr_in client_address;
+                        socklen_t client_addrlength = sizeof(client_address);
+                        memset(&client_address, 0, sizeof(client_address));
+                        getpeername(event.m_fd, (struct sockaddr *)&client_address, &client_addrlength);
+                        newConnection(event.m_fd, client_address);
+                    }
+                    break;
+                case BackendEvent::EVENT_WAKEUP: {
+                    uint64_t one;
+                    read(m_wakeupfd, &one, sizeof(one));
+                    break;
+                }
+                case BackendEvent::EVENT_CLOSE: {
+                    // 对端关闭或出错，直接关闭连接
+                    HttpConn *conn = m_conns->get(event.m_fd);
+                    if (conn != nullptr)
+                        closeConn(conn);
+                    break;
+                }
+                case BackendEvent::EVENT_READ:
+                    dealRead(event);
+                    break;
+                case BackendEvent::EVENT_WRITE:
+                    dealWrite(event.m_fd);
+                    break;
+                case BackendEvent::EVENT_PROGRESS: {
+                    HttpConn *conn = m_conns->get(event.m_fd);
+                    if (conn != nullptr && conn->getSockfd() == event.m_fd)
+                        conn->m_last_active = m_now;
+                    break;
+                }
+                case BackendEvent::EVENT_POLL:
+                    if (m_db)
+                        m_db->handleEvent(event.m_fd, event.m_len);
+                    break;
+            }
+        }
+
+        // 事件处理完再检查定时器，被定时器关闭的 fd 不会残留在本轮的事件里
+        m_timer.advance(m_now, timerCallback, this);
+
+        // 本轮事件中提交的查询在下一次等待之前发出
+        if (m_db)
+            m_db->advance(m_now);
+
+        // 连接数降到恢复水位以下时继续 accept，其它 reactor 占满名额时也尽早暂停
+        if (m_governor->policy() == ConnGovernor::POLICY_PAUSE) {
+            if (m_accept_paused && m_governor->canResume())
+                pauseAccept(false);
+            else if (!m_accept_paused && m_governor->full())
+                pauseAccept(true);
+        }
+    }
+
+    LogInfo("reactor %d quit.", m_id);
+}
+
+// 通知事件循环退出，可在其它线程调用
+void EventLoop::stop() {
+    m_stop = true;
+    if (m_wakeupfd != -1) {
+        uint64_t one = 1;
+        ::write(m_wakeupfd, &one, sizeof(one));
+    }
+}
+
+
+WebServer::WebServer() {
+    m_port = 0;
+    m_root = nullptr;
+    m_loop_num = 0;
+    m_thread_num = 0;
+    m_TRIGMode = 0;
+    m_backend = EventBackend::BACKEND_AUTO;
+    m_close_log = 0;
+    m_conn_limit = 0;
+    m_accept_policy = ConnGovernor::POLICY_REJECT;
+    m_async_sql_num = 0;
+    m_loops = nullptr;
+    m_pool = nullptr;
+    m_tids = nullptr;
+}
+
+WebServer::~WebServer() {
+    if (m_pool) delete m_pool;
+
+    if (m_loops) delete [] m_loops;
+
+    if (m_tids) delete [] m_tids;
+}
+
+// 初始化服务器参数，loop_num 为 reactor 线程数，thread_num 为工作线程数
+void WebServer::init(int port, char *root, int loop_num, int thread_num, int TRIGMode, int close_log, \
+                     const std::string &user, const std::string &passwd, const std::string &sqlname, int backend, \
+                     int conn_limit, int accept_policy, const std::string &host, int async_sql_num) {
+    m_port = port;
+    m_root = root;
+    m_loop_num = loop_num > 0 ? loop_num : 1;
+    m_thread_num = thread_num > 0 ? thread_num : 0;
+    m_TRIGMode = TRIGMode;
+    m_backend = backend;
+    m_close_log = close_log;
+    m_conn_limit = conn_limit;
+    m_accept_policy = accept_policy;
+    m_sql_user = user;
+    m_sql_passwd = passwd;
+    m_sql_name = sqlname;
+    m_sql_host = host;
+    m_async_sql_num = async_sql_num;
+
+    ConnGovernor::get()->init(m_loop_num, m_conn_limit, m_accept_policy);
+    LogInfo("webserver: connection limit %d, %s when exceeded.", ConnGovernor::get()->limit(), \
+            m_accept_policy == ConnGovernor::POLICY_PAUSE ? "pause accept" : "reject with 503");
+
+    // 只预留地址空间，连接对象在 fd 第一次使用时构造
+    if (!m_conns.init(MAX_FD))
+        LogError("webserver: reserve %d connection slots failed.", MAX_FD);
+    m_loops = new EventLoop[m_loop_num];
+    m_tids = new pthread_t[m_loop_num];
+
+    if (m_thread_num > 0) {
+        try {
+            m_pool = new ThreadPool<HttpConn>(m_thread_num, MAX_FD);
+        } catch (std::exception &) {
+            LogError("webserver: create thread pool failed, process requests in reactor.");
+            m_pool = nullptr;
+        }
+    }
+}
+
+// 启动所有 reactor，第 0 个 reactor 运行在当前线程，阻塞直到 stop
+bool WebServer::start() {
+    for (int i = 0; i < m_loop_num; ++i) {
+        if (!m_loops[i].init(i, m_port, &m_conns, m_pool, m_root, m_TRIGMode, m_backend, m_close_log, \
+                             m_sql_user, m_sql_passwd, m_sql_name, m_sql_host, m_async_sql_num)) {
+            LogError("webserver: reactor %d init failed.", i);
+            return false;
+        }
+    }
+
+    // 每个 reactor 绑定到一个 cpu，避免线程迁移带来的缓存失效
+    int cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; i < m_loop_num; ++i) {
+        if (pthread_create(m_tids + i, nullptr, EventLoop::loopThreadRun, m_loops + i) != 0) {
+            LogError("webserver: create reactor thread %d failed.", i);
+            return false;
+        }
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(i % cpu_num, &cpuset);
+        pthread_setaffinity_np(m_tids[i], sizeof(cpuset), &cpuset);
+    }
+
+    m_tids[0] = pthread_self();
+    m_loops[0].loop();
+
+    for (int i = 1; i < m_loop_num; ++i)
+        pthread_join(m_tids[i], nullptr);
+
+    return true;
+}
+
+// 停止所有 reactor
+void WebServer::stop() {
+    for (int i = 0; i < m_loop_num; ++i)
+        m_loops[i].stop();
+}
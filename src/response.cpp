@@ -0,0 +1,182 @@
+#include "response.h"
+#include "range.h"
+
+#include <time.h>
+
+#define STATUS_TEMPLATE(code, title, body) \
+    { code, "HTTP/1.1 " #code " " title "\r\nContent-Type: text/html\r\n", \
+      sizeof("HTTP/1.1 " #code " " title "\r\nContent-Type: text/html\r\n") - 1, body, sizeof(body) - 1 }
+
+// 错误页面
+#define ERROR_400_FORM "Your request has bad syntax or is inherently impossible to staisfy.\n"
+#define ERROR_403_FORM "You do not have permission to get file form this server.\n"
+#define ERROR_404_FORM "The requested file was not found on this server.\n"
+#define ERROR_405_FORM "The request method is not supported for the requested resource.\n"
+#define ERROR_413_FORM "The request body is larger than the server is willing to accept.\n"
+#define ERROR_416_FORM "The requested range is not satisfiable.\n"
+#define ERROR_500_FORM "There was an unusual problem serving the request file.\n"
+#define ERROR_501_FORM "The request uses a feature the server does not support.\n"
+#define ERROR_503_FORM "The server is handling too many connections, please retry later.\n"
+
+static const StatusTemplate _status_200 = STATUS_TEMPLATE(200, "Ok", "<html><body></body></html>");
+static const StatusTemplate _status_201 = STATUS_TEMPLATE(201, "Created", "<html><body>Created</body></html>");
+static const StatusTemplate _status_400 = STATUS_TEMPLATE(400, "Bad Request", ERROR_400_FORM);
+static const StatusTemplate _status_403 = STATUS_TEMPLATE(403, "Forbidden", ERROR_403_FORM);
+static const StatusTemplate _status_404 = STATUS_TEMPLATE(404, "Not Found", ERROR_404_FORM);
+static const StatusTemplate _status_405 = STATUS_TEMPLATE(405, "Method Not Allowed", ERROR_405_FORM);
+static const StatusTemplate _status_413 = STATUS_TEMPLATE(413, "Payload Too Large", ERROR_413_FORM);
+static const StatusTemplate _status_500 = STATUS_TEMPLATE(500, "Internal Error", ERROR_500_FORM);
+static const StatusTemplate _status_501 = STATUS_TEMPLATE(501, "Not Implemented", ERROR_501_FORM);
+static const StatusTemplate _status_503 = STATUS_TEMPLATE(503, "Service Unavailable", ERROR_503_FORM);
+
+// 多个范围的 206 响应，每一部分有自己的 Content-Type，一个范围的 206 使用文件的 Content-Type
+static const StatusTemplate _status_206_byteranges = {
+    206, "HTTP/1.1 206 Partial Content\r\nContent-Type: multipart/byteranges; boundary=" RANGE_BOUNDARY "\r\n",
+    sizeof("HTTP/1.1 206 Partial Content\r\nContent-Type: multipart/byteranges; boundary=" RANGE_BOUNDARY "\r\n") - 1,
+    "", 0
+};
+// 304 没有响应体，也没有 Content-Type
+static const StatusTemplate _status_304 = {
+    304, "HTTP/1.1 304 Not Modified\r\n", sizeof("HTTP/1.1 304 Not Modified\r\n") - 1, "", 0
+};
+static const StatusTemplate _status_416 = STATUS_TEMPLATE(416, "Range Not Satisfiable", ERROR_416_FORM);
+
+#undef STATUS_TEMPLATE
+
+// 状态码对应的片段，200 的内容是空文件时返回的页面，非空文件的响应按文件类型生成状态行
+const StatusTemplate *HttpStatus::get(int code) {
+    switch (code) {
+        case 200: return &_status_200;
+        case 201: return &_status_201;
+        case 304: return &_status_304;
+        case 400: return &_status_400;
+        case 403: return &_status_403;
+        case 404: return &_status_404;
+        case 405: return &_status_405;
+        case 413: return &_status_413;
+        case 416: return &_status_416;
+        case 501: return &_status_501;
+        case 503: return &_status_503;
+        default:  return &_status_500;
+    }
+}
+
+// 多个范围的 206 响应
+const StatusTemplate *HttpStatus::byteranges() {
+    return &_status_206_byteranges;
+}
+
+// 状态码的原因短语，处理函数可以使用任意状态码，不认识的返回 "Unknown"
+const char *HttpStatus::reason(int code) {
+    switch (code) {
+        case 200: return "Ok";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 307: return "Temporary Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 422: return "Unprocessable Entity";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+/* 每个线程缓存的 Date 头 */
+struct DateCache {
+    time_t  m_sec;          // 格式化时的秒数
+    int     m_len;
+    char    m_buf[64];
+};
+
+static thread_local DateCache _date_cache = {-1, 0, {0}};
+
+// 当前时间的 Date 头，秒数变化时才重新格式化
+const char *HttpDate::get(int *len) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+
+    DateCache &cache = _date_cache;
+    if (ts.tv_sec != cache.m_sec) {
+        memcpy(cache.m_buf, "Date: ", 6);
+        cache.m_len = 6 + format(ts.tv_sec, cache.m_buf + 6);
+        cache.m_buf[cache.m_len++] = '\r';
+        cache.m_buf[cache.m_len++] = '\n';
+        cache.m_sec = ts.tv_sec;
+    }
+
+    *len = cache.m_len;
+    return cache.m_buf;
+}
+
+// 把时间格式化为 http 日期，如 "Sun, 06 Nov 1994 08:49:37 GMT"
+int HttpDate::format(time_t t, char *buf) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return strftime(buf, DATE_LEN + 1, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+// 解析 http 日期，只接受 format 生成的 IMF-fixdate 格式
+bool HttpDate::parse(const char *data, int len, time_t *t) {
+    if (len != DATE_LEN)
+        return false;
+
+    char buf[DATE_LEN + 1];
+    memcpy(buf, data, len);
+    buf[len] = '\0';
+
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char *end = strptime(buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (end == nullptr || *end != '\0')
+        return false;
+
+    *t = timegm(&tm);
+    return *t != (time_t)-1;
+}
+
+// 00 到 99 的两位数字
+static const char _digits[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// 每次转换两位，从低位向高位写入临时缓冲区后复制
+int formatUint(char *buf, uint64_t value) {
+    char tmp[20];
+    char *pos = tmp + sizeof(tmp);
+
+    while (value >= 100) {
+        int index = (value % 100) * 2;
+        value /= 100;
+        *--pos = _digits[index + 1];
+        *--pos = _digits[index];
+    }
+    if (value >= 10) {
+        int index = value * 2;
+        *--pos = _digits[index + 1];
+        *--pos = _digits[index];
+    } else {
+        *--pos = '0' + value;
+    }
+
+    int len = tmp + sizeof(tmp) - pos;
+    memcpy(buf, pos, len);
+    return len;
+}
@@ -0,0 +1,332 @@
+#include "router.h"
+#include "response.h"
+
+#include <string.h>
+
+/* 查找过程中的状态，参数先记在这里，找到路由时才复制到结果中 */
+struct Router::Lookup {
+    int             m_method;
+    TokenSpan       m_names[ROUTE_MAX_PARAMS];
+    TokenSpan       m_values[ROUTE_MAX_PARAMS];
+    RouteParams     *m_params;          // 结果
+    const Route     *m_route;           // 完全匹配的路由
+    const Route     *m_prefix;          // 最长的前缀路由
+    const char      *m_prefix_pos;      // 前缀路由匹配的结束位置
+    int             m_exact_allow;      // 路径完全匹配但方法不支持时，路径支持的方法
+    int             m_prefix_allow;     // 前缀匹配但方法不支持时，前缀支持的方法
+
+    // 把当前的参数复制到结果中
+    void save(int depth) {
+        m_params->m_count = depth;
+        for (int i = 0; i < depth; ++i) {
+            m_params->m_names[i] = m_names[i];
+            m_params->m_values[i] = m_values[i];
+        }
+    }
+};
+
+// 按名字查找参数
+const TokenSpan *RouteParams::get(const char *name) const {
+    int len = strlen(name);
+    for (int i = 0; i < m_count; ++i) {
+        if (m_names[i].m_len == len && memcmp(m_names[i].m_data, name, len) == 0)
+            return &m_values[i];
+    }
+    return nullptr;
+}
+
+void RouteReply::append(const char *data, int len) {
+    if (m_overflow || m_len + len > m_size) {
+        m_overflow = true;
+        return ;
+    }
+    memcpy(m_buf + m_len, data, len);
+    m_len += len;
+}
+
+void RouteReply::append(const char *str) {
+    append(str, strlen(str));
+}
+
+void RouteReply::appendUint(uint64_t value) {
+    if (m_overflow || m_len + 20 > m_size) {
+        m_overflow = true;
+        return ;
+    }
+    m_len += formatUint(m_buf + m_len, value);
+}
+
+Router::Node::Node() : m_param(nullptr), m_exact_methods(0), m_prefix_methods(0) {
+    for (int i = 0; i < METHOD_COUNT; ++i)
+        m_exact[i] = m_prefix[i] = nullptr;
+}
+
+Router::Node::~Node() {
+    for (size_t i = 0; i < m_children.size(); ++i)
+        delete m_children[i];
+    delete m_param;
+}
+
+Router::Router() : m_root(new Node()), m_count(0) {
+
+}
+
+Router::~Router() {
+    clear();
+    delete m_root;
+}
+
+// 删除所有路由
+void Router::clear() {
+    delete m_root;
+    m_root = new Node();
+    for (size_t i = 0; i < m_routes.size(); ++i)
+        delete m_routes[i];
+    m_routes.clear();
+    m_count = 0;
+}
+
+// 插入一段静态文本，与已有的子节点有公共前缀时把子节点分裂成公共前缀和剩余部分
+Router::Node *Router::insertStatic(Node *node, const char *text, int len) {
+    while (len > 0) {
+        size_t idx = node->m_indices.find(text[0]);
+        if (idx == std::string::npos) {
+            Node *child = new Node();
+            child->m_path.assign(text, len);
+            node->m_indices.push_back(text[0]);
+            node->m_children.push_back(child);
+            return child;
+        }
+
+        Node *child = node->m_children[idx];
+        int common = 0;
+        int child_len = child->m_path.size();
+        while (common < len && common < child_len && child->m_path[common] == text[common])
+            ++common;
+
+        if (common < child_len) {
+            Node *mid = new Node();
+            mid->m_path = child->m_path.substr(0, common);
+            child->m_path.erase(0, common);
+            mid->m_indices.push_back(child->m_path[0]);
+            mid->m_children.push_back(child);
+            node->m_children[idx] = mid;
+            child = mid;
+        }
+
+        text += common;
+        len -= common;
+        node = child;
+    }
+    return node;
+}
+
+// 路由按段拆开：静态文本插入基数树，":name" 进入参数子节点，结尾的 "*" 把路由挂在当前节点的前缀表上
+// ':' 和 '*' 只在段的开头才有特殊含义
+bool Router::insert(const char *pattern, int methods, Route *route) {
+    if (pattern == nullptr || pattern[0] != '/' || (methods & ALL_METHODS) == 0)
+        return false;
+
+    Node *node = m_root;
+    const char *pos = pattern;
+    bool prefix = false;
+    while (*pos) {
+        bool segment_start = pos == pattern || pos[-1] == '/';
+        if (segment_start && *pos == ':') {
+            const char *name = pos + 1;
+            const char *name_end = name;
+            while (*name_end && *name_end != '/')
+                ++name_end;
+            if (name_end == name)
+                return false;
+
+            if (node->m_param == nullptr) {
+                node->m_param = new Node();
+                node->m_param->m_path.assign(name, name_end - name);
+            } else if (node->m_param->m_path.compare(0, std::string::npos, name, name_end - name) != 0) {
+                return false;
+            }
+            node = node->m_param;
+            pos = name_end;
+            continue;
+        }
+        if (segment_start && *pos == '*') {
+            if (pos[1] != '\0')
+                return false;
+            prefix = true;
+            break;
+        }
+
+        const char *run = pos + 1;
+        while (*run && !((*run == ':' || *run == '*') && run[-1] == '/'))
+            ++run;
+        node = insertStatic(node, pos, run - pos);
+        pos = run;
+    }
+
+    // 参数节点的个数不能超过 ROUTE_MAX_PARAMS
+    int params = 0;
+    for (const char *p = pattern; *p; ++p) {
+        if (*p == ':' && (p == pattern || p[-1] == '/'))
+            ++params;
+    }
+    if (params > ROUTE_MAX_PARAMS)
+        return false;
+
+    const Route **table = prefix ? node->m_prefix : node->m_exact;
+    int *mask = prefix ? &node->m_prefix_methods : &node->m_exact_methods;
+    if (*mask & methods)
+        return false;
+    for (int i = 0; i < METHOD_COUNT; ++i) {
+        if (methods & (1 << i))
+            table[i] = route;
+    }
+    *mask |= methods & ALL_METHODS;
+    return true;
+}
+
+bool Router::addHandler(int methods, const char *pattern, RouteHandler handler, void *arg) {
+    if (handler == nullptr)
+        return false;
+
+    Route *route = new Route();
+    route->m_pattern = pattern ? pattern : "";
+    route->m_handler = handler;
+    route->m_arg = arg;
+    route->m_upload = false;
+    if (!insert(pattern, methods, route)) {
+        delete route;
+        return false;
+    }
+    m_routes.push_back(route);
+    ++m_count;
+    return true;
+}
+
+// 目录注册为 "prefix/*" 的前缀路由，目录统一以 / 结尾，剩余路径直接接在后面
+bool Router::addDir(int methods, const char *prefix, const char *dir, bool upload) {
+    if (prefix == nullptr || dir == nullptr || dir[0] == '\0')
+        return false;
+
+    Route *route = new Route();
+    route->m_pattern = prefix;
+    if (route->m_pattern.empty() || route->m_pattern.back() != '/')
+        route->m_pattern.push_back('/');
+    route->m_pattern.push_back('*');
+    route->m_handler = nullptr;
+    route->m_arg = nullptr;
+    route->m_dir = dir;
+    if (route->m_dir.back() != '/')
+        route->m_dir.push_back('/');
+    route->m_upload = upload;
+
+    if (!insert(route->m_pattern.c_str(), methods, route)) {
+        delete route;
+        return false;
+    }
+    m_routes.push_back(route);
+    ++m_count;
+    return true;
+}
+
+// 只有 GET 会读取静态文件，与 HttpConn::GET 相同
+bool Router::addStatic(const char *prefix, const char *dir) {
+    return addDir(1 << 0, prefix, dir, false);
+}
+
+// 上传只接受 PUT 和 POST，与 HttpConn::PUT、HttpConn::POST 相同
+bool Router::addUpload(const char *prefix, const char *dir) {
+    return addDir(1 << 3 | 1 << 1, prefix, dir, true);
+}
+
+// 深度优先，静态子节点优先于参数子节点，只有静态分支没有完全匹配时才回到参数分支
+// 经过的每个带前缀路由的节点都记为候选，完全匹配失败时使用匹配最长的前缀
+bool Router::match(const Node *node, const char *pos, const char *end, Lookup *lookup, int depth) const {
+    int bit = 1 << lookup->m_method;
+    if (node->m_prefix_methods) {
+        if (node->m_prefix_methods & bit) {
+            if (lookup->m_prefix == nullptr || pos > lookup->m_prefix_pos) {
+                lookup->m_prefix = node->m_prefix[lookup->m_method];
+                lookup->m_prefix_pos = pos;
+                lookup->m_params->m_rest.m_data = pos;
+                lookup->m_params->m_rest.m_len = end - pos;
+                lookup->save(depth);
+            }
+        } else {
+            lookup->m_prefix_allow |= node->m_prefix_methods;
+        }
+    }
+
+    if (pos == end) {
+        if (node->m_exact_methods & bit) {
+            lookup->m_route = node->m_exact[lookup->m_method];
+            lookup->m_params->m_rest.m_data = end;
+            lookup->m_params->m_rest.m_len = 0;
+            lookup->save(depth);
+            return true;
+        }
+        lookup->m_exact_allow |= node->m_exact_methods;
+        return false;
+    }
+
+    const char *idx = (const char *)memchr(node->m_indices.data(), *pos, node->m_indices.size());
+    if (idx) {
+        const Node *child = node->m_children[idx - node->m_indices.data()];
+        size_t len = child->m_path.size();
+        if ((size_t)(end - pos) >= len && memcmp(pos, child->m_path.data(), len) == 0 && \
+            match(child, pos + len, end, lookup, depth))
+            return true;
+    }
+
+    if (node->m_param && *pos != '/' && depth < ROUTE_MAX_PARAMS) {
+        const char *seg_end = (const char *)memchr(pos, '/', end - pos);
+        if (seg_end == nullptr)
+            seg_end = end;
+        lookup->m_names[depth].m_data = node->m_param->m_path.data();
+        lookup->m_names[depth].m_len = node->m_param->m_path.size();
+        lookup->m_values[depth].m_data = pos;
+        lookup->m_values[depth].m_len = seg_end - pos;
+        if (match(node->m_param, seg_end, end, lookup, depth + 1))
+            return true;
+    }
+
+    return false;
+}
+
+// 查询串不参与匹配；路径完全匹配但方法不支持时回复 405，即使有更短的前缀路由
+Router::MATCH Router::find(int method, const char *path, int len, const Route **route, RouteParams *params, int *allow) const {
+    if (m_count == 0 || method < 0 || method >= METHOD_COUNT)
+        return MATCH_NONE;
+
+    const char *query = (const char *)memchr(path, '?', len);
+    const char *end = query ? query : path + len;
+
+    Lookup lookup;
+    lookup.m_method = method;
+    lookup.m_params = params;
+    lookup.m_route = nullptr;
+    lookup.m_prefix = nullptr;
+    lookup.m_prefix_pos = nullptr;
+    lookup.m_exact_allow = 0;
+    lookup.m_prefix_allow = 0;
+    params->m_count = 0;
+
+    if (match(m_root, path, end, &lookup, 0)) {
+        *route = lookup.m_route;
+        return MATCH_OK;
+    }
+    if (lookup.m_exact_allow) {
+        *allow = lookup.m_exact_allow;
+        return MATCH_METHOD;
+    }
+    if (lookup.m_prefix) {
+        // 前缀候选的参数已经在记录时保存
+        *route = lookup.m_prefix;
+        return MATCH_OK;
+    }
+    if (lookup.m_prefix_allow) {
+        *allow = lookup.m_prefix_allow;
+        return MATCH_METHOD;
+    }
+    return MATCH_NONE;
+}
@@ -0,0 +1,253 @@
+#include "stmtcache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* mysql 客户端错误码的范围(CR_MIN_ERROR 到 CR_MAX_ERROR)，出现时连接不能继续使用 */
+static const unsigned int CLIENT_ERROR_MIN = 2000;
+static const unsigned int CLIENT_ERROR_MAX = 2999;
+
+// 按 long long 读取的列类型
+static bool IsIntegerType(enum_field_types type) {
+    return type == MYSQL_TYPE_TINY || type == MYSQL_TYPE_SHORT || type == MYSQL_TYPE_LONG || \
+           type == MYSQL_TYPE_INT24 || type == MYSQL_TYPE_LONGLONG || type == MYSQL_TYPE_YEAR;
+}
+
+MysqlStmt::MysqlStmt(StmtCache *cache, MYSQL_STMT *stmt) : m_cache(cache), m_stmt(stmt), m_stored(false) {}
+
+MysqlStmt::~MysqlStmt() {
+    freeResult();
+    mysql_stmt_close(m_stmt);
+}
+
+bool MysqlStmt::fail() {
+    unsigned int error = mysql_stmt_errno(m_stmt);
+    if (error >= CLIENT_ERROR_MIN && error <= CLIENT_ERROR_MAX)
+        m_cache->m_broken = true;
+    return false;
+}
+
+bool MysqlStmt::prepare(const char *sql, unsigned long len) {
+    if (mysql_stmt_prepare(m_stmt, sql, len) != 0)
+        return fail();
+
+    // 参数默认为 NULL
+    int params = mysql_stmt_param_count(m_stmt);
+    m_params.assign(params, MYSQL_BIND());
+    m_param_ints.assign(params, 0);
+    m_param_lengths.assign(params, 0);
+    for (int i = 0; i < params; ++i)
+        bindNull(i);
+
+    // 没有结果集的语句
+    MYSQL_RES *meta = mysql_stmt_result_metadata(m_stmt);
+    if (meta == nullptr)
+        return mysql_stmt_errno(m_stmt) == 0 ? true : fail();
+
+    unsigned int num = mysql_num_fields(meta);
+    MYSQL_FIELD *fields = mysql_fetch_fields(meta);
+    m_columns.resize(num);
+    m_results.assign(num, MYSQL_BIND());
+    for (unsigned int i = 0; i < num; ++i) {
+        Column &col = m_columns[i];
+        MYSQL_BIND &bind = m_results[i];
+        col.m_int = 0;
+        col.m_length = 0;
+        col.m_is_null = 0;
+        col.m_error = 0;
+        col.m_integer = IsIntegerType(fields[i].type);
+        bind.length = &col.m_length;
+        bind.is_null = &col.m_is_null;
+        bind.error = &col.m_error;
+
+        if (col.m_integer) {
+            // 缓冲区只用来把整数格式化成字符串
+            col.m_buffer.resize(24);
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.buffer = &col.m_int;
+            bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+        } else {
+            unsigned long size = fields[i].length;
+            if (size == 0 || size > STMT_RESULT_BUFFER)
+                size = STMT_RESULT_BUFFER;
+            col.m_buffer.resize(size + 1);
+            bind.buffer_type = MYSQL_TYPE_STRING;
+            bind.buffer = col.m_buffer.data();
+            bind.buffer_length = size;
+        }
+    }
+    mysql_free_result(meta);
+
+    // 结果缓冲区只绑定一次，之后的执行复用，扩大时重新绑定
+    if (mysql_stmt_bind_result(m_stmt, m_results.data()) != 0)
+        return fail();
+    return true;
+}
+
+bool MysqlStmt::bindString(int index, const char *data, unsigned long len) {
+    if (index < 0 || index >= (int)m_params.size())
+        return false;
+
+    MYSQL_BIND &bind = m_params[index];
+    memset(&bind, 0, sizeof(bind));
+    m_param_lengths[index] = len;
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = (void *)data;
+    bind.buffer_length = len;
+    bind.length = &m_param_lengths[index];
+    return true;
+}
+
+bool MysqlStmt::bindInt(int index, long long value) {
+    if (index < 0 || index >= (int)m_params.size())
+        return false;
+
+    MYSQL_BIND &bind = m_params[index];
+    memset(&bind, 0, sizeof(bind));
+    m_param_ints[index] = value;
+    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+    bind.buffer = &m_param_ints[index];
+    return true;
+}
+
+bool MysqlStmt::bindNull(int index) {
+    if (index < 0 || index >= (int)m_params.size())
+        return false;
+
+    MYSQL_BIND &bind = m_params[index];
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_NULL;
+    return true;
+}
+
+// 参数绑定的是 MYSQL_BIND 的副本，指针和长度可能变了，每次执行前重新绑定
+bool MysqlStmt::execute() {
+    freeResult();
+    if (!m_params.empty() && mysql_stmt_bind_param(m_stmt, m_params.data()) != 0)
+        return fail();
+    if (mysql_stmt_execute(m_stmt) != 0)
+        return fail();
+    if (m_columns.empty())
+        return true;
+
+    if (mysql_stmt_store_result(m_stmt) != 0)
+        return fail();
+    m_stored = true;
+    return true;
+}
+
+// 字符串列放不下时按实际长度扩大缓冲区，重新读取这一列，之后的行直接读入扩大后的缓冲区
+bool MysqlStmt::fetch() {
+    if (!m_stored)
+        return false;
+
+    int ret = mysql_stmt_fetch(m_stmt);
+    if (ret == MYSQL_NO_DATA)
+        return false;
+    if (ret == 1)
+        return fail();
+    if (ret != MYSQL_DATA_TRUNCATED)
+        return true;
+
+    bool grown = false;
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        Column &col = m_columns[i];
+        if (col.m_integer || col.m_is_null || !col.m_error)
+            continue;
+
+        col.m_buffer.resize(col.m_length + 1);
+        m_results[i].buffer = col.m_buffer.data();
+        m_results[i].buffer_length = col.m_length;
+        if (mysql_stmt_fetch_column(m_stmt, &m_results[i], i, 0) != 0)
+            return fail();
+        grown = true;
+    }
+    if (grown && mysql_stmt_bind_result(m_stmt, m_results.data()) != 0)
+        return fail();
+    return true;
+}
+
+void MysqlStmt::freeResult() {
+    if (m_stored) {
+        mysql_stmt_free_result(m_stmt);
+        m_stored = false;
+    }
+}
+
+// NULL 返回 nullptr
+const char *MysqlStmt::getString(int col, unsigned long *len) {
+    Column &c = m_columns[col];
+    if (c.m_is_null) {
+        if (len)
+            *len = 0;
+        return nullptr;
+    }
+
+    unsigned long n;
+    if (c.m_integer) {
+        n = snprintf(c.m_buffer.data(), c.m_buffer.size(), m_results[col].is_unsigned ? "%llu" : "%lld", c.m_int);
+    } else {
+        n = c.m_length < c.m_buffer.size() - 1 ? c.m_length : c.m_buffer.size() - 1;
+        c.m_buffer[n] = '\0';
+    }
+    if (len)
+        *len = n;
+    return c.m_buffer.data();
+}
+
+long long MysqlStmt::getInt(int col) {
+    Column &c = m_columns[col];
+    if (c.m_is_null)
+        return 0;
+    if (c.m_integer)
+        return c.m_int;
+    return strtoll(getString(col), nullptr, 10);
+}
+
+
+StmtCache::StmtCache(MYSQL *sql) : m_sql(sql), m_thread_id(mysql_thread_id(sql)), m_broken(false), m_prepares(0) {}
+
+StmtCache::~StmtCache() {
+    clear();
+}
+
+MysqlStmt *StmtCache::prepare(const char *sql, unsigned long len) {
+    // 重新连接后服务器上已经没有这些语句
+    unsigned long thread_id = mysql_thread_id(m_sql);
+    if (thread_id != m_thread_id) {
+        clear();
+        m_thread_id = thread_id;
+    }
+
+    std::string key(sql, len);
+    std::unordered_map<std::string, MysqlStmt *>::iterator it = m_stmts.find(key);
+    if (it != m_stmts.end())
+        return it->second;
+
+    // 语句文本通常是固定的几条，超过上限说明在拼接 sql，全部关闭避免占满服务器的 max_prepared_stmt_count
+    if (m_stmts.size() >= STMT_CACHE_MAX)
+        clear();
+
+    MYSQL_STMT *handle = mysql_stmt_init(m_sql);
+    if (handle == nullptr) {
+        m_error = "mysql_stmt_init failed";
+        return nullptr;
+    }
+
+    MysqlStmt *stmt = new MysqlStmt(this, handle);
+    if (!stmt->prepare(sql, len)) {
+        m_error = stmt->error();
+        delete stmt;
+        return nullptr;
+    }
+    ++m_prepares;
+    m_stmts.emplace(std::move(key), stmt);
+    return stmt;
+}
+
+void StmtCache::clear() {
+    for (std::unordered_map<std::string, MysqlStmt *>::iterator it = m_stmts.begin(); it != m_stmts.end(); ++it)
+        delete it->second;
+    m_stmts.clear();
+}
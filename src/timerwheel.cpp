@@ -0,0 +1,165 @@
+#include "timerwheel.h"
+
+#include <limits.h>
+
+TimerWheel::TimerWheel(uint64_t now_ms, uint64_t tick_ms) {
+    m_tick_ms = tick_ms > 0 ? tick_ms : 1;
+    m_jiffies = now_ms / m_tick_ms;
+    m_count = 0;
+
+    for (int i = 0; i < TVR_SIZE; ++i)
+        listInit(m_tv1 + i);
+
+    for (int n = 0; n < TVN_NUM; ++n)
+        for (int i = 0; i < TVN_SIZE; ++i)
+            listInit(&m_tvn[n][i]);
+}
+
+void TimerWheel::listInit(TimerNode *head) {
+    head->m_prev = head;
+    head->m_next = head;
+}
+
+void TimerWheel::listAppend(TimerNode *head, TimerNode *node) {
+    node->m_prev = head->m_prev;
+    node->m_next = head;
+    head->m_prev->m_next = node;
+    head->m_prev = node;
+}
+
+void TimerWheel::listUnlink(TimerNode *node) {
+    node->m_prev->m_next = node->m_next;
+    node->m_next->m_prev = node->m_prev;
+    node->m_prev = nullptr;
+    node->m_next = nullptr;
+}
+
+// 按到期时间放入对应层的槽中
+void TimerWheel::internalAdd(TimerNode *node) {
+    uint64_t expires = node->m_expire;
+    int64_t idx = (int64_t)(expires - m_jiffies);
+    TimerNode *head = nullptr;
+
+    if (idx < 0) {
+        // 已经过期，放到下一个要处理的槽
+        head = m_tv1 + (m_jiffies & TVR_MASK);
+    } else if (idx < TVR_SIZE) {
+        head = m_tv1 + (expires & TVR_MASK);
+    } else if (idx < (1LL << (TVR_BITS + TVN_BITS))) {
+        head = &m_tvn[0][(expires >> TVR_BITS) & TVN_MASK];
+    } else if (idx < (1LL << (TVR_BITS + 2 * TVN_BITS))) {
+        head = &m_tvn[1][(expires >> (TVR_BITS + TVN_BITS)) & TVN_MASK];
+    } else {
+        // 超出最大范围的按最大范围处理，到期时重新计算
+        if (idx >= (1LL << (TVR_BITS + 3 * TVN_BITS))) {
+            expires = m_jiffies + (1LL << (TVR_BITS + 3 * TVN_BITS)) - 1;
+            node->m_expire = expires;
+        }
+        head = &m_tvn[2][(expires >> (TVR_BITS + 2 * TVN_BITS)) & TVN_MASK];
+    }
+
+    listAppend(head, node);
+}
+
+// 把第 n 层 index 槽中的定时器重新分配到下层
+int TimerWheel::cascade(int n, int index) {
+    TimerNode *head = &m_tvn[n][index];
+    TimerNode work;
+    listInit(&work);
+
+    // 整个链表搬到临时链表上，再逐个重新插入
+    if (head->m_next != head) {
+        work.m_next = head->m_next;
+        work.m_prev = head->m_prev;
+        work.m_next->m_prev = &work;
+        work.m_prev->m_next = &work;
+        listInit(head);
+    }
+
+    while (work.m_next != &work) {
+        TimerNode *node = work.m_next;
+        listUnlink(node);
+        internalAdd(node);
+    }
+
+    return index;
+}
+
+// 添加定时器，expire_ms 为到期的绝对时间(毫秒)
+void TimerWheel::add(TimerNode *node, uint64_t expire_ms) {
+    // 向上取整，定时器只会晚到不会早到
+    node->m_expire = (expire_ms + m_tick_ms - 1) / m_tick_ms;
+    internalAdd(node);
+    ++m_count;
+}
+
+// 删除定时器
+void TimerWheel::remove(TimerNode *node) {
+    if (!node->linked())
+        return ;
+
+    listUnlink(node);
+    --m_count;
+}
+
+// 修改到期时间
+void TimerWheel::modify(TimerNode *node, uint64_t expire_ms) {
+    remove(node);
+    add(node, expire_ms);
+}
+
+// 推进时间到 now_ms，依次调用已到期定时器的回调
+void TimerWheel::advance(uint64_t now_ms, TimerCallback callback, void *arg) {
+    uint64_t target = now_ms / m_tick_ms;
+
+    while (m_jiffies <= target) {
+        int index = m_jiffies & TVR_MASK;
+
+        // 第一层转完一圈，从上层迁移下一段时间的定时器
+        if (index == 0) {
+            int n = 0;
+            while (n < TVN_NUM && cascade(n, (m_jiffies >> (TVR_BITS + n * TVN_BITS)) & TVN_MASK) == 0)
+                ++n;
+        }
+
+        TimerNode work;
+        listInit(&work);
+        TimerNode *head = m_tv1 + index;
+        if (head->m_next != head) {
+            work.m_next = head->m_next;
+            work.m_prev = head->m_prev;
+            work.m_next->m_prev = &work;
+            work.m_prev->m_next = &work;
+            listInit(head);
+        }
+        ++m_jiffies;
+
+        while (work.m_next != &work) {
+            TimerNode *node = work.m_next;
+            listUnlink(node);
+            --m_count;
+            callback(node, arg);
+        }
+    }
+}
+
+// 距离下一个定时器到期的毫秒数，没有定时器时返回 -1
+int TimerWheel::nextTimeout(uint64_t now_ms) {
+    if (m_count == 0)
+        return -1;
+
+    // 在第一层中向后找第一个非空的槽，遇到需要 cascade 的边界时在边界醒来
+    uint64_t tick = m_jiffies;
+    for (int i = 0; i < TVR_SIZE; ++i, ++tick) {
+        int index = tick & TVR_MASK;
+        if (index == 0 || m_tv1[index].m_next != m_tv1 + index)
+            break;
+    }
+
+    uint64_t expire_ms = tick * m_tick_ms;
+    if (expire_ms <= now_ms)
+        return 0;
+
+    uint64_t timeout = expire_ms - now_ms;
+    return timeout > INT_MAX ? INT_MAX : (int)timeout;
+}
@@ -0,0 +1,171 @@
+#include "tokenizer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_X86
+#endif
+
+// 逐字节查找
+static const char *findScalar(const char *begin, const char *end, char a, char b) {
+    for (; begin < end; ++begin) {
+        if (*begin == a || *begin == b)
+            return begin;
+    }
+    return end;
+}
+
+#ifdef TOKENIZER_X86
+// SSE4.2，用 pcmpestri 一次比较 16 个字节是否属于字符集 {a, b}
+__attribute__((target("sse4.2")))
+static const char *findSse42(const char *begin, const char *end, char a, char b) {
+    const __m128i set = _mm_setr_epi8(a, b, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    for (; begin + 16 <= end; begin += 16) {
+        __m128i data = _mm_loadu_si128((const __m128i *)begin);
+        int index = _mm_cmpestri(set, 2, data, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16)
+            return begin + index;
+    }
+
+    // 不足 16 字节的尾部不越界读取
+    return findScalar(begin, end, a, b);
+}
+
+// AVX2，一次比较 32 个字节，两个比较结果合并后取第一个置位的字节
+__attribute__((target("avx2")))
+static const char *findAvx2(const char *begin, const char *end, char a, char b) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+
+    for (; begin + 32 <= end; begin += 32) {
+        __m256i data = _mm256_loadu_si256((const __m256i *)begin);
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(data, va), _mm256_cmpeq_epi8(data, vb));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+    }
+
+    if (begin + 16 <= end) {
+        __m128i data = _mm_loadu_si128((const __m128i *)begin);
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(data, _mm256_castsi256_si128(va)), \
+                                   _mm_cmpeq_epi8(data, _mm256_castsi256_si128(vb)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+        if (mask != 0)
+            return begin + __builtin_ctz(mask);
+        begin += 16;
+    }
+
+    return findScalar(begin, end, a, b);
+}
+#endif
+
+HttpTokenizer::FindFunc HttpTokenizer::m_find = findScalar;
+HttpTokenizer::IMPL HttpTokenizer::m_impl = HttpTokenizer::IMPL_SCALAR;
+
+// 程序启动时选择最快的实现
+static HttpTokenizer::IMPL _tokenizer_impl = HttpTokenizer::selectBest();
+
+// 选择实现，cpu 不支持时返回 false
+bool HttpTokenizer::select(IMPL impl) {
+    switch (impl) {
+        case IMPL_SCALAR:
+            m_find = findScalar;
+            break;
+#ifdef TOKENIZER_X86
+        case IMPL_SSE42:
+            if (!__builtin_cpu_supports("sse4.2"))
+                return false;
+            m_find = findSse42;
+            break;
+        case IMPL_AVX2:
+            if (!__builtin_cpu_supports("avx2"))
+                return false;
+            m_find = findAvx2;
+            break;
+#endif
+        default:
+            return false;
+    }
+
+    m_impl = impl;
+    return true;
+}
+
+// 按 cpu 支持的指令集选择最快的实现
+HttpTokenizer::IMPL HttpTokenizer::selectBest() {
+#ifdef TOKENIZER_X86
+    __builtin_cpu_init();
+#endif
+    if (!select(IMPL_AVX2) && !select(IMPL_SSE42))
+        select(IMPL_SCALAR);
+    return m_impl;
+}
+
+// 当前实现的名称
+const char *HttpTokenizer::implName() {
+    switch (m_impl) {
+        case IMPL_AVX2:  return "avx2";
+        case IMPL_SSE42: return "sse4.2";
+        default:         return "scalar";
+    }
+}
+
+// 跳过空格和制表符
+static inline const char *skipBlank(const char *begin, const char *end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+        ++begin;
+    return begin;
+}
+
+// 解析请求行 "METHOD SP URL SP VERSION"
+bool HttpTokenizer::parseRequestLine(const char *line, int len, TokenSpan *method, TokenSpan *url, TokenSpan *version) {
+    const char *end = line + len;
+
+    // 方法
+    const char *sp = m_find(line, end, ' ', '\t');
+    if (sp == line || sp == end)
+        return false;
+    method->m_data = line;
+    method->m_len = sp - line;
+
+    // url
+    const char *begin = skipBlank(sp, end);
+    sp = m_find(begin, end, ' ', '\t');
+    if (sp == begin || sp == end)
+        return false;
+    url->m_data = begin;
+    url->m_len = sp - begin;
+
+    // 版本号，允许末尾有空白
+    begin = skipBlank(sp, end);
+    const char *tail = end;
+    while (tail > begin && (tail[-1] == ' ' || tail[-1] == '\t'))
+        --tail;
+    if (tail == begin)
+        return false;
+    version->m_data = begin;
+    version->m_len = tail - begin;
+
+    return true;
+}
+
+// 解析请求头 "Name: value"
+bool HttpTokenizer::parseHeader(const char *line, int len, TokenSpan *name, TokenSpan *value) {
+    const char *end = line + len;
+
+    // 名字中不允许有空白，遇到空白和冒号都停下来
+    const char *colon = m_find(line, end, ':', ' ');
+    if (colon == line || colon == end || *colon != ':')
+        return false;
+    name->m_data = line;
+    name->m_len = colon - line;
+
+    const char *begin = skipBlank(colon + 1, end);
+    const char *tail = end;
+    while (tail > begin && (tail[-1] == ' ' || tail[-1] == '\t'))
+        --tail;
+    value->m_data = begin;
+    value->m_len = tail - begin;
+
+    return true;
+}
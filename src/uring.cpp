@@ -0,0 +1,851 @@
+#include "uring.h"
+#include "log.h"
+#include "debug.h"
+
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/utsname.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+static int uringSetup(unsigned entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int uringRegister(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+UringBackend::UringBackend(int close_log) {
+    m_ringfd = -1;
+    m_sq_khead = m_sq_ktail = nullptr;
+    m_sq_mask = m_sq_entries = m_sq_tail = 0;
+    m_sqes = nullptr;
+    m_cq_khead = m_cq_ktail = nullptr;
+    m_cq_mask = 0;
+    m_cqes = nullptr;
+    m_sq_ptr = MAP_FAILED;
+    m_sq_size = 0;
+    m_sqes_size = 0;
+
+    m_buf_ring = (io_uring_buf_ring *)MAP_FAILED;
+    m_buf_ring_size = 0;
+    m_bufs = nullptr;
+    m_buf_tail = 0;
+    m_buf_returned = false;
+    m_broken = false;
+
+    m_listenfd = -1;
+    m_wakeupfd = -1;
+    m_close_log = close_log;
+    m_accept_active = false;
+    m_accept_paused = false;
+    m_conns = new ConnState *[MAX_FD]();
+}
+
+UringBackend::~UringBackend() {
+    for (int fd = 0; fd < MAX_FD; ++fd) {
+        ConnState *st = m_conns[fd];
+        if (st == nullptr)
+            continue;
+        if (st->m_pipe[0] != -1) {
+            close(st->m_pipe[0]);
+            close(st->m_pipe[1]);
+        }
+        FileCache::release(st->m_file);
+        delete st;
+    }
+    delete [] m_conns;
+
+    // 关闭 io_uring 时内核取消所有未完成的操作，之后才能释放缓冲区
+    if (m_ringfd != -1) close(m_ringfd);
+
+    if (m_sq_ptr != MAP_FAILED) munmap(m_sq_ptr, m_sq_size);
+
+    if (m_sqes) munmap(m_sqes, m_sqes_size);
+
+    if (m_buf_ring != MAP_FAILED) munmap(m_buf_ring, m_buf_ring_size);
+
+    free(m_bufs);
+}
+
+// 多次触发的 recv 需要 6.0 以上的内核，带超时的等待需要 IORING_FEAT_EXT_ARG
+bool UringBackend::supported() {
+    struct utsname name;
+    if (uname(&name) < 0 || atoi(name.release) < 6)
+        return false;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = uringSetup(4, &params);
+    if (fd < 0)
+        return false;
+    close(fd);
+    return (params.features & IORING_FEAT_SINGLE_MMAP) && (params.features & IORING_FEAT_EXT_ARG);
+}
+
+// 创建 io_uring 并映射提交队列和完成队列，注册接收缓冲区环，提交监听套接字和 eventfd 的多次触发操作
+bool UringBackend::init(int listenfd, int wakeupfd) {
+    m_listenfd = listenfd;
+    m_wakeupfd = wakeupfd;
+
+    // 只有本线程提交，完成事件的处理推迟到 io_uring_enter 时进行，减少中断事件循环
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | \
+                   IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = URING_CQ_ENTRIES;
+    m_ringfd = uringSetup(URING_SQ_ENTRIES, &params);
+    if (m_ringfd < 0 && errno == EINVAL) {
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = URING_CQ_ENTRIES;
+        m_ringfd = uringSetup(URING_SQ_ENTRIES, &params);
+    }
+    if (m_ringfd < 0) {
+        LogError("io_uring_setup failed: %s", strerror(errno));
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        LogError("io_uring: kernel features 0x%x not supported.", params.features);
+        return false;
+    }
+
+    // 提交队列和完成队列共用一次映射
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_sq_size = sq_size > cq_size ? sq_size : cq_size;
+    m_sq_ptr = mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQ_RING);
+    if (m_sq_ptr == MAP_FAILED) {
+        LogError("io_uring: mmap ring failed: %s", strerror(errno));
+        return false;
+    }
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        LogError("io_uring: mmap sqes failed: %s", strerror(errno));
+        return false;
+    }
+    m_sqes = (io_uring_sqe *)sqes;
+
+    char *ptr = (char *)m_sq_ptr;
+    m_sq_khead = (unsigned *)(ptr + params.sq_off.head);
+    m_sq_ktail = (unsigned *)(ptr + params.sq_off.tail);
+    m_sq_mask = *(unsigned *)(ptr + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sq_tail = *m_sq_ktail;
+    // 提交项按顺序使用，间接数组固定为恒等映射
+    unsigned *array = (unsigned *)(ptr + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; ++i)
+        array[i] = i;
+
+    m_cq_khead = (unsigned *)(ptr + params.cq_off.head);
+    m_cq_ktail = (unsigned *)(ptr + params.cq_off.tail);
+    m_cq_mask = *(unsigned *)(ptr + params.cq_off.ring_mask);
+    m_cqes = (io_uring_cqe *)(ptr + params.cq_off.cqes);
+
+    // 缓冲区环，内核收到数据时从中取一个缓冲区
+    m_buf_ring_size = URING_RECV_BUF_COUNT * sizeof(io_uring_buf);
+    m_buf_ring = (io_uring_buf_ring *)mmap(nullptr, m_buf_ring_size, PROT_READ | PROT_WRITE, \
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m_buf_ring == MAP_FAILED) {
+        LogError("io_uring: mmap buffer ring failed: %s", strerror(errno));
+        return false;
+    }
+    if (posix_memalign((void **)&m_bufs, 4096, (size_t)URING_RECV_BUF_COUNT * URING_RECV_BUF_SIZE) != 0) {
+        m_bufs = nullptr;
+        LogError("io_uring: alloc receive buffers failed.");
+        return false;
+    }
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)m_buf_ring;
+    reg.ring_entries = URING_RECV_BUF_COUNT;
+    reg.bgid = 0;
+    if (uringRegister(m_ringfd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LogError("io_uring: register buffer ring failed: %s", strerror(errno));
+        return false;
+    }
+    for (int bid = 0; bid < URING_RECV_BUF_COUNT; ++bid)
+        recycle(bid);
+    m_buf_returned = false;
+
+    submitAccept();
+    submitWakeup();
+    return enter(0, 0) >= 0;
+}
+
+UringBackend::ConnState *UringBackend::state(int fd) {
+    ConnState *st = m_conns[fd];
+    if (st == nullptr) {
+        st = new ConnState;
+        memset(st, 0, sizeof(*st));
+        st->m_held_head = st->m_held_tail = -1;
+        st->m_pipe[0] = st->m_pipe[1] = -1;
+        m_conns[fd] = st;
+    }
+    return st;
+}
+
+// 取得一个提交项，剩余不足 reserve 个时先提交已有的，保证一条链在同一次提交中
+// 完成队列溢出时内核不接收新的提交项，把完成事件移出完成队列后重试，直到真的有空位
+io_uring_sqe *UringBackend::getSqe(unsigned reserve) {
+    while (!m_broken && m_sq_tail - __atomic_load_n(m_sq_khead, __ATOMIC_ACQUIRE) + reserve > m_sq_entries) {
+        if (enter(0, 0) < 0) {
+            m_broken = true;
+            break;
+        }
+        if (m_sq_tail - __atomic_load_n(m_sq_khead, __ATOMIC_ACQUIRE) + reserve > m_sq_entries)
+            drainCq();
+    }
+
+    // 环已经不可用，交出一个不会提交的提交项，下一次 wait 返回错误
+    if (m_broken) {
+        memset(&m_spare_sqe, 0, sizeof(m_spare_sqe));
+        return &m_spare_sqe;
+    }
+
+    io_uring_sqe *sqe = m_sqes + (m_sq_tail & m_sq_mask);
+    memset(sqe, 0, sizeof(*sqe));
+    ++m_sq_tail;
+    return sqe;
+}
+
+// 把完成队列中的事件复制出来留到 reap 处理，提交过程中不能处理完成事件
+void UringBackend::drainCq() {
+    unsigned head = *m_cq_khead;
+    unsigned tail = __atomic_load_n(m_cq_ktail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+        m_deferred.push_back(m_cqes[head & m_cq_mask]);
+    __atomic_store_n(m_cq_khead, head, __ATOMIC_RELEASE);
+}
+
+// 提交积累的提交项并等待至少 wait_nr 个完成事件，一轮事件循环只调用一次
+int UringBackend::enter(unsigned wait_nr, int timeout) {
+    unsigned submit = m_sq_tail - *m_sq_ktail;
+    __atomic_store_n(m_sq_ktail, m_sq_tail, __ATOMIC_RELEASE);
+
+    // 推迟处理的完成事件只在带 GETEVENTS 时处理，即使不等待也要带上
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    void *argp = nullptr;
+    size_t argsz = 0;
+    if (wait_nr > 0 && timeout >= 0) {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000LL;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = (uint64_t)&ts;
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof(arg);
+    }
+
+    while (true) {
+        int ret = uringEnter(m_ringfd, submit, wait_nr, flags, argp, argsz);
+        if (ret >= 0 || errno == ETIME || errno == EINTR)
+            return 0;
+        // 完成队列溢出，先收割再重试
+        if (errno == EBUSY || errno == EAGAIN) {
+            if (wait_nr == 0)
+                return 0;
+            wait_nr = 0;
+            continue;
+        }
+        LogError("io_uring_enter failed: %s", strerror(errno));
+        return -1;
+    }
+}
+
+// 处理完成队列中的所有事件，处理过程中可能提交新的操作并产生新的完成事件
+// 提交时移出的事件比还在完成队列中的早，先处理
+void UringBackend::reap() {
+    std::vector<io_uring_cqe> deferred;
+    while (true) {
+        if (!m_deferred.empty()) {
+            deferred.clear();
+            deferred.swap(m_deferred);
+            for (size_t i = 0; i < deferred.size(); ++i)
+                handleCqe(&deferred[i]);
+            continue;
+        }
+
+        unsigned head = *m_cq_khead;
+        unsigned tail = __atomic_load_n(m_cq_ktail, __ATOMIC_ACQUIRE);
+        if (head == tail)
+            break;
+
+        io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+        __atomic_store_n(m_cq_khead, head + 1, __ATOMIC_RELEASE);
+        handleCqe(&cqe);
+    }
+}
+
+void UringBackend::handleCqe(const io_uring_cqe *cqe) {
+    int op = cqe->user_data >> 56;
+    uint16_t gen = (cqe->user_data >> 32) & 0xffff;
+    int fd = (int)(uint32_t)cqe->user_data;
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (op == OP_ACCEPT) {
+        if (cqe->res >= 0)
+            pushEvent(BackendEvent::EVENT_ACCEPT, cqe->res);
+        else if (cqe->res != -EAGAIN && cqe->res != -EINTR && cqe->res != -ECANCELED)
+            LogError("io_uring: accept error: %s", strerror(-cqe->res));
+        if (!more) {
+            m_accept_active = false;
+            if (!m_accept_paused)
+                submitAccept();
+        }
+        return ;
+    }
+
+    if (op == OP_POLL) {
+        if (fd < (int)m_watch_active.size() && m_watch_active[fd] && m_watch_gen[fd] == gen) {
+            m_watch_active[fd] = 0;
+            pushEvent(BackendEvent::EVENT_POLL, fd);
+            m_pending.back().m_len = cqe->res < 0 ? POLLERR : cqe->res;
+        }
+        return ;
+    }
+
+    if (op == OP_CANCEL)
+        return ;
+
+    if (op == OP_WAKEUP) {
+        pushEvent(BackendEvent::EVENT_WAKEUP, m_wakeupfd);
+        if (!more)
+            submitWakeup();
+        return ;
+    }
+
+    ConnState *st = (fd >= 0 && fd < MAX_FD) ? m_conns[fd] : nullptr;
+    if (st == nullptr || st->m_gen != gen) {
+        // 不应该出现，只归还缓冲区
+        if (cqe->flags & IORING_CQE_F_BUFFER)
+            recycle(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        return ;
+    }
+
+    if (op == OP_RECV)
+        handleRecv(fd, st, cqe);
+    else
+        handleSend(fd, st, op, cqe->res);
+}
+
+// 收到的数据挂在连接的缓冲区列表上，连接等待读事件时放入就绪列表
+void UringBackend::handleRecv(int fd, ConnState *st, const io_uring_cqe *cqe) {
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+    if (!more)
+        st->m_recv_active = false;
+
+    if (cqe->res > 0) {
+        int bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        if (!st->m_open) {
+            recycle(bid);
+        } else {
+            m_held_next[bid] = -1;
+            m_held_off[bid] = 0;
+            m_held_len[bid] = cqe->res;
+            if (st->m_held_tail == -1)
+                st->m_held_head = bid;
+            else
+                m_held_next[st->m_held_tail] = bid;
+            st->m_held_tail = bid;
+            ++st->m_held_count;
+
+            if (st->m_want_read)
+                pushReady(fd, st);
+            // 连接持有的缓冲区达到上限时停止接收，多次触发被内核终止时重新提交
+            if (st->m_held_count >= URING_HELD_MAX)
+                pauseRecv(fd, st);
+            else if (!more)
+                submitRecv(fd, st);
+        }
+    } else if (st->m_open) {
+        if (cqe->res == -ECANCELED && st->m_recv_paused) {
+            // pauseRecv 取消的 recv，连接在取消完成之前已经用掉了缓冲区时立即重新提交
+            resumeRecv(fd, st);
+        } else if (cqe->res == -ENOBUFS && st->m_held_count >= URING_HELD_MAX) {
+            st->m_recv_paused = true;
+        } else if (cqe->res == -ENOBUFS) {
+            // 缓冲区都被占用，有缓冲区归还后重新提交
+            st->m_starved = true;
+            m_starved.push_back(fd);
+        } else if (cqe->res == 0) {
+            // 对端关闭写方向，已经收到的数据都交给连接之后才关闭，半关闭的客户端仍然能收到响应
+            st->m_eof = true;
+            if (st->m_held_head == -1 && st->m_want_read)
+                closeEvent(fd, st);
+        } else {
+            // 出错
+            closeEvent(fd, st);
+        }
+    }
+
+    if (st->m_closing && !st->m_recv_active && st->m_inflight == 0)
+        finishClose(fd, st);
+}
+
+// 发送链中每个操作完成时记录进度，整条链完成后从输出队列消费已发送的字节，
+// 队列还有数据时继续提交下一条链，发完时通知 reactor
+void UringBackend::handleSend(int fd, ConnState *st, int op, int res) {
+    --st->m_inflight;
+    if (res < 0) {
+        // 链中前一个操作没有完成时后面的操作被取消，不算错误
+        if (res != -ECANCELED)
+            st->m_send_error = true;
+    } else if (op == OP_SEND) {
+        st->m_sent += res;
+    } else if (op == OP_SPLICE_IN) {
+        if (res == 0)
+            st->m_send_error = true;    // 文件被截断
+        st->m_pipe_fill += res;
+    } else if (op == OP_SPLICE_OUT) {
+        st->m_pipe_fill -= res;
+        st->m_sent += res;
+    }
+
+    if (st->m_inflight > 0)
+        return ;
+
+    FileCache::release(st->m_file);
+    st->m_file = nullptr;
+
+    if (!st->m_open) {
+        if (st->m_closing && !st->m_recv_active)
+            finishClose(fd, st);
+        return ;
+    }
+
+    OutputQueue *queue = st->m_queue;
+    queue->consume(st->m_sent);
+    if (st->m_send_error || (st->m_sent == 0 && st->m_pipe_fill == 0)) {
+        if (st->m_send_error && res != -EPIPE && res != -ECONNRESET)
+            DebugPrint("io_uring: send to fd %d failed: %d\n", fd, res);
+        closeEvent(fd, st);
+        return ;
+    }
+
+    if (queue->empty()) {
+        st->m_queue = nullptr;
+        pushEvent(BackendEvent::EVENT_WRITE, fd);
+        return ;
+    }
+
+    // 大文件分成多条链发送，每条链完成时通知 reactor 刷新活动时间，正在下载的连接不会超时
+    if (submitSend(fd, st) <= 0)
+        closeEvent(fd, st);
+    else
+        pushEvent(BackendEvent::EVENT_PROGRESS, fd);
+}
+
+void UringBackend::submitAccept() {
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_listenfd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = userData(OP_ACCEPT, 0, m_listenfd);
+    m_accept_active = true;
+}
+
+// 暂停时取消内核中的 accept，取消之前已经 accept 的连接仍然交给 reactor；
+// 恢复时如果 accept 已经结束就重新提交
+void UringBackend::pauseAccept(bool pause) {
+    if (pause == m_accept_paused)
+        return ;
+
+    m_accept_paused = pause;
+    if (pause && m_accept_active) {
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = userData(OP_ACCEPT, 0, m_listenfd);
+        sqe->user_data = userData(OP_CANCEL, 0, m_listenfd);
+    } else if (!pause && !m_accept_active) {
+        submitAccept();
+    }
+}
+
+// 一次性的 poll，完成事件的 res 是就绪的事件
+void UringBackend::watch(int fd, int events) {
+    if (fd >= (int)m_watch_active.size()) {
+        m_watch_active.resize(fd + 1, 0);
+        m_watch_gen.resize(fd + 1, 0);
+    }
+    if (m_watch_active[fd])
+        unwatch(fd);
+
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->user_data = userData(OP_POLL, m_watch_gen[fd], fd);
+    m_watch_active[fd] = 1;
+}
+
+// 内核中的 poll 持有文件的引用，关闭描述符前取消，代数加一后取消前已经产生的完成事件也被忽略
+void UringBackend::unwatch(int fd) {
+    if (fd < 0 || fd >= (int)m_watch_active.size())
+        return ;
+
+    if (m_watch_active[fd]) {
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = userData(OP_POLL, m_watch_gen[fd], fd);
+        sqe->user_data = userData(OP_CANCEL, 0, fd);
+        m_watch_active[fd] = 0;
+    }
+    ++m_watch_gen[fd];
+}
+
+void UringBackend::submitWakeup() {
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_wakeupfd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = userData(OP_WAKEUP, 0, m_wakeupfd);
+}
+
+// 多次触发的 recv，每次收到数据时从缓冲区环取一个缓冲区
+void UringBackend::submitRecv(int fd, ConnState *st) {
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = userData(OP_RECV, st->m_gen, fd);
+    st->m_recv_active = true;
+}
+
+// 取消之前已经收到的数据照常挂在连接上，取消完成(-ECANCELED)时 m_recv_active 才变为 false
+void UringBackend::pauseRecv(int fd, ConnState *st) {
+    if (st->m_recv_paused)
+        return ;
+
+    st->m_recv_paused = true;
+    if (!st->m_recv_active)
+        return ;
+
+    io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData(OP_RECV, st->m_gen, fd);
+    sqe->user_data = userData(OP_CANCEL, 0, fd);
+}
+
+void UringBackend::resumeRecv(int fd, ConnState *st) {
+    if (!st->m_recv_paused || st->m_recv_active || !st->m_open || st->m_eof || \
+        st->m_held_count >= URING_HELD_MAX)
+        return ;
+
+    st->m_recv_paused = false;
+    submitRecv(fd, st);
+}
+
+// 一条链依次为：队首连续内存块的 sendmsg，随后一个文件区域的 splice 到管道和从管道 splice 到 socket
+// 上一条链在 splice 中途断开时，管道中剩下的数据单独用一条链先发出去
+int UringBackend::submitSend(int fd, ConnState *st) {
+    OutputQueue *queue = st->m_queue;
+    st->m_sent = 0;
+    st->m_send_error = false;
+
+    if (st->m_pipe_fill > 0) {
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->fd = fd;
+        sqe->off = (uint64_t)-1;
+        sqe->splice_off_in = (uint64_t)-1;
+        sqe->splice_fd_in = st->m_pipe[0];
+        sqe->len = st->m_pipe_fill;
+        sqe->splice_flags = SPLICE_F_MOVE;
+        sqe->user_data = userData(OP_SPLICE_OUT, st->m_gen, fd);
+        st->m_inflight = 1;
+        return 1;
+    }
+
+    int count = queue->count();
+    int iovcnt = 0;
+    while (iovcnt < count && queue->chunk(iovcnt)->m_data) {
+        const OutputChunk *chunk = queue->chunk(iovcnt);
+        st->m_iov[iovcnt].iov_base = (void *)chunk->m_data;
+        st->m_iov[iovcnt].iov_len = chunk->m_len;
+        ++iovcnt;
+    }
+    const OutputChunk *file = iovcnt < count ? queue->chunk(iovcnt) : nullptr;
+    if (iovcnt == 0 && file == nullptr)
+        return 0;
+
+    if (file && st->m_pipe[0] == -1) {
+        if (pipe2(st->m_pipe, O_CLOEXEC) < 0) {
+            LogError("io_uring: pipe failed: %s", strerror(errno));
+            st->m_pipe[0] = st->m_pipe[1] = -1;
+            return -1;
+        }
+        // 扩大管道减少链的条数，失败时使用默认大小
+        fcntl(st->m_pipe[1], F_SETPIPE_SZ, URING_PIPE_SIZE);
+        int size = fcntl(st->m_pipe[1], F_GETPIPE_SZ);
+        st->m_pipe_size = size > 0 ? size : 65536;
+    }
+
+    unsigned ops = (iovcnt > 0 ? 1 : 0) + (file ? 2 : 0);
+    io_uring_sqe *sqe = getSqe(ops);
+    if (iovcnt > 0) {
+        memset(&st->m_msg, 0, sizeof(st->m_msg));
+        st->m_msg.msg_iov = st->m_iov;
+        st->m_msg.msg_iovlen = iovcnt;
+
+        // MSG_WAITALL 让内核在部分发送后继续发送，完成时已经全部写入 socket
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)&st->m_msg;
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        sqe->flags = file ? IOSQE_IO_LINK : 0;
+        sqe->user_data = userData(OP_SEND, st->m_gen, fd);
+        if (file)
+            sqe = getSqe();
+    }
+
+    if (file) {
+        size_t len = file->m_len < st->m_pipe_size ? file->m_len : st->m_pipe_size;
+
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->fd = st->m_pipe[1];
+        sqe->off = (uint64_t)-1;
+        sqe->splice_off_in = file->m_offset;
+        sqe->splice_fd_in = file->m_fd;
+        sqe->len = len;
+        sqe->splice_flags = SPLICE_F_MOVE;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = userData(OP_SPLICE_IN, st->m_gen, fd);
+
+        sqe = getSqe();
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->fd = fd;
+        sqe->off = (uint64_t)-1;
+        sqe->splice_off_in = (uint64_t)-1;
+        sqe->splice_fd_in = st->m_pipe[0];
+        sqe->len = len;
+        sqe->splice_flags = SPLICE_F_MOVE;
+        sqe->user_data = userData(OP_SPLICE_OUT, st->m_gen, fd);
+
+        // 链完成之前连接可能被关闭，输出队列归还的文件引用由这里多持有一个，保证文件描述符不被复用
+        st->m_file = FileCache::retain(file->m_file);
+    }
+
+    st->m_inflight = ops;
+    return 1;
+}
+
+// 把缓冲区还给缓冲区环
+void UringBackend::recycle(int bid) {
+    // 头文件中的柔性数组在 C++ 下偏移不为 0，直接按 io_uring_buf 数组访问，tail 与第一项的 resv 重叠
+    io_uring_buf *buf = (io_uring_buf *)m_buf_ring + (m_buf_tail & (URING_RECV_BUF_COUNT - 1));
+    buf->addr = (uint64_t)(m_bufs + (size_t)bid * URING_RECV_BUF_SIZE);
+    buf->len = URING_RECV_BUF_SIZE;
+    buf->bid = bid;
+    __atomic_store_n(&m_buf_ring->tail, ++m_buf_tail, __ATOMIC_RELEASE);
+    m_buf_returned = true;
+}
+
+void UringBackend::pushEvent(BackendEvent::TYPE type, int fd) {
+    BackendEvent event;
+    event.m_type = type;
+    event.m_fd = fd;
+    event.m_data = nullptr;
+    event.m_len = 0;
+    event.m_buf = -1;
+    m_pending.push_back(event);
+}
+
+void UringBackend::pushReady(int fd, ConnState *st) {
+    if (!st->m_ready) {
+        st->m_ready = true;
+        m_ready.push_back(fd);
+    }
+}
+
+// 每个连接只产生一次关闭事件
+void UringBackend::closeEvent(int fd, ConnState *st) {
+    if (!st->m_close_sent) {
+        st->m_close_sent = true;
+        pushEvent(BackendEvent::EVENT_CLOSE, fd);
+    }
+}
+
+// 内核中已经没有这个连接的操作，关闭描述符和管道，管道中残留的数据一起丢弃
+void UringBackend::finishClose(int fd, ConnState *st) {
+    close(fd);
+    if (st->m_pipe[0] != -1) {
+        close(st->m_pipe[0]);
+        close(st->m_pipe[1]);
+        st->m_pipe[0] = st->m_pipe[1] = -1;
+        st->m_pipe_fill = 0;
+    }
+    st->m_closing = false;
+    ++st->m_gen;
+}
+
+// 提交积累的操作并等待事件，已经有就绪的事件时不阻塞
+int UringBackend::wait(BackendEvent *events, int max, int timeout) {
+    if (m_broken)
+        return -1;
+    bool busy = !m_pending.empty() || !m_ready.empty() || !m_deferred.empty() || (m_buf_returned && !m_starved.empty());
+    if (enter(busy ? 0 : 1, busy ? 0 : timeout) < 0)
+        return -1;
+    reap();
+
+    // 有缓冲区归还时重新提交被饿死的 recv
+    if (m_buf_returned && !m_starved.empty()) {
+        std::vector<int> starved;
+        starved.swap(m_starved);
+        for (size_t i = 0; i < starved.size(); ++i) {
+            ConnState *st = m_conns[starved[i]];
+            if (st->m_open && st->m_starved && !st->m_recv_active) {
+                st->m_starved = false;
+                submitRecv(starved[i], st);
+            }
+        }
+    }
+    m_buf_returned = false;
+
+    // 等待读事件并且有数据的连接，每次交出第一个缓冲区
+    for (size_t i = 0; i < m_ready.size(); ++i) {
+        int fd = m_ready[i];
+        ConnState *st = m_conns[fd];
+        st->m_ready = false;
+        if (!st->m_open || st->m_close_sent || !st->m_want_read || st->m_held_head == -1)
+            continue;
+
+        int bid = st->m_held_head;
+        BackendEvent event;
+        event.m_type = BackendEvent::EVENT_READ;
+        event.m_fd = fd;
+        event.m_data = m_bufs + (size_t)bid * URING_RECV_BUF_SIZE + m_held_off[bid];
+        event.m_len = m_held_len[bid];
+        event.m_buf = bid;
+        m_pending.push_back(event);
+        st->m_want_read = false;
+    }
+    m_ready.clear();
+
+    int number = (int)m_pending.size() < max ? (int)m_pending.size() : max;
+    memcpy(events, m_pending.data(), number * sizeof(BackendEvent));
+    m_pending.erase(m_pending.begin(), m_pending.begin() + number);
+    return number;
+}
+
+void UringBackend::addConn(int fd) {
+    ConnState *st = state(fd);
+    st->m_open = true;
+    st->m_closing = false;
+    st->m_close_sent = false;
+    st->m_starved = false;
+    st->m_recv_paused = false;
+    st->m_want_read = true;
+    st->m_eof = false;
+    st->m_ready = false;
+    st->m_held_head = st->m_held_tail = -1;
+    st->m_held_count = 0;
+    st->m_queue = nullptr;
+    st->m_inflight = 0;
+    st->m_send_error = false;
+    st->m_sent = 0;
+    submitRecv(fd, st);
+}
+
+// 连接处理完已有的数据，还有没交出的缓冲区时立即产生读事件，已经收到 EOF 时产生关闭事件，
+// 因为持有的缓冲区过多而停止的 recv 在这里重新提交
+void UringBackend::armRead(int fd) {
+    ConnState *st = m_conns[fd];
+    if (st == nullptr || !st->m_open)
+        return ;
+
+    resumeRecv(fd, st);
+    st->m_want_read = true;
+    if (st->m_held_head != -1)
+        pushReady(fd, st);
+    else if (st->m_eof)
+        closeEvent(fd, st);
+}
+
+// 连接用完的缓冲区还给缓冲区环，没用完的部分留在队首
+void UringBackend::release(const BackendEvent &event, int used) {
+    ConnState *st = m_conns[event.m_fd];
+    if (st == nullptr || !st->m_open || st->m_held_head != event.m_buf)
+        return ;
+
+    int bid = event.m_buf;
+    if (used < m_held_len[bid]) {
+        m_held_off[bid] += used;
+        m_held_len[bid] -= used;
+        return ;
+    }
+
+    st->m_held_head = m_held_next[bid];
+    if (st->m_held_head == -1)
+        st->m_held_tail = -1;
+    --st->m_held_count;
+    recycle(bid);
+}
+
+// 提交发送链，完成后产生 EVENT_WRITE，队列为空时直接返回 1
+int UringBackend::send(int fd, OutputQueue *queue) {
+    if (queue->empty())
+        return 1;
+
+    ConnState *st = m_conns[fd];
+    if (st->m_inflight > 0)
+        return 0;
+
+    st->m_queue = queue;
+    int ret = submitSend(fd, st);
+    if (ret <= 0) {
+        st->m_queue = nullptr;
+        return ret < 0 ? -1 : 1;
+    }
+    return 0;
+}
+
+// shutdown 让内核中的 recv 和发送尽快结束，都结束后才关闭描述符
+void UringBackend::removeConn(int fd) {
+    ConnState *st = m_conns[fd];
+    if (st == nullptr || !st->m_open) {
+        close(fd);
+        return ;
+    }
+
+    st->m_open = false;
+    st->m_want_read = false;
+    st->m_queue = nullptr;
+    while (st->m_held_head != -1) {
+        int bid = st->m_held_head;
+        st->m_held_head = m_held_next[bid];
+        recycle(bid);
+    }
+    st->m_held_tail = -1;
+    st->m_held_count = 0;
+
+    if (!st->m_recv_active && st->m_inflight == 0) {
+        finishClose(fd, st);
+        return ;
+    }
+
+    shutdown(fd, SHUT_RDWR);
+    st->m_closing = true;
+}
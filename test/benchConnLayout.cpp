@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "http.h"
+#include "connslab.h"
+#include "timerwheel.h"
+
+/**
+ * 大量 keep-alive 连接时每个请求访问连接对象的开销
+ * 按 fd 随机选择连接，每个连接收到一个约 100 字节的 GET 请求，经过 dealRead 中的簿记、
+ * receive、解析、文件缓存查找、生成响应头和发送(空的事件后端直接丢弃输出队列)，不读写 socket，
+ * 连接数远大于缓存时，与少量连接的差值主要是访问连接对象各个缓存行的未命中
+ * 另外输出创建连接槽以后进程的常驻内存，只有用到的连接对象才占用物理内存
+ * 测试目录默认定义 DEBUG，计时前用 cmake -DT_DEBUG=OFF 关闭调试输出
+ * 用法: ./benchConnLayout [连接数] [请求数]
+ */
+
+bool m_close_log = true;
+
+/* 不做任何事情的事件后端 */
+class NullBackend : public EventBackend {
+public:
+    const char *name() const { return "null"; }
+    bool init(int, int) { return true; }
+    int wait(BackendEvent *, int, int) { return 0; }
+    void addConn(int) {}
+    void armRead(int) {}
+    void release(const BackendEvent &, int) {}
+    int send(int, OutputQueue *queue) { queue->clear(); return 1; }
+    void removeConn(int) {}
+    void pauseAccept(bool) {}
+    void watch(int, int) {}
+    void unwatch(int) {}
+};
+
+static double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 进程的常驻内存(MB)
+static double rssMB() {
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp == nullptr)
+        return 0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(fp);
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+static const char *_request = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n"
+                              "User-Agent: bench\r\nConnection: keep-alive\r\n\r\n";
+
+// 在 conn_num 个连接上处理 event_num 个请求，返回每个请求的纳秒数
+static double run(ConnSlab *slab, int conn_num, int event_num, char *root, TimerWheel *wheel, NullBackend *backend) {
+    int request_len = strlen(_request);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+
+    uint64_t now = 1000;
+    for (int fd = 0; fd < conn_num; ++fd) {
+        HttpConn *conn = slab->acquire(fd);
+        conn->init(fd, addr, backend, root, 0, 1);
+        conn->m_last_active = now;
+        conn->m_request_start = now;
+        wheel->add(&conn->m_timer, now + KEEPALIVE_TIMEOUT);
+    }
+
+    // 事件的 fd 序列提前生成，不计入耗时
+    int *fds = new int[event_num];
+    unsigned long x = 88172645463325252UL;
+    for (int i = 0; i < event_num; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        fds[i] = x % conn_num;
+    }
+
+    long skipped = 0;
+    double start = nowSec();
+    for (int i = 0; i < event_num; ++i) {
+        int fd = fds[i];
+        HttpConn *conn = slab->get(fd);
+        if (conn == nullptr || conn->getSockfd() != fd) {
+            ++skipped;
+            continue;
+        }
+
+        // 与 dealRead 的步骤相同
+        bool idle = conn->isIdle();
+        if (conn->receive(_request, request_len) != request_len) {
+            ++skipped;
+            continue;
+        }
+        conn->m_last_active = ++now;
+        if (idle)
+            conn->m_request_start = now;
+        wheel->modify(&conn->m_timer, conn->m_request_start + REQUEST_HEADER_TIMEOUT);
+        conn->m_busy.fetch_add(1, std::memory_order_relaxed);
+        conn->process();
+    }
+    double cost = nowSec() - start;
+
+    for (int fd = 0; fd < conn_num; ++fd)
+        wheel->remove(&slab->get(fd)->m_timer);
+    delete [] fds;
+
+    if (skipped)
+        printf("warning: %ld requests failed\n", skipped);
+    return cost * 1e9 / event_num;
+}
+
+int main(int argc, char *argv[]) {
+    int conn_num = argc > 1 ? atoi(argv[1]) : 100000;
+    int event_num = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    // 根目录下放一个小文件，所有请求都命中文件缓存
+    char root[] = "/tmp/benchConnLayoutXXXXXX";
+    if (mkdtemp(root) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string index = std::string(root) + "/index.html";
+    FILE *fp = fopen(index.c_str(), "w");
+    fputs("<html>hello</html>\n", fp);
+    fclose(fp);
+    FileCache::get()->init();
+
+    printf("sizeof(HttpConn): %zu\n", sizeof(HttpConn));
+
+    double rss = rssMB();
+    ConnSlab slab;
+    if (!slab.init(conn_num)) {
+        printf("create slab of %d connections failed\n", conn_num);
+        return 1;
+    }
+    printf("slab of %d connections: rss +%.1f MB\n", conn_num, rssMB() - rss);
+
+    NullBackend backend;
+    TimerWheel wheel(1000);
+
+    // 连接数较少时连接对象都在缓存中，作为对照，每种连接数重复几轮取最好的结果
+    int counts[2] = { conn_num < 1000 ? conn_num : 1000, conn_num };
+    double best[2] = { 0, 0 };
+    for (int i = 0; i < 2; ++i) {
+        for (int round = 0; round < 3; ++round) {
+            double ns = run(&slab, counts[i], event_num, root, &wheel, &backend);
+            if (round == 0 || ns < best[i])
+                best[i] = ns;
+        }
+        printf("%7d connections: %.1f ns/request\n", counts[i], best[i]);
+    }
+    printf("extra cost of cold connections: %.1f ns/request\n", best[1] - best[0]);
+    printf("all %d connections used: rss +%.1f MB\n", conn_num, rssMB() - rss);
+
+    unlink(index.c_str());
+    rmdir(root);
+    return 0;
+}
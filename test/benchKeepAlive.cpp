@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "http.h"
+
+/**
+ * 单核上 keep-alive 小请求的吞吐，防止请求之间的重置变慢
+ * 一个连接反复收到约 100 字节的 GET 请求，经过 receive、解析、文件缓存查找、生成响应头、
+ * 发送(空的事件后端直接丢弃输出队列)和请求之间的重置，不读写 socket
+ * 两种情况：每次读事件一个请求(缓冲区每次都处理完)，以及一次读到 16 个流水线请求，
+ * 读缓冲区放不下的不完整请求留到下一次读事件，需要压缩读缓冲区
+ * 测试目录默认定义 DEBUG，计时前用 cmake -DT_DEBUG=OFF 关闭调试输出
+ * 用法: ./benchKeepAlive [请求数]
+ */
+
+bool m_close_log = true;
+
+/* 不做任何事情的事件后端 */
+class NullBackend : public EventBackend {
+public:
+    const char *name() const { return "null"; }
+    bool init(int, int) { return true; }
+    int wait(BackendEvent *, int, int) { return 0; }
+    void addConn(int) {}
+    void armRead(int) {}
+    void release(const BackendEvent &, int) {}
+    int send(int, OutputQueue *queue) { queue->clear(); return 1; }
+    void removeConn(int) {}
+    void pauseAccept(bool) {}
+    void watch(int, int) {}
+    void unwatch(int) {}
+};
+
+static double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 约 100 字节
+static const char *_request = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n"
+                              "User-Agent: bench\r\nConnection: keep-alive\r\n\r\n";
+
+// 每次读事件收到 batch 个请求，共处理 total 个，返回每秒的请求数
+static double run(HttpConn *conn, int batch, int total) {
+    int request_len = strlen(_request);
+    char *data = new char[request_len * batch];
+    for (int i = 0; i < batch; ++i)
+        memcpy(data + i * request_len, _request, request_len);
+
+    double start = nowSec();
+    for (int done = 0; done < total; done += batch) {
+        // 与 dealRead 相同，放不下的部分在处理完已有的请求后再交给连接
+        int len = request_len * batch;
+        const char *pos = data;
+        while (len > 0) {
+            int used = conn->receive(pos, len);
+            if (used < 0) {
+                printf("receive failed\n");
+                exit(1);
+            }
+            pos += used;
+            len -= used;
+            conn->m_busy.fetch_add(1, std::memory_order_relaxed);
+            conn->process();
+        }
+    }
+    double cost = nowSec() - start;
+
+    delete [] data;
+    return total / cost;
+}
+
+int main(int argc, char *argv[]) {
+    int total = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    // 根目录下放一个小文件，所有请求都命中文件缓存
+    char root[] = "/tmp/benchKeepAliveXXXXXX";
+    if (mkdtemp(root) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string index = std::string(root) + "/index.html";
+    FILE *fp = fopen(index.c_str(), "w");
+    fputs("<html>hello</html>\n", fp);
+    fclose(fp);
+    FileCache::get()->init();
+
+    NullBackend backend;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    HttpConn *conn = new HttpConn();
+    conn->init(0, addr, &backend, root, 0, 1);
+
+    // 每种情况重复几轮取最好的结果
+    int batches[2] = {1, 16};
+    for (int i = 0; i < 2; ++i) {
+        double best = 0;
+        for (int round = 0; round < 3; ++round) {
+            double rps = run(conn, batches[i], total);
+            if (rps > best)
+                best = rps;
+        }
+        printf("%2d request(s) per read: %.0f requests/sec, %.1f ns/request\n", batches[i], best, 1e9 / best);
+    }
+
+    delete conn;
+    unlink(index.c_str());
+    rmdir(root);
+    return 0;
+}
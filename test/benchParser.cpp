@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "tokenizer.h"
+
+/**
+ * 对比原来逐字节查找行尾、strpbrk/strspn 解析请求行的方式和 HttpTokenizer 的各个实现
+ * 每次把请求复制到缓冲区后整个解析一遍，和服务器中每个请求的处理过程相同
+ */
+
+static const char *_small_request =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:9006\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char *_browser_request =
+    "GET /static/js/app.bundle.min.js?v=20240101 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef; theme=dark; lang=zh-CN; tracking=abcdefghijklmnopqrstuvwxyz\r\n"
+    "Referer: https://www.example.com/index.html\r\n"
+    "\r\n";
+
+/* 原来的解析方式 */
+struct LegacyParser {
+    char    *m_buf;
+    int     m_read_idx;
+    int     m_checked_idx;
+    int     m_start_line;
+    char    m_url[512];
+    char    m_version[512];
+    char    m_host[512];
+    bool    m_linger;
+    long    m_content_length;
+
+    int parseLine() {
+        for (; m_checked_idx < m_read_idx; ++m_checked_idx) {
+            char tmp = m_buf[m_checked_idx];
+            if (tmp == '\r') {
+                if ((m_checked_idx + 1) == m_read_idx)
+                    return 2;
+                if (m_buf[m_checked_idx + 1] == '\n') {
+                    m_buf[m_checked_idx++] = '\0';
+                    m_buf[m_checked_idx++] = '\0';
+                    return 0;
+                }
+                return 1;
+            } else if (tmp == '\n') {
+                return 1;
+            }
+        }
+        return 2;
+    }
+
+    bool parseRequestLine(char *text) {
+        char *url = strpbrk(text, " \t");
+        if (url == nullptr)
+            return false;
+        *url++ = '\0';
+        if (strcasecmp(text, "GET") != 0 && strcasecmp(text, "POST") != 0)
+            return false;
+        url += strspn(url, " \t");
+        char *version = strpbrk(url, " \t");
+        if (version == nullptr)
+            return false;
+        *version++ = '\0';
+        version += strspn(version, " \t");
+        if (strcasecmp(version, "HTTP/1.1") != 0)
+            return false;
+        strcpy(m_version, version);
+        strcpy(m_url, url);
+        return true;
+    }
+
+    void parseHeader(char *text) {
+        if (strncasecmp(text, "Connection:", 11) == 0) {
+            text += 11;
+            text += strspn(text, " \t");
+            m_linger = strcasecmp(text, "keep-alive") == 0;
+        } else if (strncasecmp(text, "Content-length:", 15) == 0) {
+            text += 15;
+            text += strspn(text, " \t");
+            m_content_length = atol(text);
+        } else if (strncasecmp(text, "Host:", 5) == 0) {
+            text += 5;
+            text += strspn(text, " \t");
+            strcpy(m_host, text);
+        }
+    }
+
+    bool parse(char *buf, int len) {
+        m_buf = buf;
+        m_read_idx = len;
+        m_checked_idx = m_start_line = 0;
+        bool first = true;
+        while (parseLine() == 0) {
+            char *text = m_buf + m_start_line;
+            m_start_line = m_checked_idx;
+            if (first) {
+                if (!parseRequestLine(text))
+                    return false;
+                first = false;
+            } else if (text[0] == '\0') {
+                return true;
+            } else {
+                parseHeader(text);
+            }
+        }
+        return false;
+    }
+};
+
+/* 使用 HttpTokenizer 的解析方式，与 HttpConn 中的流程相同 */
+struct TokenParser {
+    char    m_url[512];
+    char    m_version[16];
+    char    m_host[512];
+    bool    m_linger;
+    long    m_content_length;
+
+    bool parse(char *buf, int len) {
+        const char *end = buf + len;
+        const char *line = buf;
+        bool first = true;
+
+        while (line < end) {
+            const char *pos = HttpTokenizer::findLineEnd(line, end);
+            if (pos + 1 >= end || pos[0] != '\r' || pos[1] != '\n')
+                return false;
+            int line_len = pos - line;
+
+            if (first) {
+                TokenSpan method, url, version;
+                if (!HttpTokenizer::parseRequestLine(line, line_len, &method, &url, &version))
+                    return false;
+                if (!(method.m_len == 3 && strncasecmp(method.m_data, "GET", 3) == 0) && \
+                    !(method.m_len == 4 && strncasecmp(method.m_data, "POST", 4) == 0))
+                    return false;
+                if (version.m_len != 8 || strncasecmp(version.m_data, "HTTP/1.1", 8) != 0)
+                    return false;
+                memcpy(m_version, version.m_data, 8);
+                m_version[8] = '\0';
+                memcpy(m_url, url.m_data, url.m_len);
+                m_url[url.m_len] = '\0';
+                first = false;
+            } else if (line_len == 0) {
+                return true;
+            } else {
+                TokenSpan name, value;
+                if (HttpTokenizer::parseHeader(line, line_len, &name, &value)) {
+                    if (name.m_len == 10 && strncasecmp(name.m_data, "Connection", 10) == 0) {
+                        m_linger = value.m_len == 10 && strncasecmp(value.m_data, "keep-alive", 10) == 0;
+                    } else if (name.m_len == 14 && strncasecmp(name.m_data, "Content-length", 14) == 0) {
+                        m_content_length = atol(value.m_data);
+                    } else if (name.m_len == 4 && strncasecmp(name.m_data, "Host", 4) == 0) {
+                        memcpy(m_host, value.m_data, value.m_len);
+                        m_host[value.m_len] = '\0';
+                    }
+                }
+            }
+            line = pos + 2;
+        }
+        return false;
+    }
+};
+
+static double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+template<typename Parser>
+static void bench(const char *name, const char *request, int rounds) {
+    static char buf[4096];
+    static Parser parser;
+    int len = strlen(request);
+    int ok = 0;
+
+    double start = nowSec();
+    for (int i = 0; i < rounds; ++i) {
+        memcpy(buf, request, len);
+        ok += parser.parse(buf, len);
+    }
+    double cost = nowSec() - start;
+
+    printf("  %-16s %8.1f ns/request %8.2f GB/s  (%d ok)\n", name, cost * 1e9 / rounds, \
+           (double)len * rounds / cost / 1e9, ok);
+}
+
+static void benchAll(const char *title, const char *request, int rounds) {
+    printf("%s (%lu bytes):\n", title, strlen(request));
+    bench<LegacyParser>("legacy", request, rounds);
+
+    HttpTokenizer::IMPL impls[] = {HttpTokenizer::IMPL_SCALAR, HttpTokenizer::IMPL_SSE42, HttpTokenizer::IMPL_AVX2};
+    for (int i = 0; i < 3; ++i) {
+        if (!HttpTokenizer::select(impls[i]))
+            continue;
+        char name[32];
+        snprintf(name, sizeof(name), "tokenizer-%s", HttpTokenizer::implName());
+        bench<TokenParser>(name, request, rounds);
+    }
+    HttpTokenizer::selectBest();
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    printf("best tokenizer: %s\n", HttpTokenizer::implName());
+    benchAll("small request", _small_request, rounds);
+    benchAll("browser request", _browser_request, rounds);
+
+    return 0;
+}
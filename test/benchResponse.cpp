@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "response.h"
+
+/**
+ * 对比原来用 vsnprintf 逐个拼装响应头的方式和用预生成片段拼装的方式
+ * 每次生成一个 200 文件响应头和一个 404 错误响应，与 HttpConn::processWrite 的过程相同
+ */
+
+/* 原来的拼装方式 */
+struct LegacyWriter {
+    char    m_buf[2048];
+    int     m_idx;
+
+    bool addResponse(const char *format, ...) {
+        va_list arg_list;
+        va_start(arg_list, format);
+        int len = vsnprintf(m_buf + m_idx, sizeof(m_buf) - 1 - m_idx, format, arg_list);
+        va_end(arg_list);
+        if (len >= (int)sizeof(m_buf) - 1 - m_idx)
+            return false;
+        m_idx += len;
+        return true;
+    }
+
+    bool addHeaders(int content_length, bool linger) {
+        return addResponse("Content-Length: %d\r\n", content_length) && \
+               addResponse("Content-Type: %s\r\n", "text/html") && \
+               addResponse("Connection: %s\r\n", linger ? "keep-alive" : "close") && \
+               addResponse("%s", "\r\n");
+    }
+
+    int build(int file_size, bool error) {
+        m_idx = 0;
+        if (error) {
+            const char *form = "The requested file was not found on this server.\n";
+            addResponse("%s %d %s\r\n", "HTTP/1.1", 404, "Not Found");
+            addHeaders(strlen(form), true);
+            addResponse("%s", form);
+        } else {
+            addResponse("%s %d %s\r\n", "HTTP/1.1", 200, "Ok");
+            addHeaders(file_size, true);
+        }
+        return m_idx;
+    }
+};
+
+/* 预生成片段的拼装方式 */
+struct TemplateWriter {
+    char    m_buf[2048];
+
+    int build(int file_size, bool error) {
+        ResponseWriter writer(m_buf, sizeof(m_buf));
+        const StatusTemplate *status = HttpStatus::get(error ? 404 : 200);
+        writer.statusLine(status);
+        writer.contentLength(error ? status->m_body_len : file_size);
+        writer.connection(true);
+        writer.end();
+        if (error)
+            writer.append(status->m_body, status->m_body_len);
+        return writer.length();
+    }
+};
+
+static double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+template<typename Writer>
+static void bench(const char *name, bool error, int rounds) {
+    static Writer writer;
+    long bytes = 0;
+
+    double start = nowSec();
+    for (int i = 0; i < rounds; ++i)
+        bytes += writer.build(1000 + (i & 0xffff), error);
+    double cost = nowSec() - start;
+
+    printf("  %-10s %8.1f ns/response  (%ld bytes)\n", name, cost * 1e9 / rounds, bytes);
+}
+
+// 检查整数转换和生成的响应头
+static int check() {
+    int error = 0;
+    uint64_t values[] = {0, 7, 10, 99, 100, 12345, 4294967296ULL, 18446744073709551615ULL};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        char expect[32], buf[32];
+        int len = snprintf(expect, sizeof(expect), "%lu", (unsigned long)values[i]);
+        if (formatUint(buf, values[i]) != len || memcmp(buf, expect, len) != 0) {
+            printf("formatUint failed: %s\n", expect);
+            ++error;
+        }
+    }
+
+    static TemplateWriter writer;
+    int len = writer.build(0, true);
+    printf("%.*s\n", len, writer.m_buf);
+    if (strncmp(writer.m_buf, "HTTP/1.1 404 Not Found\r\n", 24) != 0 || strstr(writer.m_buf, "Content-Length: 49\r\n") == nullptr)
+        ++error;
+
+    // 空间不够时不越界
+    char small[64];
+    ResponseWriter overflow(small, sizeof(small));
+    overflow.statusLine(HttpStatus::get(200));
+    overflow.contentLength(123456);
+    if (!overflow.overflow() || overflow.length() > (int)sizeof(small))
+        ++error;
+
+    return error;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    int error = check();
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+
+    printf("200 file response header:\n");
+    bench<LegacyWriter>("legacy", false, rounds);
+    bench<TemplateWriter>("template", false, rounds);
+    printf("404 error response:\n");
+    bench<LegacyWriter>("legacy", true, rounds);
+    bench<TemplateWriter>("template", true, rounds);
+
+    return error == 0 ? 0 : 1;
+}
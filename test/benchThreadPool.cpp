@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <atomic>
+
+#include "macro.h"
+#include "block.h"
+#include "threadpool.h"
+
+/**
+ * 工作窃取线程池与基于 BlockQueue 的线程池的吞吐对比
+ * 多个生产者线程模拟 reactor 投递任务，统计全部任务处理完毕的耗时
+ * 用法: ./benchThreadPool [任务总数] [生产者数]
+ */
+
+static std::atomic<long> _done(0);
+
+/* 模拟一次很短的 HttpConn::process */
+struct Task {
+    unsigned long m_seed;
+
+    void process() {
+        unsigned long x = m_seed;
+        for (int i = 0; i < 200; ++i)
+            x = x * 6364136223846793005UL + 1442695040888963407UL;
+        m_seed = x;
+        _done.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/* 对照组: 所有工作线程共享一个 BlockQueue */
+class BlockQueuePool {
+private:
+    BlockQueue<Task *>  m_queue;
+    pthread_t           *m_tids;
+    int                 m_thread_number;
+
+    static void *worker(void *arg) {
+        BlockQueuePool *pool = (BlockQueuePool *)arg;
+        Task *task = nullptr;
+        while (pool->m_queue.pop(task)) {
+            if (task == nullptr)    // 空任务表示退出
+                break;
+            task->process();
+        }
+        return (void *)nullptr;
+    }
+
+public:
+    BlockQueuePool(int thread_number, int max_requests) : m_queue(max_requests) {
+        m_thread_number = thread_number;
+        m_tids = new pthread_t[m_thread_number];
+        for (int i = 0; i < m_thread_number; ++i)
+            pthread_create(m_tids + i, nullptr, worker, this);
+    }
+
+    ~BlockQueuePool() {
+        for (int i = 0; i < m_thread_number; ++i)
+            while (!m_queue.push(nullptr));
+        for (int i = 0; i < m_thread_number; ++i)
+            pthread_join(m_tids[i], nullptr);
+        delete [] m_tids;
+    }
+
+    bool append(Task *task) { return m_queue.push(task); }
+};
+
+struct Producer {
+    void    *m_pool;
+    bool    m_steal;
+    Task    *m_tasks;
+    long    m_count;
+};
+
+template<typename Pool>
+static void *produce(void *arg) {
+    Producer *p = (Producer *)arg;
+    Pool *pool = (Pool *)p->m_pool;
+    for (long i = 0; i < p->m_count; ++i) {
+        while (!pool->append(p->m_tasks + i));  // 队列满时重试
+    }
+    return (void *)nullptr;
+}
+
+static double now() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+template<typename Pool>
+static double run(Pool *pool, Task *tasks, long total, int producers) {
+    _done.store(0);
+    pthread_t *tids = new pthread_t[producers];
+    Producer *args = new Producer[producers];
+
+    double start = now();
+    long per = total / producers;
+    for (int i = 0; i < producers; ++i) {
+        args[i].m_pool = pool;
+        args[i].m_tasks = tasks + i * per;
+        args[i].m_count = per;
+        pthread_create(tids + i, nullptr, produce<Pool>, args + i);
+    }
+    for (int i = 0; i < producers; ++i)
+        pthread_join(tids[i], nullptr);
+    while (_done.load(std::memory_order_relaxed) < per * producers);
+    double cost = now() - start;
+
+    delete [] tids;
+    delete [] args;
+    return cost;
+}
+
+int main(int argc, char *argv[]) {
+    long total = argc > 1 ? atol(argv[1]) : 2000000;
+    int producers = argc > 2 ? atoi(argv[2]) : 4;
+
+    Task *tasks = new Task[total];
+    for (long i = 0; i < total; ++i)
+        tasks[i].m_seed = i;
+
+    printf("tasks: %ld, producers: %d\n", total, producers);
+    printf("%8s %20s %20s\n", "workers", "BlockQueue(Mops/s)", "WorkSteal(Mops/s)");
+
+    int workers[] = {1, 2, 4, 8, 16, 32};
+    for (size_t i = 0; i < sizeof(workers) / sizeof(workers[0]); ++i) {
+        double block_cost, steal_cost;
+        {
+            BlockQueuePool pool(workers[i], 10000);
+            block_cost = run(&pool, tasks, total, producers);
+        }
+        {
+            ThreadPool<Task> pool(workers[i], 10000);
+            steal_cost = run(&pool, tasks, total, producers);
+        }
+        printf("%8d %20.2f %20.2f\n", workers[i], total / block_cost / 1e6, total / steal_cost / 1e6);
+    }
+
+    delete [] tasks;
+    return 0;
+}
@@ -0,0 +1,36 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/asyncdb.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/asyncdb.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/asyncdb.cpp.o.d"
+  "/root/repo/src/backend.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/backend.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/backend.cpp.o.d"
+  "/root/repo/src/body.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/body.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/body.cpp.o.d"
+  "/root/repo/src/buffer.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/buffer.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/buffer.cpp.o.d"
+  "/root/repo/src/common.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/common.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/common.cpp.o.d"
+  "/root/repo/src/connslab.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/connslab.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/connslab.cpp.o.d"
+  "/root/repo/src/filecache.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/filecache.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/filecache.cpp.o.d"
+  "/root/repo/src/http.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/http.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/http.cpp.o.d"
+  "/root/repo/src/log.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/log.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/log.cpp.o.d"
+  "/root/repo/src/mysqlpool.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/mysqlpool.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/mysqlpool.cpp.o.d"
+  "/root/repo/src/outqueue.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/outqueue.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/outqueue.cpp.o.d"
+  "/root/repo/src/range.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/range.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/range.cpp.o.d"
+  "/root/repo/src/response.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/response.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/response.cpp.o.d"
+  "/root/repo/src/router.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/router.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/router.cpp.o.d"
+  "/root/repo/src/stmtcache.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/stmtcache.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/stmtcache.cpp.o.d"
+  "/root/repo/src/timerwheel.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/timerwheel.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/timerwheel.cpp.o.d"
+  "/root/repo/src/tokenizer.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/tokenizer.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/__/src/tokenizer.cpp.o.d"
+  "/root/repo/test/benchConnLayout.cpp" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/benchConnLayout.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/benchConnLayout.dir/benchConnLayout.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
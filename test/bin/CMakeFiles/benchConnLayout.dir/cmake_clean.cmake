@@ -0,0 +1,45 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchConnLayout.dir/__/src/asyncdb.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/asyncdb.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/backend.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/backend.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/body.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/common.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/connslab.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/connslab.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/http.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/http.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/log.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/range.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/response.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/router.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/benchConnLayout.dir/benchConnLayout.cpp.o"
+  "CMakeFiles/benchConnLayout.dir/benchConnLayout.cpp.o.d"
+  "benchConnLayout"
+  "benchConnLayout.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchConnLayout.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
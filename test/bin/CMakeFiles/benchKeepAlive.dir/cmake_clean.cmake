@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchKeepAlive.dir/__/src/asyncdb.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/asyncdb.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/backend.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/backend.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/body.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/common.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/http.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/http.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/log.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/range.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/response.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/router.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/benchKeepAlive.dir/benchKeepAlive.cpp.o"
+  "CMakeFiles/benchKeepAlive.dir/benchKeepAlive.cpp.o.d"
+  "benchKeepAlive"
+  "benchKeepAlive.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchKeepAlive.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
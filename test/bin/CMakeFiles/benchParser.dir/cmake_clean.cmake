@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchParser.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/benchParser.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/benchParser.dir/benchParser.cpp.o"
+  "CMakeFiles/benchParser.dir/benchParser.cpp.o.d"
+  "benchParser"
+  "benchParser.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchParser.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
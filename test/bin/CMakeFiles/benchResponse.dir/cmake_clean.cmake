@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchResponse.dir/__/src/response.cpp.o"
+  "CMakeFiles/benchResponse.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/benchResponse.dir/benchResponse.cpp.o"
+  "CMakeFiles/benchResponse.dir/benchResponse.cpp.o.d"
+  "benchResponse"
+  "benchResponse.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchResponse.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
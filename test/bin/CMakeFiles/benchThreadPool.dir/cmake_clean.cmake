@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchThreadPool.dir/benchThreadPool.cpp.o"
+  "CMakeFiles/benchThreadPool.dir/benchThreadPool.cpp.o.d"
+  "benchThreadPool"
+  "benchThreadPool.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchThreadPool.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
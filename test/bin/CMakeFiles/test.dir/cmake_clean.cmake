@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test.dir/__/src/common.cpp.o"
+  "CMakeFiles/test.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/test.dir/__/src/log.cpp.o"
+  "CMakeFiles/test.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/test.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/test.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/test.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/test.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/test.dir/test.cpp.o"
+  "CMakeFiles/test.dir/test.cpp.o.d"
+  "test"
+  "test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testAsyncDb.dir/__/src/asyncdb.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/asyncdb.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/backend.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/backend.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/body.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/common.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/http.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/http.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/log.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/range.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/response.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/router.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/testAsyncDb.dir/testAsyncDb.cpp.o"
+  "CMakeFiles/testAsyncDb.dir/testAsyncDb.cpp.o.d"
+  "testAsyncDb"
+  "testAsyncDb.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testAsyncDb.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testBody.dir/__/src/body.cpp.o"
+  "CMakeFiles/testBody.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/testBody.dir/__/src/common.cpp.o"
+  "CMakeFiles/testBody.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testBody.dir/__/src/log.cpp.o"
+  "CMakeFiles/testBody.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testBody.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testBody.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testBody.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testBody.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testBody.dir/testBody.cpp.o"
+  "CMakeFiles/testBody.dir/testBody.cpp.o.d"
+  "testBody"
+  "testBody.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testBody.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
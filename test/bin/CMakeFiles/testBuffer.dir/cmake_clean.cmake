@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testBuffer.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/testBuffer.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/testBuffer.dir/testBuffer.cpp.o"
+  "CMakeFiles/testBuffer.dir/testBuffer.cpp.o.d"
+  "testBuffer"
+  "testBuffer.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testBuffer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testComm.dir/__/src/common.cpp.o"
+  "CMakeFiles/testComm.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testComm.dir/__/src/log.cpp.o"
+  "CMakeFiles/testComm.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testComm.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testComm.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testComm.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testComm.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testComm.dir/testCommon.cpp.o"
+  "CMakeFiles/testComm.dir/testCommon.cpp.o.d"
+  "testComm"
+  "testComm.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testComm.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/common.cpp" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/common.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/common.cpp.o.d"
+  "/root/repo/src/credential.cpp" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/credential.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/credential.cpp.o.d"
+  "/root/repo/src/log.cpp" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/log.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/log.cpp.o.d"
+  "/root/repo/src/mysqlpool.cpp" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/mysqlpool.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/mysqlpool.cpp.o.d"
+  "/root/repo/src/stmtcache.cpp" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/stmtcache.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testCredential.dir/__/src/stmtcache.cpp.o.d"
+  "/root/repo/test/testCredential.cpp" "/root/repo/test/bin/CMakeFiles/testCredential.dir/testCredential.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testCredential.dir/testCredential.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testCredential.dir/__/src/common.cpp.o"
+  "CMakeFiles/testCredential.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testCredential.dir/__/src/credential.cpp.o"
+  "CMakeFiles/testCredential.dir/__/src/credential.cpp.o.d"
+  "CMakeFiles/testCredential.dir/__/src/log.cpp.o"
+  "CMakeFiles/testCredential.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testCredential.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testCredential.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testCredential.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testCredential.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testCredential.dir/testCredential.cpp.o"
+  "CMakeFiles/testCredential.dir/testCredential.cpp.o.d"
+  "testCredential"
+  "testCredential.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testCredential.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/common.cpp" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/common.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/common.cpp.o.d"
+  "/root/repo/src/log.cpp" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/log.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/log.cpp.o.d"
+  "/root/repo/src/mysqlpool.cpp" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/mysqlpool.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/mysqlpool.cpp.o.d"
+  "/root/repo/src/stmtcache.cpp" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/stmtcache.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testExp.dir/__/src/stmtcache.cpp.o.d"
+  "/root/repo/test/testExp.cpp" "/root/repo/test/bin/CMakeFiles/testExp.dir/testExp.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testExp.dir/testExp.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
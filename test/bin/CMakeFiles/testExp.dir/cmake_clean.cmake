@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testExp.dir/__/src/common.cpp.o"
+  "CMakeFiles/testExp.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testExp.dir/__/src/log.cpp.o"
+  "CMakeFiles/testExp.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testExp.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testExp.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testExp.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testExp.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testExp.dir/testExp.cpp.o"
+  "CMakeFiles/testExp.dir/testExp.cpp.o.d"
+  "testExp"
+  "testExp.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testExp.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testFileCache.dir/__/src/common.cpp.o"
+  "CMakeFiles/testFileCache.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testFileCache.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/testFileCache.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/testFileCache.dir/__/src/log.cpp.o"
+  "CMakeFiles/testFileCache.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testFileCache.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testFileCache.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testFileCache.dir/__/src/response.cpp.o"
+  "CMakeFiles/testFileCache.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testFileCache.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testFileCache.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testFileCache.dir/testFileCache.cpp.o"
+  "CMakeFiles/testFileCache.dir/testFileCache.cpp.o.d"
+  "testFileCache"
+  "testFileCache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testFileCache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testGovernor.dir/__/src/governor.cpp.o"
+  "CMakeFiles/testGovernor.dir/__/src/governor.cpp.o.d"
+  "CMakeFiles/testGovernor.dir/testGovernor.cpp.o"
+  "CMakeFiles/testGovernor.dir/testGovernor.cpp.o.d"
+  "testGovernor"
+  "testGovernor.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testGovernor.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
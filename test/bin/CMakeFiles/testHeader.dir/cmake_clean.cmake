@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testHeader.dir/testHeader.cpp.o"
+  "CMakeFiles/testHeader.dir/testHeader.cpp.o.d"
+  "testHeader"
+  "testHeader.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testHeader.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testHttp.dir/__/src/asyncdb.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/asyncdb.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/backend.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/backend.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/body.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/common.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/http.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/http.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/log.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/range.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/response.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/router.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/testHttp.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/testHttp.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/testHttp.dir/testHttp.cpp.o"
+  "CMakeFiles/testHttp.dir/testHttp.cpp.o.d"
+  "testHttp"
+  "testHttp.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testHttp.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testMysqlPool.dir/__/src/common.cpp.o"
+  "CMakeFiles/testMysqlPool.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testMysqlPool.dir/__/src/log.cpp.o"
+  "CMakeFiles/testMysqlPool.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testMysqlPool.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testMysqlPool.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testMysqlPool.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testMysqlPool.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testMysqlPool.dir/testMysqlPool.cpp.o"
+  "CMakeFiles/testMysqlPool.dir/testMysqlPool.cpp.o.d"
+  "testMysqlPool"
+  "testMysqlPool.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testMysqlPool.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testOutQueue.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/common.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/log.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/response.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testOutQueue.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testOutQueue.dir/testOutQueue.cpp.o"
+  "CMakeFiles/testOutQueue.dir/testOutQueue.cpp.o.d"
+  "testOutQueue"
+  "testOutQueue.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testOutQueue.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testRange.dir/__/src/range.cpp.o"
+  "CMakeFiles/testRange.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/testRange.dir/testRange.cpp.o"
+  "CMakeFiles/testRange.dir/testRange.cpp.o.d"
+  "testRange"
+  "testRange.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testRange.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
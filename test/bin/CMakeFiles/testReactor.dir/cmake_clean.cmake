@@ -0,0 +1,51 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testReactor.dir/__/src/asyncdb.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/asyncdb.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/backend.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/backend.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/body.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/common.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/connslab.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/connslab.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/governor.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/governor.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/http.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/http.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/log.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/range.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/reactor.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/reactor.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/response.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/router.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/testReactor.dir/__/src/uring.cpp.o"
+  "CMakeFiles/testReactor.dir/__/src/uring.cpp.o.d"
+  "CMakeFiles/testReactor.dir/testReactor.cpp.o"
+  "CMakeFiles/testReactor.dir/testReactor.cpp.o.d"
+  "testReactor"
+  "testReactor.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testReactor.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
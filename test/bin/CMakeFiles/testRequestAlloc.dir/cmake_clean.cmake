@@ -0,0 +1,43 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testRequestAlloc.dir/__/src/asyncdb.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/asyncdb.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/backend.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/backend.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/body.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/body.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/buffer.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/buffer.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/common.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/filecache.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/filecache.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/http.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/http.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/log.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/outqueue.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/outqueue.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/range.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/range.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/response.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/router.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/__/src/tokenizer.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/__/src/tokenizer.cpp.o.d"
+  "CMakeFiles/testRequestAlloc.dir/testRequestAlloc.cpp.o"
+  "CMakeFiles/testRequestAlloc.dir/testRequestAlloc.cpp.o.d"
+  "testRequestAlloc"
+  "testRequestAlloc.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testRequestAlloc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/response.cpp" "/root/repo/test/bin/CMakeFiles/testRouter.dir/__/src/response.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testRouter.dir/__/src/response.cpp.o.d"
+  "/root/repo/src/router.cpp" "/root/repo/test/bin/CMakeFiles/testRouter.dir/__/src/router.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testRouter.dir/__/src/router.cpp.o.d"
+  "/root/repo/test/testRouter.cpp" "/root/repo/test/bin/CMakeFiles/testRouter.dir/testRouter.cpp.o" "gcc" "/root/repo/test/bin/CMakeFiles/testRouter.dir/testRouter.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testRouter.dir/__/src/response.cpp.o"
+  "CMakeFiles/testRouter.dir/__/src/response.cpp.o.d"
+  "CMakeFiles/testRouter.dir/__/src/router.cpp.o"
+  "CMakeFiles/testRouter.dir/__/src/router.cpp.o.d"
+  "CMakeFiles/testRouter.dir/testRouter.cpp.o"
+  "CMakeFiles/testRouter.dir/testRouter.cpp.o.d"
+  "testRouter"
+  "testRouter.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testRouter.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testStmtCache.dir/__/src/common.cpp.o"
+  "CMakeFiles/testStmtCache.dir/__/src/common.cpp.o.d"
+  "CMakeFiles/testStmtCache.dir/__/src/log.cpp.o"
+  "CMakeFiles/testStmtCache.dir/__/src/log.cpp.o.d"
+  "CMakeFiles/testStmtCache.dir/__/src/mysqlpool.cpp.o"
+  "CMakeFiles/testStmtCache.dir/__/src/mysqlpool.cpp.o.d"
+  "CMakeFiles/testStmtCache.dir/__/src/stmtcache.cpp.o"
+  "CMakeFiles/testStmtCache.dir/__/src/stmtcache.cpp.o.d"
+  "CMakeFiles/testStmtCache.dir/testStmtCache.cpp.o"
+  "CMakeFiles/testStmtCache.dir/testStmtCache.cpp.o.d"
+  "testStmtCache"
+  "testStmtCache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testStmtCache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
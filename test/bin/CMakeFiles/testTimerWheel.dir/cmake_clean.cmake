@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testTimerWheel.dir/__/src/timerwheel.cpp.o"
+  "CMakeFiles/testTimerWheel.dir/__/src/timerwheel.cpp.o.d"
+  "CMakeFiles/testTimerWheel.dir/testTimerWheel.cpp.o"
+  "CMakeFiles/testTimerWheel.dir/testTimerWheel.cpp.o.d"
+  "testTimerWheel"
+  "testTimerWheel.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testTimerWheel.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "asyncdb.h"
+#include "timerwheel.h"
+
+/**
+ * 检查异步查询：用 epoll 后端和一个单线程的事件循环驱动 AsyncDb，同时提交几百个查询，
+ * 检查结果、服务器返回的错误、取消、执行超时和排队超时，输出所有查询完成的时间
+ * 需要一个可以连接的 MariaDB，客户端库没有非阻塞接口时跳过
+ * 用法: ./testAsyncDb [host] [user] [passwd] [db]
+ */
+
+bool m_close_log = true;
+
+static const int CONN_NUM = 8;
+static const int QUERY_NUM = 300;
+static const int SLEEP_NUM = 80;
+static const int TIMEOUT_MS = 1000;
+
+static int _done = 0;
+static int _failed = 0;
+static int _timeouts = 0;
+static int _wrong = 0;
+
+// arg 为期望的值，-1 表示不检查结果
+static void onResult(AsyncQuery *query, void *arg) {
+    ++_done;
+    if (query->m_errno == AsyncDb::ERROR_TIMEOUT) {
+        ++_timeouts;
+        return ;
+    }
+    if (query->m_errno != 0) {
+        ++_failed;
+        return ;
+    }
+
+    long expect = (long)arg;
+    MYSQL_ROW row = query->m_result ? mysql_fetch_row(query->m_result) : nullptr;
+    if (row == nullptr || row[0] == nullptr || (expect >= 0 && atol(row[0]) != expect))
+        ++_wrong;
+}
+
+static void reset() {
+    _done = _failed = _timeouts = _wrong = 0;
+}
+
+// 事件循环，直到 *value 达到 target 或者超过 max_ms 毫秒
+static bool runUntil(AsyncDb *db, EventBackend *backend, const int *value, int target, int max_ms) {
+    BackendEvent events[64];
+    uint64_t end = TimerWheel::nowMs() + max_ms;
+    db->advance(TimerWheel::nowMs());
+    while (*value < target) {
+        uint64_t now = TimerWheel::nowMs();
+        if (now > end)
+            return false;
+        int timeout = db->nextTimeout(now);
+        if (timeout < 0 || timeout > 10)
+            timeout = 10;
+        int number = backend->wait(events, 64, timeout);
+        for (int i = 0; i < number; ++i) {
+            if (events[i].m_type == BackendEvent::EVENT_POLL)
+                db->handleEvent(events[i].m_fd, events[i].m_len);
+        }
+        db->advance(TimerWheel::nowMs());
+    }
+    return true;
+}
+
+// 运行 ms 毫秒的事件循环
+static void pump(AsyncDb *db, EventBackend *backend, int ms) {
+    int never = 0;
+    runUntil(db, backend, &never, 1, ms);
+}
+
+// 等所有连接连上
+static bool waitConnected(AsyncDb *db, EventBackend *backend, int max_ms) {
+    uint64_t end = TimerWheel::nowMs() + max_ms;
+    while (db->connected() < CONN_NUM && TimerWheel::nowMs() < end)
+        pump(db, backend, 20);
+    return db->connected() == CONN_NUM;
+}
+
+static AsyncQuery *submit(AsyncDb *db, const char *sql, long expect) {
+    return db->query(sql, strlen(sql), onResult, (void *)expect);
+}
+
+int main(int argc, char *argv[]) {
+#ifndef HAVE_MYSQL_NONBLOCK
+    printf("mysql client library has no non-blocking api, skip\n");
+    return 0;
+#endif
+    const char *host = argc > 1 ? argv[1] : "localhost";
+    const char *user = argc > 2 ? argv[2] : "root";
+    const char *passwd = argc > 3 ? argv[3] : "";
+    const char *name = argc > 4 ? argv[4] : "test";
+
+    int error = 0;
+    int listenfd = eventfd(0, EFD_NONBLOCK);
+    int wakeupfd = eventfd(0, EFD_NONBLOCK);
+    EpollBackend backend;
+    backend.init(listenfd, wakeupfd);
+
+    AsyncDb db;
+    if (!db.init(&backend, host, 3306, user, passwd, name, CONN_NUM, TIMEOUT_MS, 1)) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    if (!waitConnected(&db, &backend, 3000)) {
+        printf("only %d of %d connections to %s\n", db.connected(), CONN_NUM, host);
+        printf("FAIL\n");
+        return 1;
+    }
+
+    // 一次提交几百个查询，连接数以外的排队
+    reset();
+    char sql[64];
+    uint64_t start = TimerWheel::nowMs();
+    for (int i = 0; i < QUERY_NUM; ++i) {
+        snprintf(sql, sizeof(sql), "select %d", i);
+        if (submit(&db, sql, i) == nullptr)
+            ++_failed;
+    }
+    int in_flight = db.pending();
+    bool ok = runUntil(&db, &backend, &_done, QUERY_NUM, 5000);
+    printf("%d queries, %d in flight on %d connections: %llu ms\n", QUERY_NUM, in_flight, CONN_NUM, \
+           (unsigned long long)(TimerWheel::nowMs() - start));
+    if (!ok || _failed || _wrong || _timeouts) {
+        printf("select: %d done, %d failed, %d wrong, %d timeout\n", _done, _failed, _wrong, _timeouts);
+        ++error;
+    }
+
+    // 慢查询并发执行，总时间约为串行的 1/CONN_NUM
+    reset();
+    start = TimerWheel::nowMs();
+    for (int i = 0; i < SLEEP_NUM; ++i)
+        submit(&db, "select sleep(0.05)", -1);
+    ok = runUntil(&db, &backend, &_done, SLEEP_NUM, 5000);
+    printf("%d queries of 50 ms: %llu ms, %d ms if serial\n", SLEEP_NUM, \
+           (unsigned long long)(TimerWheel::nowMs() - start), SLEEP_NUM * 50);
+    if (!ok || _failed || _wrong || _timeouts) {
+        printf("sleep: %d done, %d failed, %d wrong, %d timeout\n", _done, _failed, _wrong, _timeouts);
+        ++error;
+    }
+
+    // 服务器返回的错误不影响连接，取消的查询不调用回调
+    reset();
+    submit(&db, "select * from no_such_table", -1);
+    AsyncQuery *canceled = submit(&db, "select 1", 1);
+    db.cancel(canceled);
+    submit(&db, "select 7", 7);
+    ok = runUntil(&db, &backend, &_done, 2, 2000);
+    pump(&db, &backend, 200);
+    if (!ok || _done != 2 || _failed != 1 || _wrong || db.connected() != CONN_NUM) {
+        printf("error or cancel: %d done, %d failed, %d wrong, %d connections\n", _done, _failed, _wrong, db.connected());
+        ++error;
+    }
+
+    // 执行超时的查询关闭连接后重新连接，排队超时的查询在队列中失败
+    reset();
+    for (int i = 0; i < CONN_NUM + 2; ++i)
+        submit(&db, "select sleep(3)", -1);
+    ok = runUntil(&db, &backend, &_done, CONN_NUM + 2, TIMEOUT_MS * 3);
+    if (!ok || _timeouts != CONN_NUM + 2) {
+        printf("timeout: %d done, %d timeout\n", _done, _timeouts);
+        ++error;
+    }
+    bool reconnected = waitConnected(&db, &backend, 3000);
+    reset();
+    submit(&db, "select 3", 3);
+    ok = runUntil(&db, &backend, &_done, 1, 2000);
+    if (!ok || _wrong || _failed || !reconnected) {
+        printf("reconnect: %d connections, %d done, %d failed\n", db.connected(), _done, _failed);
+        ++error;
+    }
+
+    close(listenfd);
+    close(wakeupfd);
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
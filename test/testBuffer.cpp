@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "buffer.h"
+
+int main() {
+    SegmentPool *pool = SegmentPool::get();
+    pool->init(2);
+
+    // 串成一条三段的链表
+    BufferSegment *head = pool->alloc();
+    head->m_next = pool->alloc();
+    head->m_next->m_next = pool->alloc();
+    BufferSegment *second = head->m_next;
+    BufferSegment *third = second->m_next;
+    memset(head->m_data, 'a', BUFFER_SEGMENT_SIZE);
+    printf("segment size: %d, free: %lu\n", BUFFER_SEGMENT_SIZE, pool->freeCount());
+
+    // 归还前两段，第三段继续使用
+    pool->freeChain(head, third);
+    printf("after free two: %lu\n", pool->freeCount());
+
+    // 空闲段被复用，共享的空闲链表最多保留 2 个，另外最多 SEGMENT_LOCAL_CACHE 个在当前线程的缓存中
+    BufferSegment *reuse = pool->alloc();
+    printf("reuse freed segment: %s, next is null: %s\n", reuse == head || reuse == second ? "yes" : "no", \
+           reuse->m_next == nullptr ? "yes" : "no");
+    pool->free(reuse);
+    pool->free(third);
+    printf("free count capped: %lu, at most %d\n", pool->freeCount(), 2 + SEGMENT_LOCAL_CACHE);
+
+    return 0;
+}
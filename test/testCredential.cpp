@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <atomic>
+#include <map>
+#include <string>
+
+#include "credential.h"
+#include "locker.h"
+
+/**
+ * 检查用户表：加载、校验、增加、修改、删除，写者不断发布新快照时多个读者同时校验，
+ * 最后对比原来的全局 map 加互斥锁，输出多线程下每次校验的耗时
+ * 用法: ./testCredential [每个线程的校验次数]
+ */
+
+bool m_close_log = true;
+
+static const int USER_NUM = 10000;
+static const int READER_NUM = 4;
+
+static int _loops = 1000000;
+static std::atomic<bool> _stop(false);
+static std::atomic<long> _errors(0);
+
+// 原来的实现
+static locker _map_lock;
+static std::map<std::string, std::string> _map_users;
+
+static double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void userName(int i, char *buf) { sprintf(buf, "user%05d", i); }
+static void passwd(int i, char *buf) { sprintf(buf, "pw-%d-%d", i, i * 7); }
+
+// 写者不断修改一个不会被校验的用户，每次都发布新快照，读者校验的用户一直有效
+static void *writer(void *) {
+    int n = 0;
+    while (!_stop.load()) {
+        CredentialStore::get()->upsert("churn", std::to_string(n++));
+        if (n % 2 == 0)
+            CredentialStore::get()->remove("churn");
+    }
+    return nullptr;
+}
+
+static void *reader(void *arg) {
+    long seed = (long)arg;
+    char user[32], pw[32];
+    for (int i = 0; i < _loops; ++i) {
+        int id = (seed * 7919 + i * 31) % USER_NUM;
+        userName(id, user);
+        passwd(id, pw);
+        if (!CredentialStore::get()->verify(user, strlen(user), pw, strlen(pw)))
+            _errors.fetch_add(1);
+    }
+    return nullptr;
+}
+
+static void *mapReader(void *arg) {
+    long seed = (long)arg;
+    char user[32], pw[32];
+    for (int i = 0; i < _loops; ++i) {
+        int id = (seed * 7919 + i * 31) % USER_NUM;
+        userName(id, user);
+        passwd(id, pw);
+        _map_lock.lock();
+        auto it = _map_users.find(user);
+        bool ok = it != _map_users.end() && it->second == pw;
+        _map_lock.unlock();
+        if (!ok)
+            _errors.fetch_add(1);
+    }
+    return nullptr;
+}
+
+// READER_NUM 个线程同时运行，返回每次校验的纳秒数
+static double runReaders(void *(*func)(void *)) {
+    pthread_t tids[READER_NUM];
+    double start = nowSec();
+    for (long i = 0; i < READER_NUM; ++i)
+        pthread_create(&tids[i], nullptr, func, (void *)i);
+    for (int i = 0; i < READER_NUM; ++i)
+        pthread_join(tids[i], nullptr);
+    return (nowSec() - start) * 1e9 / ((double)_loops * READER_NUM);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1)
+        _loops = atoi(argv[1]);
+
+    int error = 0;
+    CredentialStore *store = CredentialStore::get();
+
+    CredentialStore::UserList users;
+    char user[32], pw[32];
+    for (int i = 0; i < USER_NUM; ++i) {
+        userName(i, user);
+        passwd(i, pw);
+        users.emplace_back(user, pw);
+        _map_users[user] = pw;
+    }
+    users.emplace_back("user00001", "replaced");
+    store->load(users);
+
+    // 加载和校验，重复的用户名保留最后一个
+    bool ok = store->size() == USER_NUM && store->verify("user00002", 9, "pw-2-14", 7) && \
+              !store->verify("user00002", 9, "pw-2-15", 7) && !store->verify("user00002", 9, "pw-2-1", 6) && \
+              store->verify("user00001", 9, "replaced", 8) && !store->verify("nobody", 6, "", 0) && \
+              store->contains("user09999", 9) && !store->contains("user1", 5);
+    if (!ok) {
+        printf("load or verify failed\n");
+        ++error;
+    }
+    store->upsert("user00001", "pw-1-7");
+
+    // 增加、修改和删除，每次都发布新版本
+    uint64_t version = store->version();
+    ok = store->upsert("alice", "secret") && store->verify("alice", 5, "secret", 6) && \
+         store->upsert("alice", "changed") && store->verify("alice", 5, "changed", 7) && \
+         !store->verify("alice", 5, "secret", 6) && store->remove("alice") && !store->contains("alice", 5) && \
+         !store->remove("alice") && store->size() == USER_NUM && store->version() == version + 3;
+    if (!ok) {
+        printf("upsert or remove failed\n");
+        ++error;
+    }
+
+    // 写者不断发布时读者校验
+    pthread_t wtid;
+    pthread_create(&wtid, nullptr, writer, nullptr);
+    double store_ns = runReaders(reader);
+    _stop.store(true);
+    pthread_join(wtid, nullptr);
+    printf("verify with concurrent publishing: %.1f ns, %lu versions published\n", store_ns, \
+           (unsigned long)(store->version() - version));
+    if (_errors.load()) {
+        printf("%ld verifications failed\n", _errors.load());
+        ++error;
+    }
+
+    // 没有写者时对比原来的实现
+    store_ns = runReaders(reader);
+    double map_ns = runReaders(mapReader);
+    printf("%d threads, %d users: store %.1f ns/verify, map and mutex %.1f ns/verify\n", READER_NUM, USER_NUM, store_ns, map_ns);
+    if (_errors.load()) {
+        printf("%ld verifications failed\n", _errors.load());
+        ++error;
+    }
+
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
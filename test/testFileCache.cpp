@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fstream>
+
+#include "filecache.h"
+
+bool m_close_log = true;
+
+int main() {
+    const char *path = "/tmp/testFileCache.html";
+    std::ofstream(path) << "<html>v1</html>";
+    chmod(path, 0644);
+
+    // 预算只够缓存很少的条目，方便观察淘汰
+    FileCache::get()->init(64 * 1024, 16, true);
+
+    int error = 0;
+    FileEntry *first = FileCache::get()->acquire(path, &error);
+    FileEntry *second = FileCache::get()->acquire(path, &error);
+    printf("hit same entry: %s, refs: %d\n", first == second ? "yes" : "no", first->m_refs.load());
+    FileCache::release(second);
+
+    // 修改文件后 inotify 线程应当让缓存失效，已经拿到的 entry 仍然可用
+    std::ofstream(path) << "<html>version 2</html>";
+    usleep(100 * 1000);
+    FileEntry *third = FileCache::get()->acquire(path, &error);
+    printf("invalidated after modify: %s, old size: %ld, new size: %ld\n", first != third ? "yes" : "no", \
+           (long)first->m_stat.st_size, (long)third->m_stat.st_size);
+    printf("etag changed: %s, %.*s -> %.*s\n", first->m_etag_len != third->m_etag_len || \
+           memcmp(first->m_etag, third->m_etag, first->m_etag_len) != 0 ? "yes" : "no", \
+           first->m_etag_len, first->m_etag, third->m_etag_len, third->m_etag);
+    printf("validators: %.*s", third->m_validators_len, third->m_validators);
+    FileCache::release(first);
+    FileCache::release(third);
+
+    FileEntry *missing = FileCache::get()->acquire("/tmp/testFileCache.none", &error);
+    printf("missing file: %s, errno is ENOENT: %s\n", missing == nullptr ? "nullptr" : "entry", \
+           error == ENOENT ? "yes" : "no");
+
+    printf("cache count: %lu, bytes: %lu\n", FileCache::get()->count(), FileCache::get()->bytes());
+
+    unlink(path);
+    return 0;
+}
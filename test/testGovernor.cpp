@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <atomic>
+
+#include "governor.h"
+
+// 多个线程模拟 reactor 同时接受和关闭连接，记录观察到的最大连接数
+static const int THREAD_NUM = 4;
+static const int LIMIT = 100;
+static std::atomic<int> _max_seen(0);
+static std::atomic<long> _refused(0);
+
+static void *worker(void *arg) {
+    int id = (int)(long)arg;
+    ConnGovernor *governor = ConnGovernor::get();
+    int held = 0;
+    for (int i = 0; i < 200000; ++i) {
+        // 先尽量占满，再随机归还一部分
+        if ((i & 3) != 3) {
+            if (governor->admit(id)) {
+                ++held;
+                int active = governor->active();
+                int seen = _max_seen.load();
+                while (active > seen && !_max_seen.compare_exchange_weak(seen, active));
+            } else {
+                governor->reject(id);
+                ++_refused;
+            }
+        } else if (held > 0) {
+            governor->release(id);
+            --held;
+        }
+    }
+    while (held-- > 0)
+        governor->release(id);
+    return (void *)nullptr;
+}
+
+int main() {
+    ConnGovernor *governor = ConnGovernor::get();
+
+    // 单线程：上限以内全部接受，之后拒绝，降到恢复水位才可以恢复
+    governor->init(1, 10, ConnGovernor::POLICY_PAUSE);
+    int admitted = 0;
+    for (int i = 0; i < 15; ++i)
+        admitted += governor->admit(0) ? 1 : 0;
+    printf("admitted: %d (expect 10), full: %d, can resume: %d\n", admitted, governor->full(), governor->canResume());
+    governor->pause(0, true);
+    governor->release(0);
+    bool resume = governor->canResume();
+    ConnGovernor::Metrics metrics = governor->metrics(0);
+    printf("after 1 release, can resume: %d (expect 1), active: %d, peak: %d, accepted: %lu, pauses: %lu, paused: %d\n", \
+           resume, metrics.m_active, metrics.m_peak, (unsigned long)metrics.m_accepted, \
+           (unsigned long)metrics.m_pauses, metrics.m_paused);
+    for (int i = 0; i < 9; ++i)
+        governor->release(0);
+
+    // 默认上限按打开文件数的限制计算
+    governor->init(1);
+    printf("default limit: %d\n", governor->limit());
+
+    // 多线程：任何时刻的连接数都不能超过上限，结束后全部归还
+    governor->init(THREAD_NUM, LIMIT, ConnGovernor::POLICY_REJECT);
+    pthread_t tids[THREAD_NUM];
+    for (int i = 0; i < THREAD_NUM; ++i)
+        pthread_create(tids + i, nullptr, worker, (void *)(long)i);
+    for (int i = 0; i < THREAD_NUM; ++i)
+        pthread_join(tids[i], nullptr);
+
+    ConnGovernor::Metrics total = governor->metrics();
+    char buf[256];
+    governor->report(buf, sizeof(buf));
+    printf("%s\n", buf);
+    printf("max seen: %d (limit %d), active at end: %d, rejected: %lu (expect %ld)\n", _max_seen.load(), LIMIT, \
+           governor->active(), (unsigned long)total.m_rejected, _refused.load());
+    bool ok = admitted == 10 && resume && _max_seen.load() <= LIMIT && governor->active() == 0 && total.m_active == 0 && \
+              (long)total.m_rejected == _refused.load() && total.m_peak <= LIMIT;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
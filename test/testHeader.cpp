@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "httpheader.h"
+
+/**
+ * 检查常用请求头的完美哈希：每个名字的大小写变体都能找到，不认识的名字返回 HEADER_UNKNOWN
+ */
+
+int main() {
+    int error = 0;
+
+    for (int id = 0; id < HEADER_COUNT; ++id) {
+        const char *name = HttpHeader::name((HEADER_ID)id);
+        int len = strlen(name);
+        char lower[64], upper[64];
+        for (int i = 0; i <= len; ++i) {
+            lower[i] = tolower(name[i]);
+            upper[i] = toupper(name[i]);
+        }
+
+        if (HttpHeader::lookup(name, len) != id || HttpHeader::lookup(lower, len) != id || \
+            HttpHeader::lookup(upper, len) != id) {
+            printf("lookup failed: %s\n", name);
+            ++error;
+        }
+    }
+
+    const char *unknown[] = {"X-Requested-With", "Hos", "Hosts", "Connect", "Content-Lengths", "Dnt", "Sec-Fetch-Mode", "Te"};
+    for (size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); ++i) {
+        if (HttpHeader::lookup(unknown[i], strlen(unknown[i])) != HEADER_UNKNOWN) {
+            printf("unknown header matched: %s\n", unknown[i]);
+            ++error;
+        }
+    }
+
+    printf("headers: %d, errors: %d\n", HEADER_COUNT, error);
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
@@ -1,23 +1,233 @@
-#include "debug.h"
-#include "log.h"
-#include "http.h"
-#include "mysqlpool.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "http.h"
+
+/**
+ * 用 socketpair 代替真实连接驱动 HttpConn，检查请求的解析和响应：
+ * 处理函数的请求体跨过读缓冲区的段时仍然完整可见，HTTP/1.1 没有 Connection 头时保持连接，
+ * Transfer-Encoding 回复 501，重复、负数和非数字的 Content-Length 回复 400，之后都关闭连接，
+ * 没有上传路由时不接受 PUT，上传写入上传目录，上传数达到上限时回复 503，静态文件忽略查询串，
+ * 静态文件、范围请求的各部分和预压缩版本的 Content-Type 按原文件的扩展名确定
+ */
+
+bool m_close_log = true;
+
+static char _root[] = "/tmp/testHttp";
+static const char _upload_root[] = "/tmp/testHttpUpload";
+
+static EpollBackend _backend(0);        // 没有初始化，注册事件失败不影响直接调用 readOnce 和 process
+
+// 请求体的长度和校验和
+static void echo(HttpConn *conn, const RouteParams &, RouteReply *reply, void *) {
+    const TokenSpan &body = conn->request().m_body;
+    uint64_t sum = 0;
+    for (int i = 0; i < body.m_len; ++i)
+        sum = sum * 31 + (unsigned char)body.m_data[i];
+    reply->append("len=");
+    reply->appendUint(body.m_len);
+    reply->append(" sum=");
+    reply->appendUint(sum);
+    reply->append("\n", 1);
+}
+
+static std::string echoExpect(const std::string &body) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < body.size(); ++i)
+        sum = sum * 31 + (unsigned char)body[i];
+    return "len=" + std::to_string(body.size()) + " sum=" + std::to_string(sum) + "\n";
+}
+
+// 在一个新连接上发送 request，处理到没有数据可读为止，返回收到的所有响应
+static std::string exchange(const std::string &request) {
+    static HttpConn conn;
 
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    conn.init(fds[0], addr, &_backend, _root, 0, true);
+
+    std::string response;
+    char buf[65536];
+    size_t sent = 0;
+    while (true) {
+        if (sent < request.size()) {
+            ssize_t n = send(fds[1], request.data() + sent, request.size() - sent, MSG_DONTWAIT);
+            if (n > 0)
+                sent += n;
+        }
+
+        // 没有数据可读、对端关闭或者连接已经 shutdown 时 readOnce 返回 false
+        bool alive = conn.getSockfd() != -1 && conn.readOnce();
+        if (alive) {
+            conn.m_busy.fetch_add(1);
+            conn.process();
+        }
+
+        ssize_t n;
+        while ((n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+            response.append(buf, n);
+        if (!alive && sent == request.size())
+            break;
+    }
+
+    conn.closeConn();
+    close(fds[1]);
+    return response;
+}
+
+// 响应的个数，测试用的响应体中没有状态行
+static int countResponses(const std::string &response) {
+    int count = 0;
+    for (size_t pos = 0; (pos = response.find("HTTP/1.1 ", pos)) != std::string::npos; ++pos)
+        ++count;
+    return count;
+}
+
+static bool endsWith(const std::string &str, const std::string &suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static std::string post(const std::string &headers, const std::string &body) {
+    return "POST /echo HTTP/1.1\r\nHost: test\r\nConnection: keep-alive\r\n" + headers + \
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
 
 int main() {
-    char text[100];
-    strcpy(text, "GET / HTTP/1.1");
-    Log::getInstance()->init("httpserver", false);
+    int error = 0;
+    mkdir(_root, 0755);
+    std::ofstream("/tmp/testHttp/index.html") << "<html><body>hello</body></html>";
+    chmod("/tmp/testHttp/index.html", 0644);
+    std::ofstream("/tmp/testHttp/style.css") << "body{color:red}";
+    chmod("/tmp/testHttp/style.css", 0644);
+    // 预压缩版本不比原文件旧，内容不必真的是 gzip
+    std::ofstream("/tmp/testHttp/style.css.gz") << "gzipped";
+    chmod("/tmp/testHttp/style.css.gz", 0644);
+    FileCache::get()->init();
+    Router::get()->addHandler(1 << HttpConn::POST, "/echo", echo);
+
+    std::string body(5000, 0);
+    for (size_t i = 0; i < body.size(); ++i)
+        body[i] = 'a' + i % 26;
+
+    // 请求头接近一个段，请求体的大部分落在下一个段
+    std::string pad = "X-Pad: " + std::string(BUFFER_SEGMENT_SIZE - 1000, 'p') + "\r\n";
+    std::string response = exchange(post(pad, body));
+    if (countResponses(response) != 1 || !endsWith(response, echoExpect(body))) {
+        printf("body crossing a segment: %s\n", response.substr(response.find("\r\n\r\n") + 4).c_str());
+        ++error;
+    }
+
+    // 跨过多个段的请求体，后面紧跟着下一个流水线请求
+    std::string large(BODY_BUFFER_MAX - 100, 0);
+    for (size_t i = 0; i < large.size(); ++i)
+        large[i] = 'A' + i * 7 % 26;
+    response = exchange(post("", large) + post("", "user=a&passwd=b"));
+    if (countResponses(response) != 2 || response.find(echoExpect(large)) == std::string::npos || \
+        !endsWith(response, echoExpect("user=a&passwd=b"))) {
+        printf("body of %d segments: %d responses\n", (int)(large.size() / BUFFER_SEGMENT_SIZE), countResponses(response));
+        ++error;
+    }
+
+    // HTTP/1.1 默认保持连接，流水线上的请求都有响应；Connection: close 的请求之后的请求不再处理
+    std::string get = "GET /index.html HTTP/1.1\r\nHost: test\r\n\r\n";
+    response = exchange(get + get);
+    if (countResponses(response) != 2 || response.find("Connection: keep-alive\r\n") == std::string::npos) {
+        printf("pipelined requests without Connection: %d responses\n", countResponses(response));
+        ++error;
+    }
+    response = exchange("GET /index.html HTTP/1.1\r\nHost: test\r\nConnection: Keep-Alive, Close\r\n\r\n" + get);
+    if (countResponses(response) != 1 || response.find("Connection: close\r\n") == std::string::npos) {
+        printf("Connection: close: %d responses\n", countResponses(response));
+        ++error;
+    }
+
+    // 查询串不是文件名的一部分
+    response = exchange("GET /index.html?v=1 HTTP/1.1\r\nHost: test\r\n\r\nGET /?a=b/c HTTP/1.1\r\nHost: test\r\n\r\n");
+    if (countResponses(response) != 2 || response.compare(0, 13, "HTTP/1.1 200 ") != 0 || \
+        !endsWith(response, "hello</body></html>")) {
+        printf("query string: %d responses: %.20s\n", countResponses(response), response.c_str());
+        ++error;
+    }
+
+    // Content-Type 按扩展名确定，多个范围的每一部分和预压缩版本都使用原文件的类型
+    response = exchange("GET /style.css HTTP/1.1\r\nHost: test\r\n\r\n"
+                        "GET /style.css HTTP/1.1\r\nHost: test\r\nRange: bytes=0-3,5-9\r\n\r\n"
+                        "GET /style.css HTTP/1.1\r\nHost: test\r\nAccept-Encoding: gzip\r\n\r\n");
+    size_t types = 0;
+    for (size_t pos = 0; (pos = response.find("Content-Type: text/css\r\n", pos)) != std::string::npos; ++pos)
+        ++types;
+    if (countResponses(response) != 3 || types != 4 || response.find("text/html") != std::string::npos || \
+        response.find("multipart/byteranges") == std::string::npos || \
+        response.find("Content-Encoding: gzip\r\n") == std::string::npos) {
+        printf("content type: %d responses, %zu text/css\n", countResponses(response), types);
+        ++error;
+    }
+
+    // 分块的请求体不能被当成下一个请求
+    response = exchange("POST /echo HTTP/1.1\r\nHost: test\r\nTransfer-Encoding: chunked\r\n\r\n"
+                        "5\r\nhello\r\n0\r\n\r\n" + get);
+    if (countResponses(response) != 1 || response.compare(0, 13, "HTTP/1.1 501 ") != 0 || \
+        response.find("Connection: close\r\n") == std::string::npos) {
+        printf("Transfer-Encoding: %d responses: %.20s\n", countResponses(response), response.c_str());
+        ++error;
+    }
+
+    const char *lengths[] = {"Content-Length: -5\r\n", "Content-Length: abc\r\n", "Content-Length: 5x\r\n", \
+                             "Content-Length: \r\n", "Content-Length: 5\r\nContent-Length: 5\r\n", \
+                             "Content-Length: 99999999999999999999\r\n"};
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+        response = exchange(std::string("POST /echo HTTP/1.1\r\nHost: test\r\n") + lengths[i] + "\r\nhello" + get);
+        if (countResponses(response) != 1 || response.compare(0, 13, "HTTP/1.1 400 ") != 0) {
+            printf("bad length %zu: %d responses: %.20s\n", i, countResponses(response), response.c_str());
+            ++error;
+        }
+    }
 
-    MysqlPool::get()->init("120.26.8.149", "root", "990428yy", "test");
+    // 上传只写入配置的上传目录，上传的文件不能用 GET 取回
+    std::string put = "PUT /upload/a.txt HTTP/1.1\r\nHost: test\r\nContent-Length: 5\r\n\r\nhello";
+    response = exchange(put);
+    if (response.compare(0, 13, "HTTP/1.1 403 ") != 0) {
+        printf("PUT without an upload route: %.20s\n", response.c_str());
+        ++error;
+    }
+    mkdir(_upload_root, 0755);
+    Router::get()->addUpload(UPLOAD_PATH_PREFIX, _upload_root);
+    response = exchange(put + "GET /upload/a.txt HTTP/1.1\r\nHost: test\r\n\r\n");
+    std::ifstream uploaded("/tmp/testHttpUpload/a.txt");
+    std::string content((std::istreambuf_iterator<char>(uploaded)), std::istreambuf_iterator<char>());
+    if (response.compare(0, 13, "HTTP/1.1 201 ") != 0 || content != "hello" || \
+        response.find("HTTP/1.1 405 ") == std::string::npos) {
+        printf("upload: %d responses, content %s\n", countResponses(response), content.c_str());
+        ++error;
+    }
 
-    HttpConn http;
-    sockaddr_in s;
-    http.init(1, s, nullptr, 1, false, "root", "990428yy", "test");
-    http.parseRequestLine(text);
-    http.parseHeaders("Connection: keep-alive");
+    // 名额用完时回复 503，每个完成的上传都归还了名额
+    int slots = 0;
+    while (slots <= UPLOAD_MAX_PER_LOOP && _backend.beginUpload())
+        ++slots;
+    response = exchange(put);
+    if (slots != UPLOAD_MAX_PER_LOOP || response.compare(0, 13, "HTTP/1.1 503 ") != 0) {
+        printf("upload limit: %d slots, %.20s\n", slots, response.c_str());
+        ++error;
+    }
+    while (slots-- > 0)
+        _backend.endUpload();
 
-    while(1);
-    return 0;
+    unlink("/tmp/testHttpUpload/a.txt");
+    rmdir(_upload_root);
+    unlink("/tmp/testHttp/index.html");
+    unlink("/tmp/testHttp/style.css");
+    unlink("/tmp/testHttp/style.css.gz");
+    rmdir(_root);
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
 }
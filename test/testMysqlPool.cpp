@@ -1,13 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <set>
+#include <vector>
+
 #include "mysqlpool.h"
-#include "log.h"
-#include "debug.h"
+#include "timerwheel.h"
+
+/**
+ * 检查 mysql 连接池：按需增长到最多连接数、满了以后获取连接超时失败、归还时唤醒等待的线程、
+ * 空闲时收缩到最少连接数、归还断开的连接时关闭、维护线程 ping 出被服务器关闭的空闲连接并补足、
+ * 建立过久的连接被替换
+ * 需要一个可以连接的 mysql
+ * 用法: ./testMysqlPool [host] [user] [passwd] [db]
+ */
+
+bool m_close_log = true;
+
+static const int MIN_CONN = 2;
+static const int MAX_CONN = 6;
+static const int CHECK_MS = 200;
+static const int IDLE_MS = 600;
+static const int MAX_AGE_MS = 2000;
+
+// 执行一个只返回一个值的查询，失败时返回 -1
+static long queryValue(MYSQL *sql, const char *query) {
+    if (sql == nullptr || mysql_query(sql, query) != 0)
+        return -1;
+    MYSQL_RES *result = mysql_store_result(sql);
+    MYSQL_ROW row = result ? mysql_fetch_row(result) : nullptr;
+    long value = row && row[0] ? atol(row[0]) : -1;
+    if (result)
+        mysql_free_result(result);
+    return value;
+}
+
+// 等待条件成立，最多 max_ms 毫秒
+static bool waitFor(bool (*done)(), int max_ms) {
+    uint64_t end = TimerWheel::nowMs() + max_ms;
+    while (!done() && TimerWheel::nowMs() < end)
+        usleep(20 * 1000);
+    return done();
+}
+
+static bool shrunk() {
+    return MysqlPool::get()->getSize() == MIN_CONN;
+}
+
+static bool refilled() {
+    return MysqlPool::get()->getFreeConnect() == MIN_CONN;
+}
+
+static void *waiter(void *arg) {
+    *(MYSQL **)arg = MysqlPool::get()->getMysqlConnect(3000);
+    return nullptr;
+}
+
+// 同时取出 n 个连接，返回它们的 connection_id，查询失败的记为 -1
+static std::vector<long> connectionIds(int n) {
+    std::vector<MYSQL *> conns;
+    std::vector<long> ids;
+    for (int i = 0; i < n; ++i)
+        conns.push_back(MysqlPool::get()->getMysqlConnect(1000));
+    for (int i = 0; i < n; ++i) {
+        ids.push_back(queryValue(conns[i], "select connection_id()"));
+        MysqlPool::get()->freeMysqlConnect(conns[i]);
+    }
+    return ids;
+}
+
+int main(int argc, char *argv[]) {
+    const char *host = argc > 1 ? argv[1] : "localhost";
+    const char *user = argc > 2 ? argv[2] : "root";
+    const char *passwd = argc > 3 ? argv[3] : "";
+    const char *name = argc > 4 ? argv[4] : "test";
+
+    int error = 0;
+    MysqlPool *pool = MysqlPool::get();
+    pool->setMaintain(CHECK_MS, IDLE_MS, MAX_AGE_MS);
+    if (!pool->init(host, user, passwd, name, 3306, MAX_CONN, 1, MIN_CONN) || pool->getSize() != MIN_CONN) {
+        printf("init: %d connections to %s\n", pool->getSize(), host);
+        printf("FAIL\n");
+        return 1;
+    }
+
+    // 没有空闲连接时增长到最多连接数，之后获取连接在超时后失败
+    std::vector<MYSQL *> held;
+    for (int i = 0; i < MAX_CONN; ++i)
+        held.push_back(pool->getMysqlConnect(1000));
+    uint64_t begin = TimerWheel::nowMs();
+    MYSQL *extra = pool->getMysqlConnect(300);
+    uint64_t waited = TimerWheel::nowMs() - begin;
+    printf("grow to %d connections, acquire on a full pool fails after %llu ms\n", pool->getSize(), (unsigned long long)waited);
+    bool ok = extra == nullptr && pool->getSize() == MAX_CONN && pool->getUsedConnect() == MAX_CONN && \
+              waited >= 250 && waited < 2000;
+    for (int i = 0; i < MAX_CONN; ++i)
+        ok = ok && queryValue(held[i], "select 1") == 1;
+    if (!ok) {
+        printf("grow or timeout failed\n");
+        ++error;
+    }
+
+    // 归还的连接交给等待的线程
+    MYSQL *got = nullptr;
+    pthread_t tid;
+    pthread_create(&tid, nullptr, waiter, &got);
+    usleep(100 * 1000);
+    pool->freeMysqlConnect(held.back());
+    held.pop_back();
+    pthread_join(tid, nullptr);
+    if (got == nullptr || queryValue(got, "select 2") != 2) {
+        printf("waiter did not get the released connection\n");
+        ++error;
+    }
+    held.push_back(got);
+
+    // 全部归还后空闲的多余连接被关闭
+    for (size_t i = 0; i < held.size(); ++i)
+        pool->freeMysqlConnect(held[i]);
+    held.clear();
+    if (!waitFor(shrunk, IDLE_MS + CHECK_MS * 5)) {
+        printf("pool did not shrink: %d connections\n", pool->getSize());
+        ++error;
+    }
+
+    // 归还时出现客户端错误的连接被关闭，之后获取到的是新连接
+    MYSQL *victim = pool->getMysqlConnect(1000);
+    MYSQL *killer = pool->getMysqlConnect(1000);
+    char query[64];
+    snprintf(query, sizeof(query), "kill %ld", queryValue(victim, "select connection_id()"));
+    queryValue(killer, query);
+    pool->freeMysqlConnect(killer);
+    bool lost = queryValue(victim, "select 1") == -1;
+    pool->freeMysqlConnect(victim);
+    // 最近归还的连接最先取出，如果断开的连接回到了池中，这里会取到它
+    MYSQL *fresh = pool->getMysqlConnect(1000);
+    if (!lost || queryValue(fresh, "select 3") != 3) {
+        printf("broken connection returned to the pool\n");
+        ++error;
+    }
+    pool->freeMysqlConnect(fresh);
 
+    // 被服务器关闭的空闲连接由维护线程 ping 出来并补足
+    victim = pool->getMysqlConnect(1000);
+    killer = pool->getMysqlConnect(1000);
+    snprintf(query, sizeof(query), "kill %ld", queryValue(victim, "select connection_id()"));
+    queryValue(killer, query);
+    pool->freeMysqlConnect(victim);
+    pool->freeMysqlConnect(killer);
+    usleep(CHECK_MS * 4 * 1000);
+    waitFor(refilled, CHECK_MS * 5);
+    std::vector<long> ids = connectionIds(pool->getFreeConnect());
+    int dead = 0;
+    for (size_t i = 0; i < ids.size(); ++i)
+        dead += ids[i] == -1;
+    if (ids.size() < (size_t)MIN_CONN || dead) {
+        printf("ping: %d idle connections, %d dead\n", (int)ids.size(), dead);
+        ++error;
+    }
 
-int main() {
-    Log::getInstance()->init("httpserver", false);
+    // 建立过久的连接被替换，空闲的最少连接不会因为空闲被关闭
+    std::set<long> old_ids(ids.begin(), ids.end());
+    uint64_t aged = TimerWheel::nowMs() + MAX_AGE_MS + CHECK_MS * 3;
+    while (TimerWheel::nowMs() < aged)
+        usleep(50 * 1000);
+    waitFor(refilled, CHECK_MS * 5);
+    ids = connectionIds(MIN_CONN);
+    int reused = 0;
+    for (size_t i = 0; i < ids.size(); ++i)
+        reused += ids[i] == -1 || old_ids.count(ids[i]);
+    if (reused) {
+        printf("age: %d connections older than %d ms still in use\n", reused, MAX_AGE_MS);
+        ++error;
+    }
 
-    MysqlPool::get()->init("120.26.8.149", "root", "990428yy", "test");
+    // 停止后获取连接立即失败
+    int used = pool->getUsedConnect();
+    pool->destroyMysqlConnect();
+    if (used != 0 || pool->getMysqlConnect(1000) != nullptr || pool->getSize() != 0) {
+        printf("destroy: %d used, %d left\n", used, pool->getSize());
+        ++error;
+    }
 
-    while (1);
-    return 0;
-}
\ No newline at end of file
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <string>
+
+#include "outqueue.h"
+
+/**
+ * 用发送缓冲区很小的 socketpair 模拟慢速的客户端：
+ * 队列中混合响应头、静态数据和文件区域，每次 flush 到 EAGAIN 后读走一部分，
+ * 检查收到的字节顺序正确，发完后所有段都归还给内存池
+ */
+
+bool m_close_log = true;
+
+int main() {
+    SegmentPool *pool = SegmentPool::get();
+
+    // 文件区域的内容
+    char path[] = "/tmp/testOutQueueXXXXXX";
+    int fd = mkstemp(path);
+    std::string file_data(200000, 'f');
+    for (size_t i = 0; i < file_data.size(); ++i)
+        file_data[i] = 'a' + i % 26;
+    write(fd, file_data.data(), file_data.size());
+    unlink(path);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int sndbuf = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    OutputQueue queue;
+    std::string expect;
+    const char *body = "static body\n";
+    size_t free_before = pool->freeCount();
+
+    for (int i = 0; i < 10; ++i) {
+        int avail;
+        char *buf = queue.reserve(&avail);
+        int len = snprintf(buf, avail, "header %d\r\n", i);
+        queue.commit(len);
+        expect.append(buf, len);
+
+        if (i % 3 == 0) {
+            queue.pushFile(fd, i * 100, 20000, nullptr);
+            expect.append(file_data, i * 100, 20000);
+        } else {
+            queue.pushMemory(body, strlen(body));
+            expect.append(body);
+        }
+    }
+    printf("queued bytes: %lu, expect: %lu, full: %s\n", queue.bytes(), expect.size(), queue.full() ? "yes" : "no");
+
+    // 慢速读取
+    std::string received;
+    int again = 0;
+    char buf[3000];
+    while (true) {
+        int ret = queue.flush(fds[0]);
+        if (ret < 0) {
+            printf("flush error\n");
+            return 1;
+        }
+        if (ret == 0)
+            ++again;
+        int n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0)
+            received.append(buf, n);
+        if (ret == 1 && received.size() == expect.size())
+            break;
+    }
+
+    bool same = received == expect;
+    bool empty = queue.empty() && queue.bytes() == 0;
+    bool returned = pool->freeCount() >= free_before + 1;
+    printf("eagain: %d, received: %lu, same: %s, empty: %s, segments returned: %s\n", again, received.size(), \
+           same ? "yes" : "no", empty ? "yes" : "no", returned ? "yes" : "no");
+
+    bool ok = same && empty && returned && again > 0;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    close(fd);
+    return ok ? 0 : 1;
+}
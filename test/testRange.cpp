@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "range.h"
+
+/**
+ * 检查 Range 请求头的解析：各种形式的范围、截断到文件末尾、格式错误时忽略、范围都在文件外时返回 -1
+ */
+
+struct RangeCase {
+    const char  *m_value;
+    uint64_t    m_size;
+    int         m_count;        // 期望的返回值
+    ByteRange   m_ranges[2];    // 期望的前两个范围
+};
+
+static const RangeCase _cases[] = {
+    {"bytes=0-99", 1000, 1, {{0, 99}}},
+    {"bytes=100-", 1000, 1, {{100, 999}}},
+    {"bytes=-100", 1000, 1, {{900, 999}}},
+    {"bytes=-5000", 1000, 1, {{0, 999}}},
+    {"bytes=900-5000", 1000, 1, {{900, 999}}},
+    {"BYTES=0-0", 1000, 1, {{0, 0}}},
+    {"bytes=0-9, 100-199", 1000, 2, {{0, 9}, {100, 199}}},
+    {"bytes=0-9,5000-6000,-1", 1000, 2, {{0, 9}, {999, 999}}},
+    {"bytes=5000-", 1000, -1, {}},
+    {"bytes=5000-6000,7000-", 1000, -1, {}},
+    {"bytes=-0", 1000, -1, {}},
+    {"bytes=0-", 0, -1, {}},
+    {"bytes=9-0", 1000, 0, {}},
+    {"bytes=-", 1000, 0, {}},
+    {"bytes=a-b", 1000, 0, {}},
+    {"bytes=0-9;", 1000, 0, {}},
+    {"items=0-9", 1000, 0, {}},
+    {"bytes=99999999999999999999-", 1000, 0, {}},
+    {"bytes=0-0,1-1,2-2,3-3,4-4,5-5,6-6,7-7,8-8", 1000, 0, {}},
+};
+
+int main() {
+    int error = 0;
+    int total = sizeof(_cases) / sizeof(_cases[0]);
+
+    for (int i = 0; i < total; ++i) {
+        const RangeCase &c = _cases[i];
+        TokenSpan value = {c.m_value, (int)strlen(c.m_value)};
+        ByteRange ranges[RANGE_MAX_COUNT];
+        int count = HttpRange::parse(value, c.m_size, ranges, RANGE_MAX_COUNT);
+
+        bool ok = count == c.m_count;
+        for (int j = 0; ok && j < count && j < 2; ++j)
+            ok = ranges[j].m_start == c.m_ranges[j].m_start && ranges[j].m_end == c.m_ranges[j].m_end;
+        if (!ok) {
+            printf("parse failed: \"%s\" size %lu, got %d\n", c.m_value, (unsigned long)c.m_size, count);
+            ++error;
+        }
+    }
+
+    printf("cases: %d, errors: %d\n", total, error);
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
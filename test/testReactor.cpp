@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <fstream>
+#include <string>
+
+#include "log.h"
+#include "reactor.h"
+#include "filecache.h"
+#include "uring.h"
+
+/**
+ * 在回环地址上启动一个 reactor，用真实的连接检查：流水线上的多个请求按顺序响应，
+ * 大文件(sendfile/splice 路径)和后面流水线上的小文件完整且不错位，
+ * 客户端发完请求后半关闭仍然收到所有响应，客户端提前关闭连接后服务器继续工作，
+ * 一个只发请求不读响应的客户端不影响同一个 reactor 上的其他连接，
+ * 慢速读取的下载持续时间超过连接超时(编译时都缩短为 1 秒)也不会被超时关闭
+ * 依次使用 epoll LT、epoll ET 和 io_uring 后端(内核不支持时跳过)，所有检查结束后退出
+ * 用法: ./testReactor [port]
+ */
+
+bool m_close_log = true;
+
+static char _root[] = "/tmp/testReactor";
+static const char _index[] = "<html><body>hello</body></html>";
+static const size_t LARGE_SIZE = 4 * 1024 * 1024 + 123;
+static const size_t SLOW_SIZE = 16 * 1024 * 1024;
+
+static int _port;
+
+static void *serverRun(void *arg) {
+    ((WebServer *)arg)->start();
+    return nullptr;
+}
+
+// 连接服务器，读写最多等待 5 秒，测试不会卡住
+static int connectServer() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 50; ++i) {
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0)
+            return fd;
+        usleep(20000);
+    }
+    close(fd);
+    return -1;
+}
+
+static bool sendAll(int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+// 读到服务器关闭连接为止，超时返回 false
+static bool recvAll(int fd, std::string *data) {
+    char buf[65536];
+    while (true) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0)
+            return true;
+        if (n < 0)
+            return false;
+        data->append(buf, n);
+    }
+}
+
+// 按 Content-Length 拆开响应，返回每个响应的状态码和响应体
+static int splitResponses(const std::string &data, int *codes, std::string *bodies, int max) {
+    int count = 0;
+    size_t pos = 0;
+    while (pos < data.size() && count < max) {
+        size_t end = data.find("\r\n\r\n", pos);
+        if (end == std::string::npos || data.compare(pos, 9, "HTTP/1.1 ") != 0)
+            return -1;
+        size_t length = data.find("Content-Length: ", pos);
+        if (length == std::string::npos || length > end)
+            return -1;
+        size_t body_len = strtoul(data.c_str() + length + 16, nullptr, 10);
+        if (end + 4 + body_len > data.size())
+            return -1;
+        codes[count] = atoi(data.c_str() + pos + 9);
+        bodies[count] = data.substr(end + 4, body_len);
+        ++count;
+        pos = end + 4 + body_len;
+    }
+    return pos == data.size() ? count : -1;
+}
+
+static std::string get(const char *path, bool close=false) {
+    return std::string("GET ") + path + " HTTP/1.1\r\nHost: test\r\n" + (close ? "Connection: close\r\n" : "") + "\r\n";
+}
+
+// 发送 request，读到连接关闭，检查响应体依次为 expect 中的内容
+static bool exchange(const char *name, const std::string &request, const std::string *expect, int count, bool half_close) {
+    int fd = connectServer();
+    std::string data;
+    bool ok = fd != -1 && sendAll(fd, request);
+    if (ok && half_close)
+        shutdown(fd, SHUT_WR);
+    ok = ok && recvAll(fd, &data);
+    if (fd != -1)
+        close(fd);
+
+    int codes[8];
+    std::string bodies[8];
+    int got = ok ? splitResponses(data, codes, bodies, 8) : -1;
+    bool same = got == count;
+    for (int i = 0; same && i < count; ++i)
+        same = codes[i] == 200 && bodies[i] == expect[i];
+    if (!same)
+        printf("  %s: %s, %d responses of %d, %zu bytes\n", name, ok ? "closed" : "timeout", got, count, data.size());
+    return same;
+}
+
+// 每 10 毫秒只读 64KB，下载整个文件需要的时间比 KEEPALIVE_TIMEOUT 长
+static bool slowDownload(const char *path, size_t size) {
+    int fd = connectServer();
+    if (fd == -1 || !sendAll(fd, get(path, true))) {
+        if (fd != -1)
+            close(fd);
+        return false;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    std::string data;
+    char buf[65536];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        data.append(buf, n);
+        usleep(10000);
+    }
+    close(fd);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    size_t head = data.find("\r\n\r\n");
+    bool ok = head != std::string::npos && data.size() - head - 4 == size;
+    if (!ok || ms <= KEEPALIVE_TIMEOUT)
+        printf("  slow download: %zu of %zu bytes in %ld ms\n", head == std::string::npos ? 0 : data.size() - head - 4, size, ms);
+    return ok && ms > KEEPALIVE_TIMEOUT;
+}
+
+static int runChecks(const std::string &large) {
+    int error = 0;
+    std::string index(_index);
+
+    // 流水线上的三个请求，最后一个要求关闭连接
+    std::string expect[3] = {index, index, index};
+    error += !exchange("pipelined", get("/index.html") + get("/") + get("/index.html", true), expect, 3, false);
+
+    // 大文件后面紧跟小文件，小文件的响应必须在大文件之后完整到达
+    expect[0] = large;
+    expect[1] = index;
+    error += !exchange("large file", get("/large.bin") + get("/index.html", true), expect, 2, false);
+
+    // 发完请求就关闭写方向，仍然收到所有响应后服务器关闭连接
+    expect[0] = index;
+    expect[1] = large;
+    expect[2] = index;
+    error += !exchange("half close", get("/index.html") + get("/large.bin") + get("/index.html"), expect, 3, true);
+
+    // 请求大文件后立刻关闭，或者只读一部分响应就关闭
+    for (int i = 0; i < 20; ++i) {
+        int fd = connectServer();
+        if (fd == -1)
+            break;
+        sendAll(fd, get("/large.bin") + get("/large.bin"));
+        if (i % 2) {
+            char buf[4096];
+            recv(fd, buf, sizeof(buf), 0);
+        }
+        close(fd);
+    }
+    error += !exchange("after early close", get("/index.html", true), expect, 1, false);
+
+    // 不停地发送流水线请求但从不读响应，服务器停止读这个连接，不能占满整个 reactor 的接收缓冲区
+    int flood = connectServer();
+    if (flood != -1) {
+        std::string batch;
+        for (int i = 0; i < 1024; ++i)
+            batch += get("/large.bin");
+        size_t sent = 0;
+        int idle = 0;
+        while (sent < 16 * 1024 * 1024 && idle < 30) {
+            ssize_t n = send(flood, batch.data() + sent % batch.size(), batch.size() - sent % batch.size(), \
+                             MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+                idle = 0;
+            } else {
+                ++idle;
+                usleep(10000);
+            }
+        }
+        error += !exchange("beside a flooding client", get("/index.html", true), expect, 1, false);
+        close(flood);
+    }
+
+    error += !slowDownload("/slow.bin", SLOW_SIZE);
+    return error;
+}
+
+int main(int argc, char *argv[]) {
+    signal(SIGPIPE, SIG_IGN);
+    // 所有检查都有超时，这里只防止服务器线程卡住
+    alarm(120);
+    int base_port = argc > 1 ? atoi(argv[1]) : 9106;
+
+    mkdir(_root, 0755);
+    std::ofstream("/tmp/testReactor/index.html") << _index;
+    std::string large(LARGE_SIZE, 0);
+    for (size_t i = 0; i < large.size(); ++i)
+        large[i] = 'a' + i * 7 % 26 + (i % 4096 == 0);
+    std::ofstream("/tmp/testReactor/large.bin", std::ios::binary) << large;
+    std::ofstream("/tmp/testReactor/slow.bin", std::ios::binary) << std::string(SLOW_SIZE, 's');
+    chmod("/tmp/testReactor/slow.bin", 0644);
+    chmod("/tmp/testReactor/index.html", 0644);
+    chmod("/tmp/testReactor/large.bin", 0644);
+    FileCache::get()->init(FILE_CACHE_MAX_BYTES, FILE_CACHE_MAX_FILES, 1);
+
+    struct Mode {
+        const char  *m_name;
+        int         m_backend;
+        int         m_trig;
+    } modes[] = {
+        {"epoll LT", EventBackend::BACKEND_EPOLL, 0},
+        {"epoll ET", EventBackend::BACKEND_EPOLL, 1},
+        {"io_uring", EventBackend::BACKEND_URING, 1},
+    };
+
+    int error = 0;
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+        if (modes[i].m_backend == EventBackend::BACKEND_URING && !UringBackend::supported()) {
+            printf("%s: not supported, skip\n", modes[i].m_name);
+            continue;
+        }
+
+        _port = base_port + i;
+        WebServer server;
+        server.init(_port, _root, 1, 0, modes[i].m_trig, true, "", "", "", modes[i].m_backend);
+        pthread_t tid;
+        pthread_create(&tid, nullptr, serverRun, &server);
+
+        int errors = runChecks(large);
+        printf("%s: %d errors\n", modes[i].m_name, errors);
+        error += errors;
+
+        server.stop();
+        pthread_join(tid, nullptr);
+    }
+
+    unlink("/tmp/testReactor/index.html");
+    unlink("/tmp/testReactor/large.bin");
+    unlink("/tmp/testReactor/slow.bin");
+    rmdir(_root);
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
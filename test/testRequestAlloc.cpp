@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <new>
+
+#include "http.h"
+
+/**
+ * 统计 keep-alive 请求处理过程中的堆内存分配次数
+ * 用 socketpair 代替真实连接，预热后每个请求从读取、解析、查找文件到写出响应都不应该分配内存
+ */
+
+bool m_close_log = true;
+
+static volatile bool _counting = false;
+static volatile long _alloc_count = 0;
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+// 替换 malloc 系列函数和 operator new，统计分配次数
+extern "C" void *malloc(size_t size) {
+    if (_counting) ++_alloc_count;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+    if (_counting) ++_alloc_count;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    if (_counting) ++_alloc_count;
+    return __libc_realloc(ptr, size);
+}
+
+void *operator new(size_t size) {
+    if (_counting) ++_alloc_count;
+    void *ptr = __libc_malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+// 发送一个请求并读完响应，返回响应的字节数
+static int roundTrip(HttpConn *conn, int peer, const char *request) {
+    send(peer, request, strlen(request), 0);
+
+    if (!conn->readOnce())
+        return -1;
+    conn->m_busy.fetch_add(1);
+    conn->process();
+
+    static char response[65536];
+    return recv(peer, response, sizeof(response), 0);
+}
+
+int main() {
+    char root[] = "/tmp/testRequestAlloc";
+    mkdir(root, 0755);
+    std::ofstream("/tmp/testRequestAlloc/index.html") << "<html><body>hello</body></html>";
+    chmod("/tmp/testRequestAlloc/index.html", 0644);
+
+    FileCache::get()->init();
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    // 没有初始化的 epoll 后端，注册事件失败不影响直接调用 process
+    static EpollBackend backend(0);
+    static HttpConn conn;
+    conn.init(fds[0], addr, &backend, root, 0, true);
+
+    const char *request = "GET /index.html HTTP/1.1\r\n"
+                          "Host: 127.0.0.1\r\n"
+                          "Connection: keep-alive\r\n"
+                          "User-Agent: testRequestAlloc\r\n"
+                          "Accept: */*\r\n"
+                          "\r\n";
+
+    // 预热：文件缓存、段内存池以及 stdio 的缓冲区
+    for (int i = 0; i < 10; ++i)
+        roundTrip(&conn, fds[1], request);
+
+    // 单独走一遍解析，检查请求头视图
+    send(fds[1], request, strlen(request), 0);
+    conn.readOnce();
+    HttpConn::HTTP_CODE ret = conn.processRead();
+    const TokenSpan *agent = conn.request().header("user-agent");
+    printf("parse result: %d, headers: %d, path: %.*s, user-agent: %.*s\n", ret, conn.request().m_header_count, \
+           conn.request().m_path.m_len, conn.request().m_path.m_data, agent ? agent->m_len : 0, agent ? agent->m_data : "");
+    conn.processWrite(ret);
+    conn.nextRequest();
+    conn.write();
+    static char response[65536];
+    recv(fds[1], response, sizeof(response), 0);
+
+    const int rounds = 10000;
+    long bytes = 0;
+    _counting = true;
+    for (int i = 0; i < rounds; ++i)
+        bytes += roundTrip(&conn, fds[1], request);
+    _counting = false;
+
+    printf("requests: %d, response bytes: %ld, heap allocations: %ld\n", rounds, bytes, _alloc_count);
+    printf("%s\n", _alloc_count == 0 ? "PASS" : "FAIL");
+
+    unlink("/tmp/testRequestAlloc/index.html");
+    rmdir(root);
+    return _alloc_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "router.h"
+
+/**
+ * 检查路由的匹配：静态、参数、前缀路由的优先级，方法分派和 405，冲突的注册，查询串，上传目录，
+ * 最后输出一次查找的耗时
+ */
+
+static void handler(HttpConn *, const RouteParams &, RouteReply *, void *) {}
+
+/* 方法的位，与 HttpConn::METHOD 相同 */
+enum { GET_BIT = 1 << 0, POST_BIT = 1 << 1, PUT_BIT = 1 << 3 };
+
+static int _tags[8];
+
+struct RouterCase {
+    int         m_method;           // HttpConn::METHOD
+    const char  *m_path;
+    int         m_match;            // Router::MATCH
+    int         m_tag;              // 期望的路由，-1 为静态目录，-2 为上传目录
+    const char  *m_param;           // 期望的参数 "name=value"，nullptr 表示不检查
+    const char  *m_rest;            // 期望的剩余路径，nullptr 表示不检查
+};
+
+static const RouterCase _cases[] = {
+    {0, "/api/users", Router::MATCH_OK, 0, nullptr, nullptr},
+    {1, "/api/users", Router::MATCH_OK, 1, nullptr, nullptr},
+    {3, "/api/users", Router::MATCH_METHOD, 0, nullptr, nullptr},
+    {0, "/api/users/42", Router::MATCH_OK, 2, "id=42", nullptr},
+    {0, "/api/users/me", Router::MATCH_OK, 3, nullptr, nullptr},
+    {0, "/api/users/42/posts/7", Router::MATCH_OK, 4, "pid=7", nullptr},
+    {0, "/api/users/42/posts", Router::MATCH_NONE, 0, nullptr, nullptr},
+    {0, "/api/users/", Router::MATCH_NONE, 0, nullptr, nullptr},
+    {0, "/api/user", Router::MATCH_NONE, 0, nullptr, nullptr},
+    {0, "/api/users?page=2", Router::MATCH_OK, 0, nullptr, nullptr},
+    {0, "/api/users/42?x=/y", Router::MATCH_OK, 2, "id=42", nullptr},
+    {0, "/assets/css/site.css", Router::MATCH_OK, -1, nullptr, "css/site.css"},
+    {0, "/assets/", Router::MATCH_OK, -1, nullptr, ""},
+    {1, "/assets/a.js", Router::MATCH_METHOD, 0, nullptr, nullptr},
+    {0, "/assets", Router::MATCH_NONE, 0, nullptr, nullptr},
+    {0, "/files/a/b", Router::MATCH_OK, 5, nullptr, "a/b"},
+    {0, "/files/special", Router::MATCH_OK, 6, nullptr, nullptr},
+    {0, "/files/special/x", Router::MATCH_OK, 5, nullptr, "special/x"},
+    {3, "/upload/a.bin", Router::MATCH_OK, -2, nullptr, "a.bin"},
+    {1, "/upload/dir/b.txt?v=1", Router::MATCH_OK, -2, nullptr, "dir/b.txt"},
+    {0, "/upload/a.bin", Router::MATCH_METHOD, 0, nullptr, nullptr},
+    {3, "/assets/a.js", Router::MATCH_METHOD, 0, nullptr, nullptr},
+    {0, "/index.html", Router::MATCH_NONE, 0, nullptr, nullptr},
+    {0, "/", Router::MATCH_NONE, 0, nullptr, nullptr},
+};
+
+// 比较视图和字符串
+static bool spanEquals(const TokenSpan *span, const char *str) {
+    return span && span->m_len == (int)strlen(str) && memcmp(span->m_data, str, span->m_len) == 0;
+}
+
+int main() {
+    int error = 0;
+    Router *router = Router::get();
+
+    bool ok = router->addHandler(GET_BIT, "/api/users", handler, &_tags[0]) && \
+              router->addHandler(POST_BIT, "/api/users", handler, &_tags[1]) && \
+              router->addHandler(GET_BIT, "/api/users/:id", handler, &_tags[2]) && \
+              router->addHandler(GET_BIT, "/api/users/me", handler, &_tags[3]) && \
+              router->addHandler(GET_BIT, "/api/users/:id/posts/:pid", handler, &_tags[4]) && \
+              router->addStatic("/assets", "/var/www/assets") && \
+              router->addUpload("/upload/", "/srv/upload") && \
+              router->addHandler(GET_BIT, "/files/*", handler, &_tags[5]) && \
+              router->addHandler(GET_BIT, "/files/special", handler, &_tags[6]);
+    if (!ok) {
+        printf("register routes failed\n");
+        ++error;
+    }
+
+    // 冲突的注册
+    if (router->addHandler(GET_BIT, "/api/users", handler)) {
+        printf("duplicate route accepted\n");
+        ++error;
+    }
+    if (router->addHandler(GET_BIT, "/api/users/:name/x", handler)) {
+        printf("conflicting parameter name accepted\n");
+        ++error;
+    }
+    if (router->addHandler(GET_BIT, "api", handler) || router->addHandler(GET_BIT, "/a/*/b", handler)) {
+        printf("bad pattern accepted\n");
+        ++error;
+    }
+
+    int total = sizeof(_cases) / sizeof(_cases[0]);
+    for (int i = 0; i < total; ++i) {
+        const RouterCase &c = _cases[i];
+        const Route *route = nullptr;
+        RouteParams params;
+        int allow = 0;
+        int match = router->find(c.m_method, c.m_path, strlen(c.m_path), &route, &params, &allow);
+
+        bool good = match == c.m_match;
+        if (good && match == Router::MATCH_OK) {
+            if (c.m_tag == -1)
+                good = route->m_handler == nullptr && !route->m_upload && route->m_dir == "/var/www/assets/";
+            else if (c.m_tag == -2)
+                good = route->m_handler == nullptr && route->m_upload && route->m_dir == "/srv/upload/";
+            else
+                good = route->m_handler != nullptr && route->m_arg == &_tags[c.m_tag];
+            if (good && c.m_param) {
+                char name[32];
+                const char *eq = strchr(c.m_param, '=');
+                snprintf(name, sizeof(name), "%.*s", (int)(eq - c.m_param), c.m_param);
+                good = spanEquals(params.get(name), eq + 1);
+            }
+            if (good && c.m_rest)
+                good = spanEquals(&params.m_rest, c.m_rest);
+        }
+        if (good && match == Router::MATCH_METHOD)
+            good = allow != 0 && !(allow & (1 << c.m_method));
+        if (!good) {
+            printf("find failed: method %d \"%s\", got %d\n", c.m_method, c.m_path, match);
+            ++error;
+        }
+    }
+
+    // 一次查找的耗时
+    const char *path = "/api/users/42/posts/7";
+    int len = strlen(path);
+    int loops = 1000000;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int found = 0;
+    for (int i = 0; i < loops; ++i) {
+        const Route *route;
+        RouteParams params;
+        int allow;
+        found += router->find(0, path, len, &route, &params, &allow) == Router::MATCH_OK;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / loops;
+    printf("routes: %d, find \"%s\": %.1f ns\n", router->count(), path, ns);
+    if (found != loops)
+        ++error;
+
+    router->clear();
+    printf("cases: %d, errors: %d\n", total, error);
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
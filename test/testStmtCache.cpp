@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "mysqlpool.h"
+#include "stmtcache.h"
+
+/**
+ * 检查预处理语句缓存：同一条语句只准备一次、参数按二进制绑定(包括 NULL 和带引号的字符串)、
+ * 超过默认缓冲区的字符串列扩大后读取完整、连接重新连接后语句重新准备、
+ * 语句出现客户端错误时连接归还后被关闭
+ * 需要一个可以连接的 mysql，使用临时表 stmt_test
+ * 用法: ./testStmtCache [host] [user] [passwd] [db]
+ */
+
+bool m_close_log = true;
+
+// 执行一个只返回一个值的查询，失败时返回 -1
+static long queryValue(MYSQL *sql, const char *query) {
+    if (sql == nullptr || mysql_query(sql, query) != 0)
+        return -1;
+    MYSQL_RES *result = mysql_store_result(sql);
+    MYSQL_ROW row = result ? mysql_fetch_row(result) : nullptr;
+    long value = row && row[0] ? atol(row[0]) : -1;
+    if (result)
+        mysql_free_result(result);
+    return value;
+}
+
+static bool insertRow(StmtCache *stmts, long long id, const char *name) {
+    MysqlStmt *stmt = stmts->prepare("insert into stmt_test(id,name) values(?,?)");
+    if (stmt == nullptr)
+        return false;
+    stmt->bindInt(0, id);
+    if (name)
+        stmt->bindString(1, name, strlen(name));
+    else
+        stmt->bindNull(1);
+    return stmt->execute() && stmt->affectedRows() == 1;
+}
+
+int main(int argc, char *argv[]) {
+    const char *host = argc > 1 ? argv[1] : "localhost";
+    const char *user = argc > 2 ? argv[2] : "root";
+    const char *passwd = argc > 3 ? argv[3] : "";
+    const char *name = argc > 4 ? argv[4] : "test";
+
+    int error = 0;
+    MysqlPool *pool = MysqlPool::get();
+    if (!pool->init(host, user, passwd, name, 3306, 4, 1, 1)) {
+        printf("init: no connection to %s\n", host);
+        printf("FAIL\n");
+        return 1;
+    }
+
+    MYSQL *sql = nullptr;
+    {
+        MysqlConnRAII conn(&sql, pool);
+        StmtCache *stmts = conn.stmts();
+        if (sql == nullptr || stmts == nullptr || \
+            mysql_query(sql, "create temporary table stmt_test(id bigint primary key, name varchar(2000))") != 0) {
+            printf("create table failed\n");
+            printf("FAIL\n");
+            return 1;
+        }
+
+        // 同一条语句只准备一次，参数不拼进 sql
+        std::string longName(1000, 'n');
+        const char *quoted = "x'); drop table stmt_test; --";
+        bool ok = insertRow(stmts, 1, "alice") && insertRow(stmts, 2, nullptr) && \
+                  insertRow(stmts, 3, longName.c_str()) && insertRow(stmts, 4, quoted);
+        MysqlStmt *insert = stmts->prepare("insert into stmt_test(id,name) values(?,?)");
+        if (!ok || insert == nullptr || stmts->prepares() != 1 || stmts->size() != 1 || insert->paramCount() != 2) {
+            printf("insert: ok %d, %llu prepares, %d cached\n", ok, (unsigned long long)stmts->prepares(), (int)stmts->size());
+            ++error;
+        }
+
+        // 逐行读取，NULL 列为 nullptr，超过默认缓冲区的字符串完整读出
+        MysqlStmt *select = stmts->prepare("select id,name from stmt_test order by id");
+        int rows = 0;
+        if (select == nullptr || !select->execute()) {
+            printf("select failed: %s\n", select ? select->error() : stmts->error());
+            ++error;
+        } else {
+            const char *expect[] = {"alice", nullptr, longName.c_str(), quoted};
+            while (select->fetch()) {
+                unsigned long len;
+                const char *value = select->getString(1, &len);
+                long long id = select->getInt(0);
+                bool same = id == rows + 1 && (expect[rows] == nullptr ? value == nullptr && select->isNull(1) : \
+                            value != nullptr && len == strlen(expect[rows]) && strcmp(value, expect[rows]) == 0);
+                if (!same) {
+                    printf("row %d: id %lld, name %.20s (%lu)\n", rows, id, value ? value : "NULL", len);
+                    ++error;
+                }
+                ++rows;
+            }
+            select->freeResult();
+        }
+        if (rows != 4) {
+            printf("select: %d rows\n", rows);
+            ++error;
+        }
+
+        // 带参数的查询多次执行复用同一条语句
+        MysqlStmt *byId = stmts->prepare("select id,name from stmt_test where id=?");
+        for (int id = 1; byId && id <= 4; ++id) {
+            byId->bindInt(0, id);
+            bool found = byId->execute() && byId->fetch() && byId->getInt(0) == id;
+            bool more = found && byId->fetch();
+            if (!found || more) {
+                printf("select id=%d: found %d, more %d\n", id, found, more);
+                ++error;
+            }
+        }
+        if (byId == nullptr || stmts->prepares() != 3) {
+            printf("select by id: %llu prepares\n", (unsigned long long)stmts->prepares());
+            ++error;
+        }
+
+        // 服务器返回的错误只影响这条语句，连接可以继续使用
+        if (stmts->prepare("select id from no_such_table") != nullptr || stmts->broken()) {
+            printf("bad statement accepted or connection marked broken\n");
+            ++error;
+        }
+    }
+
+    // 连接断开后重新连接，旧的语句已经不在服务器上，下一次使用时重新准备
+    MYSQL *raw = mysql_init(nullptr);
+    bool reconnect = true;
+    mysql_options(raw, MYSQL_OPT_RECONNECT, &reconnect);
+    MYSQL *killer = mysql_init(nullptr);
+    if (!mysql_real_connect(raw, host, user, passwd, name, 3306, nullptr, 0) || \
+        !mysql_real_connect(killer, host, user, passwd, name, 3306, nullptr, 0)) {
+        printf("raw connect failed\n");
+        ++error;
+    } else {
+        StmtCache *stmts = new StmtCache(raw);
+        const char *query = "select connection_id()";
+        MysqlStmt *stmt = stmts->prepare(query);
+        long before = stmt && stmt->execute() && stmt->fetch() ? stmt->getInt(0) : -1;
+
+        char kill[64];
+        snprintf(kill, sizeof(kill), "kill %ld", before);
+        queryValue(killer, kill);
+        mysql_ping(raw);
+
+        stmt = stmts->prepare(query);
+        long after = stmt && stmt->execute() && stmt->fetch() ? stmt->getInt(0) : -1;
+        if (before == -1 || after == -1 || after == before || stmts->prepares() != 2) {
+            printf("reconnect: id %ld -> %ld, %llu prepares\n", before, after, (unsigned long long)stmts->prepares());
+            ++error;
+        }
+        delete stmts;
+    }
+    mysql_close(killer);
+    mysql_close(raw);
+
+    // 语句执行时连接断开，归还后连接被关闭，之后取到的是新连接
+    MYSQL *victim = nullptr;
+    long victim_id = -1;
+    {
+        MysqlConnRAII conn(&victim, pool);
+        MYSQL *other = nullptr;
+        MysqlConnRAII killer_conn(&other, pool);
+        StmtCache *stmts = conn.stmts();
+        MysqlStmt *stmt = stmts ? stmts->prepare("select connection_id()") : nullptr;
+        victim_id = stmt && stmt->execute() && stmt->fetch() ? stmt->getInt(0) : -1;
+        char kill[64];
+        snprintf(kill, sizeof(kill), "kill %ld", victim_id);
+        queryValue(other, kill);
+        if (stmt == nullptr || stmt->execute() || !stmts->broken()) {
+            printf("statement on a killed connection did not mark it broken\n");
+            ++error;
+        }
+    }
+    // 最近归还的连接最先取出，如果断开的连接回到了池中，这里会取到它
+    long fresh_id = -1;
+    {
+        MYSQL *fresh = nullptr;
+        MysqlConnRAII conn(&fresh, pool);
+        fresh_id = queryValue(fresh, "select connection_id()");
+    }
+    if (victim_id == -1 || fresh_id == -1 || fresh_id == victim_id) {
+        printf("broken connection returned to the pool\n");
+        ++error;
+    }
+
+    pool->destroyMysqlConnect();
+
+    printf("%s\n", error == 0 ? "PASS" : "FAIL");
+    return error == 0 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "timerwheel.h"
+
+// 记录每个定时器实际触发的时间
+static uint64_t _now = 0;
+static int _fired = 0;
+static int _late = 0;
+
+static void onExpire(TimerNode *node, void *arg) {
+    uint64_t expect = (uint64_t)node->m_data;
+    // 定时器不能早到，最多晚一个 tick
+    if (_now < expect || _now > expect + TIMER_TICK_MS)
+        ++_late;
+    ++_fired;
+}
+
+int main() {
+    TimerWheel wheel(0, TIMER_TICK_MS);
+
+    // 覆盖第一层到最高层的各种到期时间
+    const int num = 100000;
+    std::vector<TimerNode> nodes(num);
+    srand(1);
+    for (int i = 0; i < num; ++i) {
+        uint64_t expire = (uint64_t)(rand() % 100000) * (i % 4 == 0 ? 100 : 1);
+        nodes[i].m_data = (void *)expire;
+        wheel.add(&nodes[i], expire);
+    }
+    printf("timers: %lu, first timeout: %d ms\n", wheel.size(), wheel.nextTimeout(0));
+
+    // 删除一半，剩下的应全部按时触发
+    for (int i = 0; i < num; i += 2)
+        wheel.remove(&nodes[i]);
+
+    while (wheel.size() > 0) {
+        int timeout = wheel.nextTimeout(_now);
+        _now += timeout > 0 ? timeout : TIMER_TICK_MS;
+        wheel.advance(_now, onExpire, nullptr);
+    }
+    printf("fired: %d (expect %d), early or late: %d\n", _fired, num / 2, _late);
+
+    // 回调中重新添加，模拟连接定时器的延长
+    TimerNode node;
+    node.m_data = (void *)(_now + 500);
+    wheel.add(&node, _now + 500);
+    wheel.modify(&node, _now + 1000);
+    node.m_data = (void *)(_now + 1000);
+    _fired = 0;
+    _late = 0;
+    for (int i = 0; i < 20; ++i) {
+        _now += TIMER_TICK_MS;
+        wheel.advance(_now, onExpire, nullptr);
+    }
+    printf("modified timer fired: %d, early or late: %d, empty timeout: %d\n", _fired, _late, wheel.nextTimeout(_now));
+
+    return 0;
+}